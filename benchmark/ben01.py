@@ -60,8 +60,11 @@ class Emitter(ff.MiSoNode):
 run_times_ms = []
 
 for i in range(NUM_RUNS):
+    emitter = Emitter()
+    # round trip of every task: stamped when emitted, recorded when fed back
+    emitter.set_latency(stamp=True, record=True)
     f = (ff.Farm()
-        .add_emitter(Emitter())
+        .add_emitter(emitter)
         .add_workers([ff.SiSoNode(native_mod.svc) for _ in range(NW)])
         # .add_workers([Worker() for _ in range(NW)])
         .add_collector(None)
@@ -77,7 +80,9 @@ for i in range(NUM_RUNS):
 
     elapsed_time_ms = (end_time - start_time) * 1000
     run_times_ms.append(elapsed_time_ms)
-    print(f"Run {i+1:02}: {elapsed_time_ms:.4f} ms")
+    lat = emitter.latency_stats()
+    print(f"Run {i+1:02}: {elapsed_time_ms:.4f} ms  "
+          f"(task latency p50 {lat['p50_us']:.1f} us, p99 {lat['p99_us']:.1f} us, p999 {lat['p999_us']:.1f} us)")
 
 avg_time_ms = statistics.mean(run_times_ms)
 std_dev_ms = statistics.stdev(run_times_ms) 
@@ -0,0 +1,73 @@
+import fftvm as ff
+import time
+import statistics
+import tvm_ffi
+
+# Farm vs StealingFarm on skewed synthetic workloads.
+# Each task carries its own cost (number of spin iterations); the skew
+# patterns mimic per-frame detection counts / variable-length sequences.
+
+NW = 4
+SIZE = 20000
+NUM_RUNS = 5
+
+cpp_source = '''
+#include <tvm/ffi/any.h>
+tvm::ffi::Any spin(tvm::ffi::Any in) {
+    int64_t cost = in.cast<int64_t>();
+    volatile int64_t i = 0;
+    while (i < cost) i = i + 1;
+    return cost;
+}
+'''
+
+native_mod = tvm_ffi.cpp.load_inline(
+        name="ben02_native", cpp_sources=cpp_source, functions=['spin'])
+
+WORKLOADS = {
+    "uniform":      lambda i: 2000,
+    "periodic-nw":  lambda i: 40000 if i % NW == 0 else 1000,   # worst case for round-robin
+    "heavy-tail":   lambda i: 100000 if i % 97 == 0 else 1000,
+    "bursty":       lambda i: 20000 if (i // 256) % 8 == 0 else 1000,
+}
+
+
+class Source(ff.SiSoNode):
+    def __init__(self, costs):
+        super().__init__()
+        self.costs = costs
+
+    def svc(self, task):
+        for c in self.costs:
+            self.ff_send_out(c)
+        return ff.FFToken.EOS()
+
+
+class Sink(ff.MiSoNode):
+    def svc(self, task):
+        return ff.FFToken.GO_ON()
+
+
+def make_farm(kind):
+    workers = [ff.SiSoNode(native_mod.spin) for _ in range(NW)]
+    if kind == "Farm":
+        return ff.Farm().add_workers(workers)
+    return ff.StealingFarm().add_workers(workers)
+
+
+def run(kind, costs):
+    times = []
+    for _ in range(NUM_RUNS):
+        wf = ff.Pipeline().add_stage(Source(costs)).add_stage(make_farm(kind)).add_stage(Sink())
+        start = time.perf_counter()
+        wf.run_and_wait_end()
+        times.append((time.perf_counter() - start) * 1000)
+    return statistics.mean(times), statistics.stdev(times)
+
+
+print(f"{'workload':<14}{'Farm (ms)':>20}{'StealingFarm (ms)':>24}{'speedup':>10}")
+for name, cost_fn in WORKLOADS.items():
+    costs = [cost_fn(i) for i in range(SIZE)]
+    farm_avg, farm_std = run("Farm", costs)
+    steal_avg, steal_std = run("StealingFarm", costs)
+    print(f"{name:<14}{farm_avg:>12.2f} ± {farm_std:<6.2f}{steal_avg:>16.2f} ± {steal_std:<6.2f}{farm_avg / steal_avg:>9.2f}x")
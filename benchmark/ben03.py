@@ -0,0 +1,52 @@
+import fftvm as ff
+import time
+import statistics
+import tvm_ffi
+import numpy as np
+
+# Throughput of a cross-group TCP edge (two processes on localhost) for
+# several payload sizes. The source re-sends the same Tensor; the sink drops
+# every task.
+
+NUM_RUNS = 3
+PAYLOADS = [64, 4 << 10, 64 << 10, 1 << 20, 8 << 20]
+TOTAL_BYTES = 512 << 20
+MAX_TASKS = 200000
+
+
+class Source(ff.SiSoNode):
+    def __init__(self, size, count):
+        super().__init__()
+        self.size = size
+        self.count = count
+
+    def svc(self, task):
+        t = tvm_ffi.from_dlpack(np.zeros(self.size, dtype=np.uint8))
+        for _ in range(self.count):
+            self.ff_send_out(t)
+        return ff.FFToken.EOS()
+
+
+class Sink(ff.SiSoNode):
+    def svc(self, task):
+        return ff.FFToken.GO_ON()
+
+
+def run(size):
+    count = min(MAX_TASKS, max(1, TOTAL_BYTES // size))
+    times = []
+    for _ in range(NUM_RUNS):
+        g = ff.distributed.Graph()
+        g.add_group("source", lambda: Source(size, count))
+        g.add_group("sink", lambda: Sink())
+        g.connect("source", "sink")
+        start = time.perf_counter()
+        g.run()
+        times.append(time.perf_counter() - start)
+    return count, statistics.mean(times), statistics.stdev(times)
+
+
+print(f"{'payload':>10}{'tasks':>10}{'time (ms)':>20}{'tasks/s':>14}{'MB/s':>10}")
+for size in PAYLOADS:
+    count, avg, std = run(size)
+    print(f"{size:>10}{count:>10}{avg * 1000:>12.2f} ± {std * 1000:<6.2f}{count / avg:>14.0f}{count * size / avg / 1e6:>10.1f}")
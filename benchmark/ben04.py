@@ -0,0 +1,40 @@
+import fftvm as ff
+import time
+import tvm_ffi
+import numpy as np
+
+# Wire codec throughput per type and payload size. Each value is encoded and
+# decoded ITERS times through ff.wire_encode / ff.wire_decode; the encode side
+# includes flattening into a Python bytes object (the TCP sender gathers large
+# payloads with writev instead), the decode side allocates tensors from the
+# codec's buffer pool.
+
+ITERS_BYTES = 256 << 20
+
+
+def cases():
+    for n in (16, 1 << 10, 64 << 10):
+        yield f"str[{n}]", "x" * n, n
+        yield f"bytes[{n}]", b"x" * n, n
+    for n in (8, 128, 4096):
+        yield f"array<int>[{n}]", list(range(n)), 8 * n
+        yield f"map<str,float>[{n}]", {f"k{i}": float(i) for i in range(n)}, 8 * n
+    for n in (64, 4 << 10, 256 << 10, 4 << 20, 64 << 20):
+        yield f"tensor[{n}]", tvm_ffi.from_dlpack(np.zeros(n, dtype=np.uint8)), n
+
+
+def bench(fn, arg, iters):
+    fn(arg)
+    start = time.perf_counter()
+    for _ in range(iters):
+        fn(arg)
+    return (time.perf_counter() - start) / iters
+
+
+print(f"{'case':<22}{'encoded':>12}{'encode us':>12}{'decode us':>12}{'enc MB/s':>11}{'dec MB/s':>11}")
+for name, value, payload in cases():
+    iters = max(10, min(100000, ITERS_BYTES // max(payload, 1) // 16))
+    blob = ff.wire_encode(value)
+    enc = bench(ff.wire_encode, value, iters)
+    dec = bench(ff.wire_decode, blob, iters)
+    print(f"{name:<22}{len(blob):>12}{enc * 1e6:>12.2f}{dec * 1e6:>12.2f}{payload / enc / 1e6:>11.1f}{payload / dec / 1e6:>11.1f}")
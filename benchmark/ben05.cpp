@@ -0,0 +1,110 @@
+#include <ff/ff.hpp>
+
+/*
+ * Round-trip latency baseline: one token bounced between two threads through
+ * FastFlow channels, reported as ns per hop (one channel traversal).
+ *
+ *   pipeline:  Ping ---> Pong        farm:   E (Ping) ---> W (Pong)
+ *               ^         |                  ^              |
+ *                ---------                    --------------
+ *
+ * The clock is read inside Ping, so thread start-up is not counted. Compare
+ * with ben05.py (the same graphs through fftvm).
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ff;
+
+static inline long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void pin(int cpu) {
+    if (cpu >= 0 && ff_mapThreadToCpu(cpu) != 0) std::cerr << "cannot pin to cpu " << cpu << "\n";
+}
+
+// The token is the number of bounces left.
+template <typename Base>
+struct Ping: Base {
+    Ping(long bounces, int cpu): bounces(bounces), cpu(cpu) {}
+    int svc_init() {
+        pin(cpu);
+        return 0;
+    }
+    long *svc(long *in) {
+        if (in == nullptr) {
+            start = now_ns();
+            return (long*)bounces;
+        }
+        long left = (long)in - 1;
+        if (left == 0) {
+            elapsed = now_ns() - start;
+            return this->EOS;
+        }
+        return (long*)left;
+    }
+    const long bounces;
+    const int cpu;
+    long start = 0, elapsed = 0;
+};
+
+template <typename Base>
+struct Pong: Base {
+    explicit Pong(int cpu): cpu(cpu) {}
+    int svc_init() {
+        pin(cpu);
+        return 0;
+    }
+    long *svc(long *in) { return in; }
+    const int cpu;
+};
+
+int main(int argc, char *argv[]) {
+    long bounces = 1000000;
+    bool blocking = false;
+    int cpu_a = -1, cpu_b = -1;
+
+    if (argc > 1) {
+        if (argc != 5)  {
+            std::cerr << "use: " << argv[0] << " bounces blocking(0|1) cpu_a cpu_b  (cpu -1 = not pinned)\n";
+            return -1;
+        }
+        bounces = std::stol(argv[1]);
+        blocking = std::stoi(argv[2]) != 0;
+        cpu_a = std::stoi(argv[3]);
+        cpu_b = std::stoi(argv[4]);
+    }
+
+    {
+        Ping<ff_minode_t<long>> ping(bounces, cpu_a);
+        Pong<ff_monode_t<long>> pong(cpu_b);
+        ff_pipeline pipe;
+        pipe.add_stage(&ping);
+        pipe.add_stage(&pong);
+        pipe.wrap_around();
+        pipe.blocking_mode(blocking);
+        pipe.no_mapping();
+        if (pipe.run_and_wait_end() < 0) return -1;
+        std::cout << "pipeline  " << double(ping.elapsed) / double(2 * bounces) << " ns/hop\n";
+    }
+    {
+        Ping<ff_node_t<long>> ping(bounces, cpu_a);
+        ff_farm farm;
+        farm.add_emitter(&ping);
+        std::vector<ff_node*> workers = {new Pong<ff_node_t<long>>(cpu_b)};
+        farm.add_workers(workers);
+        farm.cleanup_workers();
+        farm.remove_collector();
+        farm.wrap_around();
+        farm.blocking_mode(blocking);
+        farm.no_mapping();
+        if (farm.run_and_wait_end() < 0) return -1;
+        std::cout << "farm      " << double(ping.elapsed) / double(2 * bounces) << " ns/hop\n";
+    }
+    return 0;
+}
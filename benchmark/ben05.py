@@ -0,0 +1,133 @@
+import fftvm as ff
+import os
+import time
+import tvm_ffi
+
+# Round-trip latency: one token bounced between two nodes over a feedback
+# channel (pipeline Ping -> Pong wrapped around, and farm emitter -> one worker
+# wrapped around), reported as ns per hop. Covers native and Python callbacks,
+# spinning and blocking channels, and the two threads on the same core (SMT
+# siblings), on two cores of one socket, and across sockets. Start-up cost is
+# removed by timing BOUNCES and 2 * BOUNCES bounces and taking the difference.
+# The raw FastFlow baseline is ben05.cpp (make; build/ben05 bounces blocking cpu_a cpu_b).
+
+NUM_RUNS = 3
+BOUNCES = {"native": 100000, "python": 10000}
+
+cpp_source = '''
+#include <tvm/ffi/any.h>
+#include <tvm/ffi/function.h>
+
+// The token is the number of bounces left; ben05.bounces / ben05.eos are
+// registered by the script.
+tvm::ffi::Any ping(tvm::ffi::Any t) {
+    if (t.type_index() == TVMFFITypeIndex::kTVMFFINone) {
+        return tvm::ffi::Function::GetGlobalRequired("ben05.bounces")();
+    }
+    int64_t left = t.cast<int64_t>() - 1;
+    if (left == 0) return tvm::ffi::Function::GetGlobalRequired("ben05.eos")();
+    return left;
+}
+
+tvm::ffi::Any pong(tvm::ffi::Any t) {
+    return t;
+}
+'''
+
+native_mod = tvm_ffi.cpp.load_inline(
+        name="ben05_native", cpp_sources=cpp_source, functions=['ping', 'pong'])
+
+bounces = [0]
+tvm_ffi.register_global_func("ben05.bounces", lambda: bounces[0], override=True)
+tvm_ffi.register_global_func("ben05.eos", lambda: ff.FFToken.EOS(), override=True)
+
+
+def pin(cpu):
+    if cpu >= 0:
+        os.sched_setaffinity(0, {cpu})  # 0 = the calling (node) thread
+
+
+class NativePing(ff.MiSoNode):
+    svc = native_mod.ping
+    def svc_init(self):
+        pin(self.cpu)
+        return 0
+
+class NativePong(ff.SiMoNode):
+    svc = native_mod.pong
+    def svc_init(self):
+        pin(self.cpu)
+        return 0
+
+class PyPing(ff.MiSoNode):
+    def svc_init(self):
+        pin(self.cpu)
+        return 0
+    def svc(self, t):
+        if t is None:
+            return bounces[0]
+        return t - 1 if t > 1 else ff.FFToken.EOS()
+
+class PyPong(ff.SiMoNode):
+    def svc_init(self):
+        pin(self.cpu)
+        return 0
+    def svc(self, t):
+        return t
+
+
+def pipeline(ping, pong, blocking):
+    return ff.Pipeline().add_stage(ping).add_stage(pong).wrap_around().blocking_mode(blocking)
+
+def farm(ping, pong, blocking):
+    return ff.Farm().add_emitter(ping).add_workers([pong]).add_collector(None).wrap_around().blocking_mode(blocking)
+
+
+def placements():
+    """(cpu_a, cpu_b) for each placement available to this process."""
+    def read(cpu, what):
+        with open(f"/sys/devices/system/cpu/cpu{cpu}/topology/{what}") as f:
+            return int(f.read())
+    cpus = sorted(os.sched_getaffinity(0))
+    where = {c: (read(c, "physical_package_id"), read(c, "core_id")) for c in cpus}
+    found = {"unpinned": (-1, -1)}
+    for a in cpus:
+        for b in cpus:
+            if a == b:
+                continue
+            if where[a] == where[b]:
+                found.setdefault("same-core", (a, b))
+            elif where[a][0] == where[b][0]:
+                found.setdefault("same-socket", (a, b))
+            else:
+                found.setdefault("cross-socket", (a, b))
+    return found
+
+
+def elapsed(graph, ping_cls, pong_cls, blocking, cpus, n):
+    best = float("inf")
+    for _ in range(NUM_RUNS):
+        bounces[0] = n
+        ping, pong = ping_cls(), pong_cls()
+        ping.cpu, pong.cpu = cpus
+        g = graph(ping, pong, blocking)
+        start = time.perf_counter_ns()
+        g.run_and_wait_end()
+        best = min(best, time.perf_counter_ns() - start)
+    return best
+
+
+NODES = {"native": (NativePing, NativePong), "python": (PyPing, PyPong)}
+
+print(f"{'graph':<10}{'callbacks':<10}{'channels':<10}{'placement':<14}{'cpus':>8}{'ns/hop':>12}")
+for graph in (pipeline, farm):
+    for callbacks, (ping_cls, pong_cls) in NODES.items():
+        for blocking in (False, True):
+            for placement, cpus in placements().items():
+                n = BOUNCES[callbacks]
+                t1 = elapsed(graph, ping_cls, pong_cls, blocking, cpus, n)
+                t2 = elapsed(graph, ping_cls, pong_cls, blocking, cpus, 2 * n)
+                hop_ns = max(0, t2 - t1) / (2 * n)
+                mode = "blocking" if blocking else "spinning"
+                where = "-" if cpus[0] < 0 else f"{cpus[0]},{cpus[1]}"
+                print(f"{graph.__name__:<10}{callbacks:<10}{mode:<10}{placement:<14}{where:>8}{hop_ns:>12.1f}")
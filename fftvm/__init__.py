@@ -2,6 +2,8 @@ import tvm_ffi
 import os
 import glob
 import inspect
+import textwrap
+import json
 
 current_dir = os.path.dirname(os.path.realpath(__file__))
 
@@ -19,7 +21,32 @@ class FFToken(tvm_ffi.Object):
     def __init__(self):
         self.__ffi_init__()
 
+# Arity word of the native nodes (node_call in libfftvm.cpp).
+_SVC_TASK, _SVC_SELF_TASK, _SVC_NO_ARGS = 1, 2, 3
+_INIT_BOUND, _END_BOUND, _EOS_BOUND, _EOS_WITH_ID = 1 << 8, 1 << 9, 1 << 10, 1 << 11
+
 class _baseNodeMixin:
+    @staticmethod
+    def _positional_args(cls, name):
+        """Positional parameters of method `name` after `self` (inf with *args), None if it is not a plain method."""
+        method = inspect.getattr_static(cls, name)
+        if not inspect.isfunction(method):
+            return None
+        try:
+            params = list(inspect.signature(method).parameters.values())
+        except ValueError:
+            return None
+        positional = (inspect.Parameter.POSITIONAL_ONLY, inspect.Parameter.POSITIONAL_OR_KEYWORD)
+        if not params or params[0].kind not in positional:
+            return None
+        count = 0
+        for param in params[1:]:
+            if param.kind in positional:
+                count += 1
+            elif param.kind == inspect.Parameter.VAR_POSITIONAL:
+                return float('inf')
+        return count
+
     @staticmethod
     def _create_safe_wrapper(instance, method):
         if not inspect.isfunction(method) and not inspect.ismethod(method):
@@ -75,55 +102,192 @@ class _baseNodeMixin:
                 cls = type(self)
 
 
-                def get_val(attr_name):
+                # Plain methods are passed bound, with their arity in the
+                # `svc_num_args` word (node_call in libfftvm.cpp): the node then
+                # calls them directly, with no wrapper frame per task.
+                flags = 0
+
+                def get_val(attr_name, bound_flag):
+                    nonlocal flags
                     if not hasattr(cls, attr_name):
-                        return None
+                        return None, 0
                     val = getattr(cls, attr_name)
                     # Logic: If it's a native FFI function, use it directly; otherwise, wrap it.
                     if type(val) == tvm_ffi.core.Function:
-                        return val
-                    return _baseNodeMixin._create_safe_wrapper(self, val)
+                        return val, None
+                    nargs = _baseNodeMixin._positional_args(cls, attr_name)
+                    if nargs is None:
+                        return _baseNodeMixin._create_safe_wrapper(self, val), None
+                    flags |= bound_flag
+                    return getattr(self, attr_name), nargs
 
-                svc       = get_val('svc')
-                svc_init  = get_val('svc_init')
-                svc_end   = get_val('svc_end')
-                eosnotify = get_val('eosnotify')
+                svc, svc_nargs = get_val('svc', 0)
+                svc_init, _    = get_val('svc_init', _INIT_BOUND)
+                svc_end, _     = get_val('svc_end', _END_BOUND)
+                eosnotify, eos_nargs = get_val('eosnotify', _EOS_BOUND)
+                if eos_nargs:
+                    flags |= _EOS_WITH_ID
 
                 # Calculate svc_num_args
-                svc_num_args = 0
-                if svc is not None:
-                    if type(svc) == tvm_ffi.core.Function:
-                        svc_num_args = 1 
-                    else:
-                        # It is a wrapped python function
-                        sig = inspect.signature(getattr(cls, 'svc'))
-                        params = list(sig.parameters.values())
-                        if len(params) > 0 and params[0].name == 'self':
-                            svc_num_args = 2
-                        else:
-                            svc_num_args = 1
+                if type(svc) == tvm_ffi.core.Function:
+                    svc_num_args = _SVC_TASK
+                elif svc_nargs is None:
+                    # It is a wrapped python callable
+                    svc_num_args = _SVC_SELF_TASK
+                else:
+                    svc_num_args = _SVC_NO_ARGS if svc_nargs == 0 else _SVC_TASK
+                svc_num_args |= flags
 
             self.__ffi_init__(svc, svc_num_args, svc_init, svc_end, eosnotify)
+class _lanesMixin:
+    def set_lanes(self, lanes=2, window=256, starvation_limit=64, classifier=None, edf=False):
+        """Holds waiting input in `lanes` priority lanes (highest served first).
+
+        A task's lane is the priority given to `ff_send_out_prio` (inherited by
+        the tasks derived from it), or the value returned by `classifier(task)`.
+        At most `window` tasks are held; a lane skipped `starvation_limit` times
+        is served next (0 disables the protection). With `edf=True` each lane
+        serves the earliest deadline first. Per-lane wait times are in
+        `lane_stats()`. Tasks are received as usual (blocking mode included);
+        multi-input nodes only reorder what waits on upstream nodes with a
+        single output channel.
+        """
+        return self.configure_lanes(lanes, window, starvation_limit, edf, classifier)
+
+
+class _expiryMixin:
+    def set_expiry(self, mode="drop", divert=None):
+        """Handles tasks past their deadline (see `ff_send_out_deadline`) before `svc`.
+
+        `mode="drop"` discards them, `mode="divert"` calls `divert(task)` instead
+        of `svc` and forwards its result unless it is None, `mode="none"`
+        disables the check. Counters are in `expiry_stats()`.
+        """
+        return self.configure_expiry(mode, divert)
+
+
+class _vectorMixin:
+    def set_vectorized(self, max_batch=1024, dtype="int64", fn=None):
+        """Calls svc once per batch of scalar tasks, passed as a NumPy array.
+
+        Consecutive int/float tasks (up to `max_batch`, or as many as were
+        queued) are gathered into a contiguous 1-D `dtype` ("int64" or
+        "float64") buffer, exposed through DLPack without a copy. A returned
+        array is exploded back into one task per element (an array of one
+        element per task gives each the metadata of its task: deadline,
+        priority, latency stamp); any other result is sent as a single task.
+        Expired tasks are handled by `set_expiry` before batching. Other tasks flush the batch and reach `svc` one
+        at a time as usual. `fn` defaults to the node's own `svc` (needed for
+        nodes built from a function); native functions get the tensor itself.
+        `max_batch=0` turns batching off; counters are in `vector_stats()`.
+        """
+        if fn is None:
+            fn = getattr(type(self), "svc", None)
+            if fn is None:
+                raise ValueError("set_vectorized needs `fn` for nodes built from a function")
+            if type(fn) != tvm_ffi.core.Function:
+                fn = getattr(self, "svc")
+        if type(fn) != tvm_ffi.core.Function:
+            import numpy as np
+            py_fn = fn
+
+            def fn(batch):
+                out = py_fn(np.from_dlpack(batch))
+                if isinstance(out, np.ndarray):
+                    return tvm_ffi.from_dlpack(np.ascontiguousarray(out).reshape(-1))
+                return out
+        return self.configure_vectorized(max_batch, dtype, fn)
+
+
+class _latencyMixin:
+    def set_latency(self, stamp=False, record=False):
+        """End-to-end latency measurement.
+
+        With `stamp=True` the tasks this node emits carry its current time
+        (tasks derived from stamped ones keep the original stamp, across farm
+        and A2A hops). With `record=True` the node records, for every stamped
+        task it consumes, the time from the stamp to the end of its `svc`;
+        `latency_stats()` gives count, mean, p50/p90/p99/p999 and max in
+        microseconds, `reset_latency()` clears them.
+        """
+        return self.configure_latency(stamp, record)
+
+
+class _perfMixin:
+    def set_perf_counters(self, mode="svc"):
+        """Hardware counters of the node's thread, through perf_event_open.
+
+        `mode="svc"` counts only the work done inside svc (two syscalls per
+        task), `mode="thread"` the whole thread lifetime (read once, at the
+        end), `mode="off"` disables them. `perf_stats()` gives cycles,
+        instructions, llc_misses, branches, branch_misses and context_switches
+        with the derived ipc, llc_mpki (LLC misses per 1000 instructions) and
+        branch_miss_rate; `error` explains counters the kernel refused.
+        """
+        return self.configure_perf(mode)
+
+
+class _budgetMixin:
+    def set_byte_budget(self, budget, edge_limit=0, name=""):
+        """Charges the payload of every task this node emits to `budget` (a `ByteBudget`).
+
+        Tensor data, str/bytes and their sizes inside lists and dicts count, from
+        the moment the task is allocated until its consumer is done with it. The
+        node blocks while the budget's limit, or `edge_limit` bytes on its own
+        output edge (0 = none), would be exceeded; an edge with nothing in
+        flight always admits one task. `budget.stats()` reports the bytes in
+        flight per edge, listed under `name` (default "edge<i>").
+        """
+        return self.configure_byte_budget(budget, edge_limit, name)
+
+
+class _routingMixin:
+    def set_routing(self, strategy="round_robin", fn=None):
+        """Picks the output channel of every task this node emits, natively.
+
+        `strategy` is "round_robin", "key_hash" (tasks with equal keys always
+        go to the same channel; the key is `fn(task)`, or the task itself),
+        "function" (`fn(task)` returns the channel index), "broadcast" (a copy
+        of the task to every channel) or "default" (FastFlow's own policy).
+        Applies to returned tasks and to `ff_send_out`; `ff_send_out_to` and
+        tokens are not routed. `routing_stats()` gives the tasks sent per channel.
+        """
+        return self.configure_routing(strategy, fn)
+
+
+@tvm_ffi.register_object("fftvm.ByteBudget")
+class ByteBudget(tvm_ffi.Object):
+    """Bound on the bytes of payload in flight, shared by the nodes attached to it.
+
+    `limit` is graph-wide (0 leaves only the per-edge limits). `stats()` gives
+    the limit, the bytes in flight and their peak, and for every edge its name,
+    limit, in_flight, peak, tasks, and how many times (and how long, `wait_ms`)
+    its producer blocked.
+    """
+    def __init__(self, limit=0):
+        self.__ffi_init__(limit)
+
+
 @tvm_ffi.register_object("fftvm.SiSoNode")
-class SiSoNode(_baseNodeMixin, tvm_ffi.Object):
+class SiSoNode(_lanesMixin, _expiryMixin, _latencyMixin, _perfMixin, _vectorMixin, _budgetMixin, _baseNodeMixin, tvm_ffi.Object):
     def __init__(self, svc=None, svc_init=None, svc_end=None, eosnotify=None):
         # Explicitly call the Mixin's init to ensure it runs
         _baseNodeMixin.__init__(self, svc, svc_init, svc_end, eosnotify)
  
 @tvm_ffi.register_object("fftvm.SiMoNode")
-class SiMoNode(_baseNodeMixin, tvm_ffi.Object):
+class SiMoNode(_lanesMixin, _expiryMixin, _latencyMixin, _perfMixin, _vectorMixin, _budgetMixin, _routingMixin, _baseNodeMixin, tvm_ffi.Object):
     def __init__(self, svc=None, svc_init=None, svc_end=None, eosnotify=None):
         # Explicitly call the Mixin's init to ensure it runs
         _baseNodeMixin.__init__(self, svc, svc_init, svc_end, eosnotify)
 
 @tvm_ffi.register_object("fftvm.MiSoNode")
-class MiSoNode(_baseNodeMixin, tvm_ffi.Object):
+class MiSoNode(_lanesMixin, _expiryMixin, _latencyMixin, _perfMixin, _budgetMixin, _baseNodeMixin, tvm_ffi.Object):
     def __init__(self, svc=None, svc_init=None, svc_end=None, eosnotify=None):
         # Explicitly call the Mixin's init to ensure it runs
         _baseNodeMixin.__init__(self, svc, svc_init, svc_end, eosnotify)
 
 @tvm_ffi.register_object("fftvm.MiMoNode")
-class MiMoNode(_baseNodeMixin, tvm_ffi.Object):
+class MiMoNode(_lanesMixin, _expiryMixin, _routingMixin, _baseNodeMixin, tvm_ffi.Object):
     def __init__(self, svc=None, svc_init=None, svc_end=None, eosnotify=None):
         # Explicitly call the Mixin's init to ensure it runs
         _baseNodeMixin.__init__(self, svc, svc_init, svc_end, eosnotify)
@@ -135,18 +299,312 @@ class Pipeline(tvm_ffi.Object):
         self.__ffi_init__()
 
 
+@tvm_ffi.register_object("fftvm.Loop")
+class Loop(tvm_ffi.Object):
+    """Iterative loop running natively: `body` (a node or a list of stages) wrapped around.
+
+    A task leaves the loop, forwarded to the next stage, when
+    `converged(task)` is true or after `max_iterations` trips through the body
+    (0 = no limit); otherwise it goes around again. The trip count travels
+    with the task. EOS is sent once upstream has ended and the last task has
+    left; the body must turn every task into exactly one task. A body stage
+    filtering a task out (returning GO_ON without sending one) or dropping it
+    as expired fails the graph rather than leaving the loop waiting for it.
+    Counters (entered, iterations, converged, exhausted, in_flight) are in
+    `stats()`.
+    """
+    def __init__(self, body, max_iterations=0, converged=None):
+        if not isinstance(body, (list, tuple)):
+            body = [body]
+        self.__ffi_init__(list(body), max_iterations, converged)
+
+
 @tvm_ffi.register_object("fftvm.Farm")
 class Farm(tvm_ffi.Object):
     def __init__(self):
         self.__ffi_init__()
 
 
+@tvm_ffi.register_object("fftvm.ElasticFarm")
+class ElasticFarm(tvm_ffi.Object):
+    """Farm that freezes/thaws workers of a fixed pool depending on load.
+
+    Scaling is driven by the average backlog (tasks dispatched but not yet
+    collected) of the active workers and by the fraction of them that are busy,
+    sampled every `interval_ms` (also while no task arrives, so an idle farm
+    scales down). A decision is taken only after `hysteresis` consecutive
+    samples agree. At most `max_workers` workers are active (0: all of them).
+    With `blocking=True` inactive workers sleep instead of spinning on their
+    empty channel.
+    """
+    def __init__(self, min_workers=1, scale_up_backlog=4.0, scale_down_backlog=0.5,
+                 scale_down_utilization=0.5, hysteresis=3, interval_ms=10,
+                 max_workers=0, blocking=True):
+        self.__ffi_init__(min_workers, scale_up_backlog, scale_down_backlog,
+                          scale_down_utilization, hysteresis, interval_ms,
+                          max_workers, blocking)
+
+
+@tvm_ffi.register_object("fftvm.StealingFarm")
+class StealingFarm(tvm_ffi.Object):
+    """Work-stealing farm: workers own local deques and steal from peers when empty.
+
+    Workers must be `SiSoNode` instances (subclasses or native functions).
+    Their expiry, latency, perf counter and byte budget settings are kept;
+    workers with priority lanes or a vectorized svc are rejected.
+    """
+    def __init__(self):
+        self.__ffi_init__()
+
+
+@tvm_ffi.register_object("fftvm.InterpreterNode")
+class InterpreterNode(tvm_ffi.Object):
+    """SiSo node running Python code in its own interpreter, so it does not share the GIL.
+
+    `code` is Python source defining `entry(task)` (and optionally
+    `svc_init()`/`svc_end()`), or a top-level function, whose source is used.
+    The code runs in a subinterpreter with its own GIL (CPython >= 3.12,
+    `own_gil=True`), attached without a GIL on free-threaded builds, and under
+    the shared GIL otherwise; `stats()["mode"]` tells which. It cannot see the
+    caller's globals and can only import modules that support subinterpreters.
+
+    Tasks arrive as Python values; tensors as memoryviews over their data, valid
+    during the call. Returning such a memoryview forwards the tensor without a
+    copy. `ff_send_out(task)`, `GO_ON` and `EOS` are predefined.
+    """
+    def __init__(self, code, entry="svc", own_gil=True):
+        if callable(code):
+            entry = code.__name__
+            code = inspect.getsource(code)
+        self.__ffi_init__(textwrap.dedent(code), entry, own_gil)
+
+
+@tvm_ffi.register_object("fftvm.EdfEmitter")
+class EdfEmitter(tvm_ffi.Object):
+    """Native farm emitter dispatching the earliest deadline first.
+
+    Tasks waiting for a worker are kept in a window of up to `window` tasks
+    ordered by deadline; expired ones are dropped when `drop_expired`. Pair it
+    with `Farm.set_scheduling_ondemand(1)` so tasks wait here rather than in
+    the workers' queues.
+    """
+    def __init__(self, window=1024, drop_expired=True):
+        self.__ffi_init__(window, drop_expired)
+
+
 @tvm_ffi.register_object("fftvm.A2A")
 class A2A(tvm_ffi.Object):
     def __init__(self):
         self.__ffi_init__()
 
 
+@tvm_ffi.register_object("fftvm.NativeNode")
+class NativeNode(tvm_ffi.Object):
+    """Node backed by a native FastFlow node, e.g. a typed C++ stage.
+
+    Built from C++ only (see `typed` in libfftvm.hpp); it can be added to any
+    Pipeline or Farm.
+    """
+
+
+@tvm_ffi.register_object("fftvm.PluginNode")
+class PluginNode(tvm_ffi.Object):
+    """SiSo node implemented by a shared library through the C plugin ABI (fftvm_plugin.h).
+
+    `symbol` is the library's entry point; `config` (a string, or anything
+    JSON-serializable) is handed to the plugin's `create`. The plugin gets the
+    task pointers directly, with no packed call per task.
+    """
+    def __init__(self, path, symbol, config=""):
+        if not isinstance(config, str):
+            config = json.dumps(config)
+        self.__ffi_init__(str(path), symbol, config)
+
+    @classmethod
+    def load(cls, path, symbol, config=""):
+        return cls(path, symbol, config)
+
+
+@tvm_ffi.register_object("fftvm.Window")
+class Window(tvm_ffi.Object):
+    """Native windowed aggregation (multi-input, so it can also gather a farm).
+
+    Tasks are grouped by `key(task)` and `value(task)` (the task itself by
+    default) is reduced over windows of `size` tasks of a key (`kind="count"`)
+    or `size` milliseconds (`kind="time"`, on the event time `time(task)` in
+    ms, or the arrival time), starting every `slide` (default `size`:
+    tumbling). `reduce` is "count", "sum", "min", "max", "mean", "tensor_sum"
+    (elementwise, as float64) or a function `fn(acc, value) -> acc` with acc
+    None at first. Each window is emitted as a dict with key, start, end,
+    count and value; open windows are emitted at end of stream. `stats()`
+    counts tasks, windows and late tasks.
+    """
+    def __init__(self, size, slide=0, kind="count", key=None, value=None, reduce="count", time=None):
+        reducer = None
+        if not isinstance(reduce, str):
+            reduce, reducer = "custom", reduce
+        self.__ffi_init__(kind, size, slide, key, value, reduce, reducer, time)
+
+
+@tvm_ffi.register_object("fftvm.ParallelFor")
+class ParallelFor(tvm_ffi.Object):
+    """FastFlow parallel-for with its own `num_workers` threads (0 = one per core).
+
+    Meant to be owned by a node that splits a heavy task over index ranges:
+    `body(start, stop, thread_id)` runs on chunks of `range(first, last,
+    step)`, `chunk` indices each (0 = one block per worker). Native kernels
+    run truly in parallel; Python bodies take the GIL. With `spinwait=True`
+    the workers spin between loops (lower latency, busy cores). Native code
+    can use the global functions `fftvm.parallel_for` / `fftvm.parallel_reduce`
+    with the same arguments. `stats()` counts loops and chunks.
+    """
+    def __init__(self, num_workers=0, spinwait=False):
+        self.__ffi_init__(num_workers, spinwait)
+
+    def parallel_for(self, first, last, body, step=1, chunk=0):
+        self.run_range(first, last, step, chunk, body)
+
+    def parallel_reduce(self, first, last, body, combine, identity=0, step=1, chunk=0):
+        """Folds the results of `body(start, stop, thread_id)` with `combine(a, b)`."""
+        return self.reduce_range(first, last, step, chunk, identity, body, combine)
+
+
+@tvm_ffi.register_object("fftvm.Ticket")
+class Ticket(tvm_ffi.Object):
+    """Pending result of a task submitted to an `Injector`."""
+    def result(self, timeout=None):
+        """Waits (GIL released) for the result; raises if the graph ended without one or on timeout (seconds)."""
+        return self.wait_result(-1 if timeout is None else int(timeout * 1000))
+
+
+@tvm_ffi.register_object("fftvm.InjectorResults")
+class InjectorResults(tvm_ffi.Object):
+    """Last stage of an `Injector`'s graph (see `Injector.results`)."""
+
+
+@tvm_ffi.register_object("fftvm.Injector")
+class Injector(tvm_ffi.Object):
+    """Multi-producer entry point of a graph (first stage or farm emitter).
+
+    Any number of threads can `submit(task)` concurrently while the graph
+    runs; each call returns a `Ticket` completed with the first result derived
+    from the task that reaches `results()`, the node to use as the last stage
+    (or the farm's collector). `close()` ends the stream once the queued
+    tasks are injected. `stats()` counts submitted, injected, completed,
+    unmatched (results of no pending ticket) and failed tickets.
+    """
+    def __init__(self):
+        self.__ffi_init__()
+
+    def submit(self, task, want_result=True):
+        return self.submit_task(task, want_result)
+
+
+@tvm_ffi.register_object("fftvm.MmapSource")
+class MmapSource(_budgetMixin, tvm_ffi.Object):
+    """Native source emitting fixed-shape records of a memory-mapped file or directory.
+
+    Records are zero-copy `Tensor` views into the mapping, which stays alive as
+    long as any of them does. For `.npy` files `record_shape` and `dtype`
+    default to the file's `shape[1:]` and dtype.
+    """
+    def __init__(self, path, record_shape=None, dtype=None, readahead=64, header_bytes=0):
+        self.__ffi_init__(str(path), list(record_shape or []), dtype or "", readahead, header_bytes)
+
+
+@tvm_ffi.register_object("fftvm.FileReader")
+class FileReader(tvm_ffi.Object):
+    """Native source streaming a file (or a directory) in chunks with reads in flight.
+
+    Chunks are emitted in order as 1-D uint8 `Tensor`s backed by pooled buffers
+    (`output="bytes"` copies them into `bytes` instead). The number of reads in
+    flight adapts between `min_inflight` and `max_inflight`. The pool holds
+    `2 * max_inflight` buffers: downstream must release the tensors, and the
+    reader fails if it holds all of them for `stall_timeout_ms` (`None` waits
+    forever, e.g. for a sink that keeps chunks on purpose).
+    """
+    def __init__(self, path, chunk_size=1 << 20, min_inflight=2, max_inflight=16, output="tensor",
+                 stall_timeout_ms=60000):
+        if output not in ("tensor", "bytes"):
+            raise ValueError("output must be 'tensor' or 'bytes'")
+        if stall_timeout_ms is None:
+            stall_timeout_ms = -1
+        self.__ffi_init__(str(path), chunk_size, min_inflight, max_inflight, output == "bytes", stall_timeout_ms)
+
+
+def _shm_name(name):
+    return name if name.startswith("/") else "/" + name
+
+
+@tvm_ffi.register_object("fftvm.ShmSink")
+class ShmSink(tvm_ffi.Object):
+    """Native sink publishing tasks to a POSIX shared-memory segment for a `ShmSource`.
+
+    Tasks cross a lock-free ring of `ring_slots` descriptors; `Tensor` (CPU,
+    contiguous) payloads and large `str`/`bytes` are copied into an
+    `arena_size`-byte shared arena. Containers (Array, Map, Shape) are encoded
+    with the wire codec.
+    """
+    def __init__(self, name, ring_slots=1024, slot_size=256, arena_size=64 << 20):
+        self.__ffi_init__(_shm_name(name), ring_slots, slot_size, arena_size)
+
+
+@tvm_ffi.register_object("fftvm.ShmSource")
+class ShmSource(tvm_ffi.Object):
+    """Native source attaching to the segment of a `ShmSink` (possibly in another process).
+
+    Tensors are emitted as zero-copy views into the shared arena; the producer
+    reuses their space once they are released, so hold on to them only as long
+    as needed (copy them otherwise).
+    """
+    def __init__(self, name, timeout_ms=5000):
+        self.__ffi_init__(_shm_name(name), timeout_ms)
+
+
+# Native wire codec used by the cross-process edges. wire_encode accepts None,
+# bool, int, float, str, bytes, Shape, Array, Map and CPU Tensors (nested);
+# wire_decode allocates decoded tensors from a buffer pool.
+wire_encode = tvm_ffi.get_global_func("fftvm.wire_encode")
+wire_decode = tvm_ffi.get_global_func("fftvm.wire_decode")
+
+
+@tvm_ffi.register_object("fftvm.TcpSender")
+class TcpSender(tvm_ffi.Object):
+    """Native sink shipping tasks to one or more `TcpReceiver`s ("host:port" endpoints).
+
+    Tasks are sent in batches of up to `batch_size` tasks / `batch_bytes` bytes;
+    a partial batch is flushed as soon as the input channel is empty. With
+    several endpoints, batches are dealt round-robin.
+    """
+    def __init__(self, endpoints, batch_size=256, batch_bytes=1 << 20, connect_timeout_ms=10000):
+        if isinstance(endpoints, str):
+            endpoints = [endpoints]
+        self.__ffi_init__(list(endpoints), batch_size, batch_bytes, connect_timeout_ms)
+
+
+@tvm_ffi.register_object("fftvm.TcpReceiver")
+class TcpReceiver(tvm_ffi.Object):
+    """Native source accepting `num_senders` `TcpSender`s on host:port.
+
+    Emits the received tasks until every sender has sent its end of stream; a
+    sender closing its connection without one fails the node. With `port=0`
+    a free port is chosen; `port()` returns it.
+    """
+    def __init__(self, host="127.0.0.1", port=0, num_senders=1, timeout_ms=10000):
+        self.__ffi_init__(host, port, num_senders, timeout_ms)
+
+
+# Declarative topologies: a tree of dicts (or its JSON text) naming native
+# functions per node, instantiated natively in one call. See `topology` in
+# libfftvm.cpp for the format. build_topology(spec) and load_topology(path)
+# return the root Pipeline/Farm/A2A; save_topology(spec, path) writes the JSON;
+# run_topology(path) loads and runs a saved graph to the end.
+build_topology = tvm_ffi.get_global_func("fftvm.build_topology")
+load_topology = tvm_ffi.get_global_func("fftvm.load_topology")
+save_topology = tvm_ffi.get_global_func("fftvm.save_topology")
+run_topology = tvm_ffi.get_global_func("fftvm.run_topology")
+
+
 # @tvm_ffi.register_object("fftvm.Sink")
 # class Sink(tvm_ffi.Object):
 #     def __init__(self, fn):
@@ -163,3 +621,6 @@ class A2A(tvm_ffi.Object):
 # class Source(tvm_ffi.Object):
 #     def __init__(self, fn):
 #         self.__ffi_init__(fn)
+
+
+from . import distributed  # noqa: E402
@@ -0,0 +1,94 @@
+"""Process groups connected by TCP edges.
+
+A `Graph` is a set of named groups, each one a sub-graph built by a function
+returning a node (any topology), plus the edges between them. Every group
+runs in its own process: a `TcpReceiver` is prepended to groups with
+predecessors and a `TcpSender` (round-robin over the successors) is appended
+to groups with successors. A pipeline split across processes is a chain of
+groups; an all-to-all is every left group connected to every right group.
+
+    g = Graph()
+    g.add_group("read", lambda: Reader())
+    g.add_group("infer", lambda: ff.Farm().add_workers([Model() for _ in range(4)]))
+    g.connect("read", "infer")
+    g.run()                  # one process per group on this host
+    # or, on each host:      g.run_group("infer")
+
+Groups are built inside their own process, after the fork.
+"""
+import multiprocessing as mp
+import socket
+
+import fftvm as ff
+
+
+class Group:
+    def __init__(self, name, build, host, port):
+        self.name = name
+        self.build = build
+        self.host = host
+        self.port = port
+        self.preds = []
+        self.succs = []
+
+
+class Graph:
+    def __init__(self, batch_size=256, batch_bytes=1 << 20, timeout_ms=10000):
+        self.groups = {}
+        self.batch_size = batch_size
+        self.batch_bytes = batch_bytes
+        self.timeout_ms = timeout_ms
+
+    def add_group(self, name, build, host="127.0.0.1", port=0):
+        if name in self.groups:
+            raise ValueError(f"group '{name}' already exists")
+        self.groups[name] = Group(name, build, host, port)
+        return self
+
+    def connect(self, src, dst):
+        if src == dst:
+            raise ValueError("a group cannot be connected to itself")
+        self.groups[src].succs.append(self.groups[dst])
+        self.groups[dst].preds.append(self.groups[src])
+        return self
+
+    def build(self, name):
+        """Returns the local graph of group `name` with its TCP edges attached."""
+        g = self.groups[name]
+        pipe = ff.Pipeline()
+        if g.preds:
+            if g.port == 0:
+                raise ValueError(f"group '{name}' receives from other groups and needs a port")
+            pipe.add_stage(ff.TcpReceiver(g.host, g.port, len(g.preds), self.timeout_ms))
+        pipe.add_stage(g.build())
+        if g.succs:
+            endpoints = [f"{s.host}:{s.port}" for s in g.succs]
+            pipe.add_stage(ff.TcpSender(endpoints, self.batch_size, self.batch_bytes, self.timeout_ms))
+        return pipe
+
+    def run_group(self, name):
+        self.build(name).run_and_wait_end()
+
+    def run(self):
+        """Runs every group in a separate process on this host and waits for all of them."""
+        for g in self.groups.values():
+            if g.preds and g.port == 0:
+                g.port = _free_port(g.host)
+
+        ctx = mp.get_context("fork")
+        procs = {name: ctx.Process(target=self.run_group, args=(name,), name=f"fftvm-{name}")
+                 for name in self.groups}
+        for p in procs.values():
+            p.start()
+        for p in procs.values():
+            p.join()
+
+        failed = [name for name, p in procs.items() if p.exitcode != 0]
+        if failed:
+            raise RuntimeError(f"groups failed: {', '.join(failed)}")
+
+
+def _free_port(host):
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind((host, 0))
+        return s.getsockname()[1]
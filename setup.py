@@ -131,15 +131,25 @@ class CustomBuildExt(build_ext):
             shutil.rmtree(ff_dst_headers)
         shutil.copytree(ff_src_headers, ff_dst_headers)
         shutil.copyfile("src/libfftvm.cpp", os.path.join(pkg_dir, "libfftvm.hpp"))
+        shutil.copyfile("src/fftvm_plugin.h", os.path.join(pkg_dir, "fftvm_plugin.h"))
 
 
+# --- Optional features ---
+# FFTVM_WITH_IO_URING=1 pip install .  -> FileReader uses io_uring (needs liburing)
+define_macros = [("FFTVM_IMPL", "1"), ("FFTVM_REG_FFI", "1"), ("FFTVM_WITH_PYTHON", "1")]
+libraries = ["rt", "dl"]  # shm_open, dlopen (PluginNode) on older glibc
+if os.environ.get("FFTVM_WITH_IO_URING", "0") == "1":
+    define_macros.append(("FFTVM_WITH_IO_URING", "1"))
+    libraries.append("uring")
+
 # --- Define the Extension ---
 fftvm_ext = Extension(
     name="fftvm._lib",  # The importable module name
     sources=["src/libfftvm.cpp"],  # Your C++ source
     language="c++",
     extra_compile_args=["-std=c++17", "-O0", "-fPIC"],
-    define_macros=[("FFTVM_IMPL", "1"), ("FFTVM_REG_FFI", "1")] 
+    define_macros=define_macros,
+    libraries=libraries,
 )
 
 setup(
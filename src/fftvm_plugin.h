@@ -0,0 +1,65 @@
+/*
+ * fftvm_plugin.h: C ABI of native stages loaded with PluginNode.
+ *
+ * A plugin is a shared library exporting an entry point
+ *
+ *     const FFTVMPluginNode* my_stage(void);
+ *
+ * whose name is given to PluginNode.load(path, "my_stage", config). Every
+ * node loading it gets its own state from create(config); svc is then called
+ * with the task pointers of the graph directly, no packed call in between.
+ *
+ * Tasks are TVMFFIAny slots owned by the graph (task metadata lives in front
+ * of them: never copy a task by value, pass the pointer). svc owns its input:
+ * it returns it (possibly modified in place), sends it out, or frees it with
+ * host->free. A source is called with task == NULL until it returns
+ * FFTVM_PLUGIN_EOS. Values holding objects follow the tvm-ffi C API rules
+ * (TVMFFIObjectIncRef/DecRef).
+ */
+#ifndef FFTVM_PLUGIN_H_
+#define FFTVM_PLUGIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tvm/ffi/c_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FFTVM_PLUGIN_ABI_VERSION 1
+
+/* FastFlow control tokens, as returned by svc or given to send_out. */
+#define FFTVM_PLUGIN_EOS   ((TVMFFIAny*)(UINTPTR_MAX))
+#define FFTVM_PLUGIN_GO_ON ((TVMFFIAny*)(UINTPTR_MAX - 3))
+
+/* Services of the node hosting the plugin; valid during init, svc and end. */
+typedef struct FFTVMPluginHost {
+  void* node;
+  /* New task holding None; it inherits the metadata of the current task. */
+  TVMFFIAny* (*alloc)(void* node);
+  /* Releases a task (and the value it holds). */
+  void (*free)(void* node, TVMFFIAny* task);
+  /* Emits a task (or token) now; returns 0 on success. */
+  int (*send_out)(void* node, TVMFFIAny* task);
+} FFTVMPluginHost;
+
+typedef struct FFTVMPluginNode {
+  uint32_t abi_version; /* FFTVM_PLUGIN_ABI_VERSION */
+  /* Returns the node's state (NULL = error). config is not NUL-terminated. */
+  void* (*create)(const char* config, size_t config_len);
+  /* Optional (NULL). Non-zero fails the node start. */
+  int (*init)(void* state, const FFTVMPluginHost* host);
+  TVMFFIAny* (*svc)(void* state, TVMFFIAny* task, const FFTVMPluginHost* host);
+  /* Optional (NULL). */
+  void (*end)(void* state, const FFTVMPluginHost* host);
+  void (*destroy)(void* state);
+} FFTVMPluginNode;
+
+typedef const FFTVMPluginNode* (*FFTVMPluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FFTVM_PLUGIN_H_ */
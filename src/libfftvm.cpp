@@ -1,5 +1,8 @@
 // file: libfftvm.cpp 
 // g++ -fPIC -shared -o libfftvm.so libfftvm.cpp -ltvm_ffi 
+#ifdef FFTVM_WITH_PYTHON
+#include <Python.h>  // first, as Python.h requires (InterpreterNode)
+#endif
 #include <cstdint>
 #include <ff/node.hpp>
 #include <iostream>
@@ -8,17 +11,65 @@
 #include <tvm/ffi/any.h>
 #include <tvm/ffi/function.h>
 #include <utility>
+#include <type_traits>
 #include <string>
 #include <vector>
 #include <set>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <deque>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <tuple>
+#include <cerrno>
+#include <filesystem>
+#include <thread>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <dlfcn.h>
+#ifdef FFTVM_WITH_IO_URING
+#include <liburing.h>
+#endif
 
 #include <ff/allocator.hpp>
 #include <ff/ff.hpp>
+#include <ff/parallel_for.hpp>
 
 #include <tvm/ffi/reflection/registry.h>
 #include <tvm/ffi/container/array.h>
+#include <tvm/ffi/container/map.h>
+#include <tvm/ffi/string.h>
+#include <tvm/ffi/container/shape.h>
+#include <tvm/ffi/container/tensor.h>
+#include <tvm/ffi/dtype.h>
 
 #include <tvm/ffi/error.h>
+#include <tvm/ffi/c_api.h>
+#include "fftvm_plugin.h"
+#include <tvm/ffi/extra/json.h>
 
 void tvm_assert(bool cond, std::string msg = "") {
   if (!cond) {
@@ -26,24 +77,178 @@ void tvm_assert(bool cond, std::string msg = "") {
   }
 }
 
+struct BudgetEdge;
+
+// Metadata travelling with every task. It lives right before the Any in the
+// same allocation (see ff_alloc_any), so it costs no extra allocation and
+// follows the task pointer across pipeline, farm and A2A hops. Tasks created
+// while a node is processing a task inherit that task's metadata.
+struct TaskMeta {
+    uint8_t priority = 0;     // lane, higher is served first
+    uint8_t loops = 0;        // Loop bodies the task is inside (see Loop)
+    uint16_t shares = 0;      // owners besides the first one (see ff_share)
+    uint32_t iteration = 0;   // trips around the enclosing Loop
+    int64_t deadline_ns = 0;  // steady clock (now_ns), 0 = none
+    int64_t ingress_ns = 0;   // steady clock at the source, 0 = not stamped
+    BudgetEdge* budget = nullptr;  // edge the payload is charged to (see ByteBudget)
+    uint64_t request = 0;     // Injector request the task answers, 0 = none
+    int64_t charged = 0;      // bytes charged to `budget`
+};
+
+static_assert(sizeof(TaskMeta) % 16 == 0, "TaskMeta must preserve the alignment of the Any that follows it");
+
+// Metadata inherited by tasks allocated on this thread (see TaskScope).
+static thread_local const TaskMeta* tls_task_meta = nullptr;
+
+// Tasks allocated on this thread so far (see TaskScope::dropped).
+static thread_local uint64_t tls_allocs = 0;
+
+// Set while a node stamping ingress times runs (see LatencyProbe).
+static thread_local bool tls_stamp_ingress = false;
+
+// Output edge of the node running on this thread, whose byte budget pays for
+// the tasks it allocates (see ByteBudget).
+static thread_local BudgetEdge* tls_budget_edge = nullptr;
+static void budget_charge(tvm::ffi::Any* t);
+static void budget_release(tvm::ffi::Any* t);
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline TaskMeta* task_meta(tvm::ffi::Any* p) {
+    return reinterpret_cast<TaskMeta*>(p) - 1;
+}
+
 static inline tvm::ffi::Any* ff_alloc_any() {
-    void* anyptr_raw = ff::FFAllocator::instance()->malloc(sizeof(tvm::ffi::Any));
-    tvm_assert(anyptr_raw != nullptr, "Out of memory");
-    return static_cast<tvm::ffi::Any*>(anyptr_raw);
+    void* raw = ff::FFAllocator::instance()->malloc(sizeof(TaskMeta) + sizeof(tvm::ffi::Any));
+    tvm_assert(raw != nullptr, "Out of memory");
+    auto meta = new (raw) TaskMeta(tls_task_meta ? *tls_task_meta : TaskMeta{});
+    ++tls_allocs;
+    if (tls_stamp_ingress && meta->ingress_ns == 0) meta->ingress_ns = now_ns();
+    meta->budget = nullptr;  // every task pays for its own payload
+    meta->charged = 0;
+    meta->shares = 0;
+    return reinterpret_cast<tvm::ffi::Any*>(meta + 1);
 }
 
 static inline tvm::ffi::Any* ff_alloc_any(tvm::ffi::Any&& from) {
     auto ptr = ff_alloc_any();
     new (ptr) tvm::ffi::Any(std::move(from));
+    if (tls_budget_edge != nullptr) budget_charge(ptr);
     return ptr;
 }
 
 static inline void ff_free_any(tvm::ffi::Any* p) {
     if (!p) return;
+    auto meta = task_meta(p);
+    if (__atomic_load_n(&meta->shares, __ATOMIC_ACQUIRE) != 0 &&
+        __atomic_fetch_sub(&meta->shares, 1, __ATOMIC_ACQ_REL) != 0) return;  // not the last owner
+    if (meta->budget != nullptr) budget_release(p);
     p->~Any();
-    ff::FFAllocator::instance()->free(p);
+    ff::FFAllocator::instance()->free(meta);
+}
+
+// Makes `p` owned by `owners` consumers, each of which frees it once: one
+// task (one allocation, one reference to the payload) sent to several
+// channels. Shared tasks are read-only; see ff_unshare. `p` must be owned by
+// the caller alone: sharing it again would drop the other owners' shares.
+static inline void ff_share(tvm::ffi::Any* p, size_t owners) {
+    tvm_assert(owners >= 1 && owners <= 65536, "a task can have at most 65536 owners");
+    tvm_assert(__atomic_load_n(&task_meta(p)->shares, __ATOMIC_ACQUIRE) == 0,
+               "ff_share: the task is already shared, ff_unshare it first");
+    __atomic_store_n(&task_meta(p)->shares, uint16_t(owners - 1), __ATOMIC_RELEASE);
+}
+
+// Returns a task the caller owns alone, for stages updating tasks (or their
+// metadata) in place: a shared task is copied, metadata included, and the
+// caller's share of it dropped.
+static inline tvm::ffi::Any* ff_unshare(tvm::ffi::Any* p) {
+    if (p == nullptr || __atomic_load_n(&task_meta(p)->shares, __ATOMIC_ACQUIRE) == 0) return p;
+    void* raw = ff::FFAllocator::instance()->malloc(sizeof(TaskMeta) + sizeof(tvm::ffi::Any));
+    tvm_assert(raw != nullptr, "Out of memory");
+    auto meta = new (raw) TaskMeta(*task_meta(p));
+    meta->shares = 0;
+    meta->budget = nullptr;
+    meta->charged = 0;
+    auto copy = new (meta + 1) tvm::ffi::Any(*p);
+    if (tls_budget_edge != nullptr) budget_charge(copy);
+    ff_free_any(p);
+    return copy;
 }
 
+// Log-linear histogram of non-negative values (nanoseconds), HDR style: 16
+// linear sub-buckets per power of two (~6% relative error), fixed memory and
+// lock-free record().
+struct LatencyHistogram {
+    static constexpr int kSubBits = 4;
+    static constexpr int kSub     = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+    std::atomic<uint64_t> m_counts[kBuckets] = {};
+    std::atomic<uint64_t> m_total{0}, m_sum{0}, m_max{0};
+
+    static int index(uint64_t v) {
+        if (v < uint64_t(kSub)) return int(v);
+        int shift = 63 - __builtin_clzll(v) - kSubBits;
+        return (shift + 1) * kSub + int((v >> shift) & (kSub - 1));
+    }
+
+    // Smallest value of bucket `i`.
+    static uint64_t lower(int i) {
+        if (i < kSub) return uint64_t(i);
+        int shift = i / kSub - 1;
+        return uint64_t(kSub + i % kSub) << shift;
+    }
+
+    void record(int64_t v) {
+        uint64_t u = v > 0 ? uint64_t(v) : 0;
+        m_counts[index(u)].fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(u, std::memory_order_relaxed);
+        uint64_t cur = m_max.load(std::memory_order_relaxed);
+        while (u > cur && !m_max.compare_exchange_weak(cur, u, std::memory_order_relaxed)) {}
+    }
+
+    // Upper bound of the bucket holding the q-quantile (0 when empty).
+    uint64_t quantile(double q) const {
+        uint64_t total = m_total.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+        uint64_t target = std::max<uint64_t>(1, uint64_t(std::ceil(q * double(total))));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += m_counts[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t hi = i + 1 < kBuckets ? lower(i + 1) - 1 : UINT64_MAX;
+                return std::min(hi, m_max.load(std::memory_order_relaxed));
+            }
+        }
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& c : m_counts) c.store(0, std::memory_order_relaxed);
+        m_total.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    // Summary in microseconds.
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> to_map() const {
+        uint64_t total = m_total.load(std::memory_order_relaxed);
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("count",   int64_t(total));
+        m.Set("mean_us", total ? double(m_sum.load(std::memory_order_relaxed)) / double(total) / 1e3 : 0.0);
+        m.Set("p50_us",  double(quantile(0.50)) / 1e3);
+        m.Set("p90_us",  double(quantile(0.90)) / 1e3);
+        m.Set("p99_us",  double(quantile(0.99)) / 1e3);
+        m.Set("p999_us", double(quantile(0.999)) / 1e3);
+        m.Set("max_us",  double(m_max.load(std::memory_order_relaxed)) / 1e3);
+        return m;
+    }
+};
+
 #define FFTVM_DECLARE_OBJECT_INFO(ClassName, BaseClass) \
     static constexpr bool _type_mutable = true; \
     TVM_FFI_DECLARE_OBJECT_INFO("fftvm." #ClassName, ClassName, BaseClass)
@@ -52,9 +257,13 @@ static inline void ff_free_any(tvm::ffi::Any* p) {
     static constexpr bool _type_mutable = true; \
     TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm." #ClassName, ClassName, Node)
 
+// The by-value constructor is a template so that it is only instantiated for
+// objects that are actually moved in (nodes holding atomics or mutexes are not
+// movable, and are only built through their registered constructor).
 #define DEFINE_TVM_OBJECT_REF(ObjectName) \
 struct ObjectName##_ref : public tvm::ffi::ObjectRef { \
-  explicit ObjectName##_ref (ObjectName&& o) { \
+  template <typename T = ObjectName> \
+  explicit ObjectName##_ref (std::enable_if_t<std::is_same_v<T, ObjectName>, T>&& o) { \
     data_ = tvm::ffi::make_object<ObjectName>(std::move(o)); \
   } \
   TVM_FFI_DEFINE_OBJECT_REF_METHODS_NOTNULLABLE( ObjectName##_ref, tvm::ffi::ObjectRef, ObjectName); \
@@ -95,6 +304,56 @@ struct FFToken : public tvm::ffi::Object {
 
 DEFINE_TVM_OBJECT_REF(FFToken);
 
+static inline bool ff_is_token(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) >= static_cast<uintptr_t>(FFToken::Key::TAG_MIN);
+}
+
+// Makes the tasks allocated in this scope inherit the metadata of `t` (a copy
+// is kept: `t` is usually freed before its results are allocated).
+// Inside a Loop body every task must come out as exactly one task: the loop
+// would wait forever for one that is dropped, so dropping it fails instead.
+static inline void loop_check_dropped(const TaskMeta& meta) {
+    tvm_assert(meta.loops == 0, "Loop: the body dropped a task (filtered out, or expired); "
+               "every task must come out of the loop body as exactly one task");
+}
+
+struct TaskScope {
+    TaskMeta m_meta;
+    const TaskMeta* m_prev;
+    uint64_t m_allocs = tls_allocs;
+
+    explicit TaskScope(tvm::ffi::Any* t) : m_prev(tls_task_meta) {
+        if (t != nullptr && !ff_is_token(t)) {
+            m_meta = *task_meta(t);
+            tls_task_meta = &m_meta;
+        }
+    }
+
+    explicit TaskScope(const TaskMeta& meta) : m_meta(meta), m_prev(tls_task_meta) {
+        tls_task_meta = &m_meta;
+    }
+
+    ~TaskScope() { tls_task_meta = m_prev; }
+
+    // The node returns GO_ON for the scope's task: unless it sent tasks
+    // derived from it, the task was filtered out.
+    void dropped() const {
+        if (tls_allocs == m_allocs) loop_check_dropped(m_meta);
+    }
+};
+
+static inline tvm::ffi::Any* ff_alloc_any_deadline(tvm::ffi::Any&& from, int64_t deadline_us) {
+    auto ptr = ff_alloc_any(std::move(from));
+    task_meta(ptr)->deadline_ns = now_ns() + deadline_us * 1000;
+    return ptr;
+}
+
+static inline tvm::ffi::Any* ff_alloc_any_prio(tvm::ffi::Any&& from, int64_t priority) {
+    auto ptr = ff_alloc_any(std::move(from));
+    task_meta(ptr)->priority = uint8_t(std::clamp<int64_t>(priority, 0, 255));
+    return ptr;
+}
+
 #ifdef FFTVM_IMPL
 FFTVM_REGISTER_METHODS(FFToken);
 SUPPRESS_NO_METHOD_WARNING();
@@ -107,274 +366,1096 @@ _reg.def_static("TAG_MIN",      [](){ return FFToken_ref(FFToken::Key::TAG_MIN);
 FFTVM_REGISTER_METHODS_END();
 #endif
 
-struct Node : public tvm::ffi::Object {
-    using FF_ABC_NODE = ff::ff_node;
-    std::unique_ptr<FF_ABC_NODE> m_object;
-
-    explicit Node(tvm::ffi::UnsafeInit) : m_object(nullptr) {}
+// Receiver-side priority lanes. A node with lanes holds the tasks it receives
+// in one queue per priority while more input is waiting (at most `window`
+// tasks), then serves the highest non-empty lane first until new input
+// arrives; a lane passed over `starvation_limit` times while non-empty is
+// served next. Tasks still reach the node through the runtime's own pop, so
+// blocking mode wakes producers and EOS is handled as usual; the input
+// channels are only peeked at. Multi-input nodes (MiSo, MiMo: collectors, A2A
+// second set) peek at the output channel of each upstream node; an upstream
+// with several outputs cannot be peeked at and its tasks are served as they
+// arrive.
+// Within a lane tasks are FIFO, or earliest deadline first with `edf`
+// (tasks without a deadline go last).
+struct LaneWindow {
+    using Any = tvm::ffi::Any;
+
+    struct Entry {
+        Any* task;
+        int64_t t_ns;
+        int64_t key;
+        uint64_t seq;
+
+        // min-heap order
+        bool operator<(const Entry& o) const { return key != o.key ? key > o.key : seq > o.seq; }
+    };
 
-    template <typename Derived>
-    Node(Derived&& obj)
-        : m_object(std::make_unique<Derived>(std::forward<Derived>(obj)))
-    {
-        static_assert(std::is_base_of<FF_ABC_NODE, Derived>::value,
-                      "Wrapped object must be a derived class of the base type.");
+    std::vector<std::vector<Entry>> m_lanes;
+    std::vector<uint32_t> m_skips;
+    std::vector<std::unique_ptr<LatencyHistogram>> m_wait;
+    size_t m_window = 0, m_size = 0;
+    uint32_t m_starvation_limit = 0;
+    bool m_edf = false;
+    uint64_t m_seq = 0;
+    tvm::ffi::Function m_classifier;
+    std::vector<ff::ff_node*> m_upstream;  // of a multi-input node
+
+    bool enabled() const { return m_lanes.size() > 1 || m_edf; }
+
+    void configure(size_t lanes, size_t window, uint32_t starvation_limit, bool edf, tvm::ffi::Function classifier) {
+        tvm_assert(m_size == 0, "lanes cannot be reconfigured while tasks are queued");
+        tvm_assert(lanes >= 1 && lanes <= 256, "lanes must be in [1, 256]");
+        tvm_assert(window >= 1, "window must be >= 1");
+        m_lanes.assign(lanes, {});
+        m_skips.assign(lanes, 0);
+        m_wait.clear();
+        for (size_t i = 0; i < lanes; ++i) m_wait.push_back(std::make_unique<LatencyHistogram>());
+        m_window = window;
+        m_starvation_limit = starvation_limit;
+        m_edf = edf;
+        m_classifier = classifier;
     }
 
-    FFTVM_DECLARE_OBJECT_INFO(Node, tvm::ffi::Object);
-};
-DEFINE_TVM_OBJECT_REF(Node)
-#ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(Node)
-SUPPRESS_NO_METHOD_WARNING();
-FFTVM_REGISTER_METHODS_END();
-#endif
-
-
-
-struct SiSoNode : Node {
-    using Fn        = tvm::ffi::Function;
-    using Any       = tvm::ffi::Any;
-    using ObjectRef = tvm::ffi::ObjectRef;
+    void push(Any* t) {
+        if (m_classifier.defined()) t = ff_unshare(t);
+        auto meta = task_meta(t);
+        if (m_classifier.defined()) {
+            meta->priority = uint8_t(std::clamp<int64_t>(m_classifier(*t).cast<int64_t>(), 0, 255));
+        }
+        size_t lane = std::min<size_t>(meta->priority, m_lanes.size() - 1);
+        int64_t key = 0;
+        if (m_edf) key = meta->deadline_ns ? meta->deadline_ns : INT64_MAX;
+        m_lanes[lane].push_back({t, now_ns(), key, m_seq++});
+        std::push_heap(m_lanes[lane].begin(), m_lanes[lane].end());
+        ++m_size;
+    }
 
-    struct SiSoNodeImpl : ff::ff_node_t<Any> {
-        SiSoNode* m_self;
-        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
-        int m_svc_num_args;
+    Any* pop() {
+        if (m_size == 0) return nullptr;
+        size_t top = m_lanes.size();
+        while (m_lanes[--top].empty()) {}
+
+        size_t pick = top;
+        if (m_starvation_limit > 0) {
+            for (size_t i = 0; i < top; ++i) {
+                if (!m_lanes[i].empty() && m_skips[i] >= m_starvation_limit) {
+                    pick = i;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < m_lanes.size(); ++i) {
+            if (i == pick || m_lanes[i].empty()) m_skips[i] = 0;
+            else if (i < pick) ++m_skips[i];
+        }
 
-        SiSoNodeImpl(SiSoNode* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) :
-            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+        std::pop_heap(m_lanes[pick].begin(), m_lanes[pick].end());
+        Entry e = m_lanes[pick].back();
+        m_lanes[pick].pop_back();
+        --m_size;
+        m_wait[pick]->record(now_ns() - e.t_ns);
+        return e.task;
+    }
 
+    template <typename N>
+    static bool input_empty(N* node) {
+        auto in = node->get_in_buffer();
+        return in == nullptr || in->empty();
+    }
 
-        Any* svc(Any* t) override {
-            Any r;
-            if (m_svc_num_args == 1) {
-                r = m_svc(t != nullptr ? *t : Any());
-            } else {
-                r = m_svc(m_self, t != nullptr ? *t : Any());
-            }
-            ff_free_any(t);
+    // On the node's thread (svc_init) of a multi-input node: `gather` is the
+    // ff_minode receiving its input.
+    void watch(ff::ff_node* gather) {
+        ff::svector<ff::ff_node*> in;
+        gather->get_in_nodes(in);
+        m_upstream.assign(in.begin(), in.end());
+    }
 
-            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+    template <typename N>
+    bool input_waiting(N* node) const {
+        if (m_upstream.empty()) return !input_empty(node);
+        for (auto* n : m_upstream) {
+            auto out = n->get_out_buffer();
+            if (out != nullptr && !out->empty()) return true;
+        }
+        return false;
+    }
 
-                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
-                return tkn;
+    // Called by the node's svc after push(): while more input is waiting and
+    // the window has room, returns GO_ON so the runtime delivers it; then
+    // serves queued tasks with `process` (the node's own svc logic) until new
+    // input arrives. Returns what the node's svc should return.
+    template <typename N, typename F>
+    Any* serve(N* node, F&& process) {
+        Any* go_on = reinterpret_cast<Any*>(FFToken::Key::GO_ON);
+        if (m_size < m_window && input_waiting(node)) return go_on;
+        while (Any* t = pop()) {
+            Any* r = process(t);
+            if (!ff_is_token(r)) {
+                node->ff_send_out(r);
+            } else if (r != go_on) {
+                clear();
+                return r;
             }
-            
-            return ff_alloc_any(std::move(r));        
+            if (input_waiting(node)) break;
         }
+        return go_on;
+    }
 
-        int svc_init() override {
-            if (m_svc_init.defined()) {
-                auto ret = m_svc_init(m_self);
-                return ret.cast<int>();
-            }
-            return 0;
+    // Serves everything left (end of stream).
+    template <typename N, typename F>
+    void flush(N* node, F&& process) {
+        while (Any* t = pop()) {
+            Any* r = process(t);
+            if (!ff_is_token(r)) node->ff_send_out(r);
         }
+    }
 
-        void svc_end() override {
-            if(m_svc_end.defined()) {
-                m_svc_end(m_self);
-            }
+    void clear() {
+        for (auto& lane : m_lanes) {
+            for (auto& e : lane) ff_free_any(e.task);
+            lane.clear();
         }
+        m_size = 0;
+    }
 
-        void eosnotify(ssize_t id)  {
-            if(m_eosnotify.defined()) {
-                m_eosnotify(m_self, id);
-            }
+    tvm::ffi::Array<tvm::ffi::Any> stats() const {
+        tvm::ffi::Array<tvm::ffi::Any> out;
+        for (auto& h : m_wait) out.push_back(h->to_map());
+        return out;
+    }
+
+    ~LaneWindow() { clear(); }
+};
+
+// What a node does with a task whose deadline has passed, checked right
+// before svc: drop it, or hand it to a `divert` function whose result (if not
+// None) is forwarded instead of calling svc.
+struct ExpiryPolicy {
+    using Any = tvm::ffi::Any;
+
+    enum class Mode { None, Drop, Divert };
+
+    Mode m_mode = Mode::None;
+    tvm::ffi::Function m_divert;
+    std::atomic<uint64_t> m_dropped{0}, m_diverted{0};
+
+    void configure(const std::string& mode, tvm::ffi::Function divert) {
+        if (mode == "none") {
+            m_mode = Mode::None;
+        } else if (mode == "drop") {
+            m_mode = Mode::Drop;
+        } else if (mode == "divert") {
+            tvm_assert(divert.defined(), "expiry mode 'divert' needs a function");
+            m_mode = Mode::Divert;
+        } else {
+            tvm_assert(false, "expiry mode must be 'none', 'drop' or 'divert', got " + mode);
         }
-    };
+        m_divert = divert;
+    }
 
-    SiSoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
-        m_object = std::make_unique<SiSoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    bool expired(Any* t) const {
+        if (m_mode == Mode::None || t == nullptr || ff_is_token(t)) return false;
+        int64_t d = task_meta(t)->deadline_ns;
+        return d != 0 && now_ns() > d;
     }
 
-    SiSoNodeImpl* get() const {
-        return static_cast<SiSoNodeImpl*>(m_object.get());    
+    // Consumes `t`; returns what the node outputs in its place.
+    Any* handle(Any* t) {
+        Any* go_on = reinterpret_cast<Any*>(FFToken::Key::GO_ON);
+        if (m_mode == Mode::Drop) {
+            loop_check_dropped(*task_meta(t));
+            ff_free_any(t);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return go_on;
+        }
+        TaskScope scope(t);
+        Any r = m_divert(*t);
+        ff_free_any(t);
+        m_diverted.fetch_add(1, std::memory_order_relaxed);
+        if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+            Any* tkn = reinterpret_cast<Any*>(r.cast<FFToken_ref>()->key);
+            if (tkn == go_on) scope.dropped();
+            return tkn;
+        }
+        if (r.type_index() == TVMFFITypeIndex::kTVMFFINone) {
+            scope.dropped();
+            return go_on;
+        }
+        return ff_alloc_any(std::move(r));
     }
 
-    FFTVM_DECLARE_NODE_INFO(SiSoNode);
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("dropped",  int64_t(m_dropped.load(std::memory_order_relaxed)));
+        m.Set("diverted", int64_t(m_diverted.load(std::memory_order_relaxed)));
+        return m;
+    }
 };
 
+// End-to-end latency measurement. A node with `stamp` set stamps the tasks it
+// emits with the current time, unless they inherited a stamp (so it is meant
+// for sources); the stamp then travels in TaskMeta. A node with `record` set
+// records, for every stamped task it consumes, the time from the stamp to the
+// end of its svc.
+struct LatencyProbe {
+    using Any = tvm::ffi::Any;
 
-DEFINE_TVM_OBJECT_REF(SiSoNode);
-#ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(SiSoNode);
-CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function, tvm::ffi::Function, tvm::ffi::Function)
-METHOD("ff_send_out", [](SiSoNode* t, tvm::ffi::Any task) {
-    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
-        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
-        t->get()->ff_send_out(tkn);
-   } else {
-        t->get()->ff_send_out(ff_alloc_any(std::move(task))); 
-   }
-});
-FFTVM_REGISTER_METHODS_END();
-#endif
+    bool m_stamp = false, m_record = false;
+    LatencyHistogram m_hist;
 
+    void configure(bool stamp, bool record) {
+        m_stamp = stamp;
+        m_record = record;
+    }
 
-struct SiMoNode : Node {
-    using Fn        = tvm::ffi::Function;
-    using Any       = tvm::ffi::Any;
-    using ObjectRef = tvm::ffi::ObjectRef;
+    // Active for the duration of one svc call.
+    struct Scope {
+        LatencyProbe& m_probe;
+        bool m_prev;
+        int64_t m_ingress = 0;
 
-    struct SiMoNodeImpl : ff::ff_monode_t<Any> {
-        Node* m_self;
-        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
-        int m_svc_num_args;
+        Scope(LatencyProbe& probe, Any* t) : m_probe(probe), m_prev(tls_stamp_ingress) {
+            tls_stamp_ingress = probe.m_stamp;
+            if (probe.m_record && t != nullptr && !ff_is_token(t)) m_ingress = task_meta(t)->ingress_ns;
+        }
 
-        SiMoNodeImpl(Node* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) :
-            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+        ~Scope() {
+            if (m_ingress != 0) m_probe.m_hist.record(now_ns() - m_ingress);
+            tls_stamp_ingress = m_prev;
+        }
+    };
 
-        Any* svc(Any* t) override {
-            Any r;
-            if (m_svc_num_args == 1) {
-                r = m_svc(t != nullptr ? *t : Any());
-            } else {
-                r = m_svc(m_self, t != nullptr ? *t : Any());
-            }
-            ff_free_any(t);
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const { return m_hist.to_map(); }
+};
 
-            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+// Hardware counters of a node's thread (perf_event_open), to tell stages bound
+// on memory traffic from compute-bound ones. Counters are opened on the node's
+// thread in svc_init. In "svc" mode they are read before and after every svc
+// call (two read syscalls per task) so that only svc work is counted; in
+// "thread" mode the whole thread is counted, idle spinning included, and the
+// totals are taken in svc_end. Where perf events are not permitted (see
+// /proc/sys/kernel/perf_event_paranoid) the node runs as usual and the stats
+// report the error. Multiplexed counters are scaled by enabled/running time.
+struct PerfCounters {
+    enum class Mode { Off, Svc, Thread };
+    enum { kCycles, kInstructions, kLLCMisses, kBranches, kBranchMisses, kHardware, kContextSwitches = kHardware, kCount };
+
+    Mode m_mode = Mode::Off;
+    int m_fds[kHardware] = {-1, -1, -1, -1, -1};  // hardware group, m_fds[0] leads
+    int m_switches = -1;                          // software counter
+    uint64_t m_before[kCount] = {};
+    std::atomic<uint64_t> m_total[kCount] = {};
+    std::atomic<uint64_t> m_samples{0};
+    std::mutex m_mu;  // m_error
+    std::string m_error;
+
+    void configure(const std::string& mode) {
+        if (mode == "off")         m_mode = Mode::Off;
+        else if (mode == "svc")    m_mode = Mode::Svc;
+        else if (mode == "thread") m_mode = Mode::Thread;
+        else tvm_assert(false, "perf counters: mode must be 'off', 'svc' or 'thread', got " + mode);
+        for (auto& v : m_total) v.store(0, std::memory_order_relaxed);
+        m_samples.store(0, std::memory_order_relaxed);
+    }
 
-                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
-                return tkn;
+    static int open_event(uint32_t type, uint64_t config, int group, uint64_t read_format) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = read_format;
+        // this thread, any CPU
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    void fail(const std::string& what) {
+        std::lock_guard<std::mutex> lock(m_mu);
+        if (m_error.empty()) m_error = what + ": " + std::strerror(errno);
+    }
+
+    // On the node's thread.
+    void open() {
+        if (m_mode == Mode::Off) return;
+        static const uint64_t hw[kHardware] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                               PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+        const uint64_t format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        for (int i = 0; i < kHardware; ++i) {
+            m_fds[i] = open_event(PERF_TYPE_HARDWARE, hw[i], i == 0 ? -1 : m_fds[0], format);
+            if (m_fds[i] < 0) {
+                fail("perf_event_open(hardware counter " + std::to_string(i) + ")");
+                close_fds();  // all or none: the group is read as a whole
+                break;
             }
-            
-            return ff_alloc_any(std::move(r));        
         }
+        m_switches = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, -1, 0);
+        if (m_switches < 0) fail("perf_event_open(context switches)");
+        for (int fd : {m_fds[0], m_switches}) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
 
-        int svc_init() override {
-            if (m_svc_init.defined()) {
-                auto ret = m_svc_init(m_self);
-                return ret.cast<int>();
-            }
-            return 0;
+    void close_fds() {
+        for (int& fd : m_fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
         }
+    }
 
-        void svc_end() override {
-            if(m_svc_end.defined()) {
-                m_svc_end(m_self);
+    // Current counts (0 for counters that could not be opened).
+    void read_now(uint64_t* v) const {
+        std::fill(v, v + kCount, 0);
+        if (m_fds[0] >= 0) {
+            uint64_t buf[3 + kHardware];  // nr, time_enabled, time_running, values
+            if (::read(m_fds[0], buf, sizeof(buf)) == ssize_t(sizeof(buf))) {
+                double scale = buf[2] > 0 && buf[2] < buf[1] ? double(buf[1]) / double(buf[2]) : 1.0;
+                for (int i = 0; i < kHardware; ++i) v[i] = uint64_t(double(buf[3 + i]) * scale);
             }
         }
+        if (m_switches >= 0 && ::read(m_switches, &v[kContextSwitches], sizeof(uint64_t)) != ssize_t(sizeof(uint64_t))) {
+            v[kContextSwitches] = 0;
+        }
+    }
 
+    void add(const uint64_t* before, const uint64_t* after) {
+        for (int i = 0; i < kCount; ++i) {
+            if (after[i] > before[i]) m_total[i].fetch_add(after[i] - before[i], std::memory_order_relaxed);
+        }
+        m_samples.fetch_add(1, std::memory_order_relaxed);
+    }
 
-        void eosnotify(ssize_t id)  {
-            if(m_eosnotify.defined()) {
-                m_eosnotify(m_self);
-            }
+    // On the node's thread.
+    void close() {
+        if (m_mode == Mode::Thread) {
+            uint64_t zero[kCount] = {}, now[kCount];
+            read_now(now);
+            add(zero, now);
+        }
+        close_fds();
+        if (m_switches >= 0) ::close(m_switches);
+        m_switches = -1;
+    }
+
+    // Counts one svc call in "svc" mode.
+    struct Scope {
+        PerfCounters& m_perf;
+        explicit Scope(PerfCounters& perf) : m_perf(perf) {
+            if (perf.m_mode == Mode::Svc) perf.read_now(perf.m_before);
+        }
+        ~Scope() {
+            if (m_perf.m_mode != Mode::Svc) return;
+            uint64_t after[kCount];
+            m_perf.read_now(after);
+            m_perf.add(m_perf.m_before, after);
         }
     };
 
-    SiMoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
-        m_object = std::make_unique<SiMoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() {
+        static const char* modes[] = {"off", "svc", "thread"};
+        uint64_t v[kCount];
+        for (int i = 0; i < kCount; ++i) v[i] = m_total[i].load(std::memory_order_relaxed);
+        auto ratio = [](uint64_t a, uint64_t b) { return b > 0 ? double(a) / double(b) : 0.0; };
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("mode",             tvm::ffi::String(modes[int(m_mode)]));
+        m.Set("samples",          int64_t(m_samples.load(std::memory_order_relaxed)));
+        m.Set("cycles",           int64_t(v[kCycles]));
+        m.Set("instructions",     int64_t(v[kInstructions]));
+        m.Set("llc_misses",       int64_t(v[kLLCMisses]));
+        m.Set("branches",         int64_t(v[kBranches]));
+        m.Set("branch_misses",    int64_t(v[kBranchMisses]));
+        m.Set("context_switches", int64_t(v[kContextSwitches]));
+        m.Set("ipc",              ratio(v[kInstructions], v[kCycles]));
+        m.Set("llc_mpki",         1000.0 * ratio(v[kLLCMisses], v[kInstructions]));
+        m.Set("branch_miss_rate", ratio(v[kBranchMisses], v[kBranches]));
+        std::lock_guard<std::mutex> lock(m_mu);
+        m.Set("error",            tvm::ffi::String(m_error));
+        return m;
     }
+};
 
-    SiMoNodeImpl* get() const {
-        return static_cast<SiMoNodeImpl*>(m_object.get());    
+// Bytes of payload referenced by a task: tensor data, strings and bytes, and
+// the same inside arrays and maps. Buffers shared by several tasks are counted
+// once per task.
+static int64_t payload_bytes(const tvm::ffi::Any& v, int depth = 0) {
+    if (depth > 32) return 0;
+    switch (v.type_index()) {
+        case TVMFFITypeIndex::kTVMFFITensor:
+            return int64_t(tvm::ffi::GetDataSize(*v.cast<tvm::ffi::Tensor>().get()));
+        case TVMFFITypeIndex::kTVMFFIStr:
+        case TVMFFITypeIndex::kTVMFFISmallStr:
+            return int64_t(v.cast<tvm::ffi::String>().size());
+        case TVMFFITypeIndex::kTVMFFIBytes:
+        case TVMFFITypeIndex::kTVMFFISmallBytes:
+            return int64_t(v.cast<tvm::ffi::Bytes>().size());
+        case TVMFFITypeIndex::kTVMFFIArray: {
+            int64_t n = 0;
+            for (const auto& x : v.cast<tvm::ffi::Array<tvm::ffi::Any>>()) n += payload_bytes(x, depth + 1);
+            return n;
+        }
+        case TVMFFITypeIndex::kTVMFFIMap: {
+            int64_t n = 0;
+            for (const auto& kv : v.cast<tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any>>())
+                n += payload_bytes(kv.first, depth + 1) + payload_bytes(kv.second, depth + 1);
+            return n;
+        }
+        default:
+            return 0;
     }
+}
 
-    FFTVM_DECLARE_NODE_INFO(SiMoNode);
-};
-
+struct ByteBudget;
 
-DEFINE_TVM_OBJECT_REF(SiMoNode);
-#ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(SiMoNode);
-CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function, tvm::ffi::Function, tvm::ffi::Function)
-METHOD("ff_send_out", [](SiMoNode* t, tvm::ffi::Any task) {
-    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
-        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
-        t->get()->ff_send_out(tkn);
-   } else {
-        t->get()->ff_send_out(ff_alloc_any(std::move(task))); 
-   }
-});
+// One producer's output edge. Fields are guarded by the owning budget's mutex.
+struct BudgetEdge {
+    ByteBudget* m_budget;
+    std::string m_name;
+    int64_t m_limit;  // 0 = only the graph-wide limit applies
+    int64_t m_in_flight = 0, m_peak = 0;
+    uint64_t m_tasks = 0, m_waits = 0, m_wait_ns = 0;
 
+    BudgetEdge(ByteBudget* budget, std::string name, int64_t limit)
+        : m_budget(budget), m_name(std::move(name)), m_limit(limit) {}
+};
 
-METHOD("ff_send_out_to", [](SiMoNode* t, tvm::ffi::Any task, int id) {
-    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
-        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
-        t->get()->ff_send_out_to(tkn, id);
-   } else {
-        t->get()->ff_send_out_to(ff_alloc_any(std::move(task)), id); 
-   }
-});
-FFTVM_REGISTER_METHODS_END();
-#endif
+// Memory-based backpressure. Nodes attached to a budget (see BudgetPort) are
+// charged the payload bytes of every task they allocate, on their own edge and
+// on the graph-wide total; the charge is given back when the task is freed,
+// i.e. once its consumer is done with it. A producer whose charge would exceed
+// either limit blocks until enough bytes are released. An edge with nothing in
+// flight always admits one task, so a task larger than a limit still moves
+// and a node holding its input while emitting cannot deadlock the graph (a
+// feedback loop sharing a graph-wide budget still can).
+struct ByteBudget : tvm::ffi::Object {
+    int64_t m_limit;  // 0 = only per-edge limits apply
+    int64_t m_in_flight = 0, m_peak = 0;
+    std::mutex m_mu;
+    std::condition_variable m_cv;
+    std::deque<BudgetEdge> m_edges;  // stable addresses, referenced by tasks
+
+    explicit ByteBudget(int64_t limit) : m_limit(limit) {
+        tvm_assert(limit >= 0, "ByteBudget: limit must be >= 0");
+    }
 
+    BudgetEdge* add_edge(std::string name, int64_t limit) {
+        tvm_assert(limit >= 0, "ByteBudget: edge limit must be >= 0");
+        std::lock_guard<std::mutex> lk(m_mu);
+        if (name.empty()) name = "edge" + std::to_string(m_edges.size());
+        return &m_edges.emplace_back(this, std::move(name), limit);
+    }
 
-struct MiSoNode : Node {
-    using Fn        = tvm::ffi::Function;
-    using Any       = tvm::ffi::Any;
-    using ObjectRef = tvm::ffi::ObjectRef;
+    bool fits(const BudgetEdge& e, int64_t n) const {
+        if (e.m_in_flight == 0) return true;
+        return (m_limit == 0 || m_in_flight + n <= m_limit) && (e.m_limit == 0 || e.m_in_flight + n <= e.m_limit);
+    }
 
-    struct MiSoNodeImpl : ff::ff_minode_t<Any> {
-        MiSoNode* m_self;
-        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
-        int m_svc_num_args;
+    void acquire(BudgetEdge& e, int64_t n) {
+        std::unique_lock<std::mutex> lk(m_mu);
+        if (!fits(e, n)) {
+            int64_t t0 = now_ns();
+            m_cv.wait(lk, [&] { return fits(e, n); });
+            e.m_waits++;
+            e.m_wait_ns += uint64_t(now_ns() - t0);
+        }
+        e.m_in_flight += n;
+        e.m_peak = std::max(e.m_peak, e.m_in_flight);
+        e.m_tasks++;
+        m_in_flight += n;
+        m_peak = std::max(m_peak, m_in_flight);
+    }
 
-        MiSoNodeImpl(MiSoNode* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify):
-            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+    void release(BudgetEdge& e, int64_t n) {
+        {
+            std::lock_guard<std::mutex> lk(m_mu);
+            e.m_in_flight -= n;
+            m_in_flight -= n;
+        }
+        m_cv.notify_all();
+    }
 
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() {
+        std::lock_guard<std::mutex> lk(m_mu);
+        tvm::ffi::Array<tvm::ffi::Any> edges;
+        for (const auto& e : m_edges) {
+            tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+            m.Set("name",      tvm::ffi::String(e.m_name));
+            m.Set("limit",     e.m_limit);
+            m.Set("in_flight", e.m_in_flight);
+            m.Set("peak",      e.m_peak);
+            m.Set("tasks",     int64_t(e.m_tasks));
+            m.Set("waits",     int64_t(e.m_waits));
+            m.Set("wait_ms",   double(e.m_wait_ns) / 1e6);
+            edges.push_back(m);
+        }
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("limit",     m_limit);
+        m.Set("in_flight", m_in_flight);
+        m.Set("peak",      m_peak);
+        m.Set("edges",     edges);
+        return m;
+    }
 
-        Any* svc(Any* t) override {
-            Any r;
-            if (m_svc_num_args == 1) {
-                r = m_svc(t != nullptr ? *t : Any());
-            } else {
-                r = m_svc(m_self, t != nullptr ? *t : Any());
-            }
-            ff_free_any(t);
+    static constexpr bool _type_mutable = true;
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.ByteBudget", ByteBudget, tvm::ffi::Object);
+};
 
-            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+DEFINE_TVM_OBJECT_REF(ByteBudget);
 
-                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(ByteBudget)
+CONSTRUCTOR(int64_t)
+METHOD("stats", [](ByteBudget* b) {
+    return b->stats();
+})
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+static void budget_charge(tvm::ffi::Any* t) {
+    int64_t n = payload_bytes(*t);
+    if (n == 0) return;
+    tls_budget_edge->m_budget->acquire(*tls_budget_edge, n);
+    task_meta(t)->budget = tls_budget_edge;
+    task_meta(t)->charged = n;
+}
+
+// Gives back what was charged, not the current size: stages may update a task
+// in place (typed maps, plugins, lane classifiers) after it was charged.
+static void budget_release(tvm::ffi::Any* t) {
+    TaskMeta* meta = task_meta(t);
+    BudgetEdge* e = meta->budget;
+    meta->budget = nullptr;
+    e->m_budget->release(*e, meta->charged);
+    meta->charged = 0;
+}
+
+// A node's attachment to a ByteBudget. The edge is made current on the node's
+// thread at svc_init, so everything it allocates from then on (svc results,
+// ff_send_out, flushes at EOS) is charged to it.
+struct BudgetPort {
+    tvm::ffi::ObjectRef m_owner;  // keeps the budget (and the edge) alive
+    BudgetEdge* m_edge = nullptr;
+
+    void configure(const ByteBudget_ref& budget, int64_t edge_limit, const std::string& name) {
+        auto* b = const_cast<ByteBudget*>(budget.get());
+        m_owner = budget;
+        m_edge = b->add_edge(name, edge_limit);
+    }
+
+    void enter() const { tls_budget_edge = m_edge; }
+    void leave() const { tls_budget_edge = nullptr; }
+};
+
+// Sends `t` to every output channel of `node` (feedback channels included) as
+// one shared task, or each token to every channel. A task received shared
+// (e.g. forwarded from an upstream broadcast) is copied first. The share of a
+// channel the task could not be sent to is released.
+template <typename N>
+static bool ff_broadcast(N* node, tvm::ffi::Any* t) {
+    size_t n = node->get_num_outchannels();
+    if (n == 0) {
+        if (!ff_is_token(t)) ff_free_any(t);
+        tvm_assert(false, "broadcast: the node has no output channels");
+    }
+    bool task = !ff_is_token(t);
+    if (task) {
+        t = ff_unshare(t);
+        ff_share(t, n);
+    }
+    bool ok = true;
+    for (size_t c = 0; c < n; ++c) {
+        if (node->ff_send_out_to(t, int(c))) continue;
+        ok = false;
+        if (task) ff_free_any(t);
+    }
+    return ok;
+}
+
+// Output routing of multi-output nodes: every task the node emits goes to the
+// channel picked by the strategy, instead of FastFlow's default policy.
+//   round_robin  channels in turn
+//   key_hash     hash of `fn(task)` (of the task itself without fn), so equal
+//                keys always meet on the same channel
+//   function     `fn(task)` returns the channel index
+//   broadcast    every channel, one shared task (see ff_broadcast)
+// Tokens are not routed.
+struct Router {
+    using Any = tvm::ffi::Any;
+
+    enum class Mode { Default, RoundRobin, KeyHash, Function, Broadcast };
+
+    Mode m_mode = Mode::Default;
+    tvm::ffi::Function m_fn;
+    size_t m_next = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_sent;
+    std::atomic<size_t> m_channels{0};
+
+    bool enabled() const { return m_mode != Mode::Default; }
+
+    void configure(const std::string& mode, tvm::ffi::Function fn) {
+        if (mode == "default")          m_mode = Mode::Default;
+        else if (mode == "round_robin") m_mode = Mode::RoundRobin;
+        else if (mode == "key_hash")    m_mode = Mode::KeyHash;
+        else if (mode == "function")    m_mode = Mode::Function;
+        else if (mode == "broadcast")   m_mode = Mode::Broadcast;
+        else tvm_assert(false, "routing: unknown strategy " + mode);
+        tvm_assert(m_mode != Mode::Function || fn.defined(), "routing: the function strategy needs fn");
+        m_fn = std::move(fn);
+        m_next = 0;
+    }
+
+    // Called on the node's thread once its channels exist.
+    void start(size_t channels) {
+        if (channels == m_channels.load(std::memory_order_acquire)) return;
+        m_sent.reset(new std::atomic<uint64_t>[channels]());
+        m_channels.store(channels, std::memory_order_release);
+    }
+
+    static uint64_t mix(uint64_t h) {  // splitmix64 finalizer, spreads small ints
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    size_t pick(Any* t, size_t n) {
+        switch (m_mode) {
+            case Mode::RoundRobin: {
+                size_t c = m_next;
+                m_next = (m_next + 1) % n;
+                return c;
+            }
+            case Mode::KeyHash: {
+                Any key = m_fn.defined() ? m_fn(*t) : *t;
+                return size_t(mix(uint64_t(tvm::ffi::AnyHash()(key))) % n);
+            }
+            default: {
+                int64_t c = m_fn(*t).cast<int64_t>();
+                tvm_assert(c >= 0 && size_t(c) < n, "routing: channel " + std::to_string(c) + " out of range");
+                return size_t(c);
+            }
+        }
+    }
+
+    // Sends through the base class, bypassing the node's own (routing) ff_send_out.
+    bool route(ff::ff_monode_t<Any>* node, Any* t) {
+        using Base = ff::ff_monode_t<Any>;
+        size_t n = node->get_num_outchannels();
+        if (n == 0) return node->Base::ff_send_out(t);  // last stage: nothing to pick from
+        start(n);
+        if (m_mode == Mode::Broadcast) {
+            for (size_t c = 0; c < n; ++c) m_sent[c].fetch_add(1, std::memory_order_relaxed);
+            return ff_broadcast(node, t);
+        }
+        size_t c = pick(t, n);
+        m_sent[c].fetch_add(1, std::memory_order_relaxed);
+        return node->Base::ff_send_out_to(t, int(c));
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        static const char* names[] = {"default", "round_robin", "key_hash", "function", "broadcast"};
+        tvm::ffi::Array<int64_t> sent;
+        size_t n = m_channels.load(std::memory_order_acquire);
+        for (size_t c = 0; c < n; ++c) sent.push_back(int64_t(m_sent[c].load(std::memory_order_relaxed)));
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("strategy", tvm::ffi::String(names[int(m_mode)]));
+        m.Set("sent",     sent);
+        return m;
+    }
+};
+
+// Vectorized svc: consecutive scalar tasks are gathered into a 1-D tensor (up
+// to `max_batch`, or whatever arrived before the input channel ran dry) that
+// is handed to one `fn` call. A tensor result is exploded back into one task
+// per element, any other result is forwarded as a single task. Other tasks
+// flush the batch and take the node's usual path. Tasks derived from a batch
+// inherit the metadata of its oldest task.
+struct Vectorizer {
+    using Any = tvm::ffi::Any;
+
+    struct HostAlloc {
+        void AllocData(DLTensor* tensor) {
+            tensor->data = std::malloc(std::max<size_t>(1, tvm::ffi::GetDataSize(*tensor)));
+            tensor->byte_offset = 0;
+            tvm_assert(tensor->data != nullptr, "Out of memory");
+        }
+
+        void FreeData(DLTensor* tensor) { std::free(tensor->data); }
+    };
+
+    size_t m_max_batch = 0;  // 0 = off
+    bool m_float = false;
+    tvm::ffi::Function m_fn;
+    std::vector<int64_t> m_ints;
+    std::vector<double> m_floats;
+    std::vector<TaskMeta> m_metas;  // of each batched task
+    std::atomic<uint64_t> m_batches{0}, m_items{0};
+
+    bool enabled() const { return m_max_batch > 0; }
+    size_t size() const { return m_float ? m_floats.size() : m_ints.size(); }
+
+    void configure(size_t max_batch, const std::string& dtype, tvm::ffi::Function fn) {
+        tvm_assert(size() == 0, "vectorized svc cannot be reconfigured while a batch is pending");
+        tvm_assert(dtype == "int64" || dtype == "float64", "vectorized dtype must be 'int64' or 'float64', got " + dtype);
+        tvm_assert(max_batch == 0 || fn.defined(), "vectorized svc needs a function");
+        m_max_batch = max_batch;
+        m_float = dtype == "float64";
+        m_fn = fn;
+        m_ints.reserve(m_float ? 0 : max_batch);
+        m_floats.reserve(m_float ? max_batch : 0);
+        m_metas.reserve(max_batch);
+    }
+
+    // Moves a scalar task into the batch; false (and `t` untouched) otherwise.
+    bool add(Any* t) {
+        int32_t ti = t->type_index();
+        bool integral = ti == TVMFFITypeIndex::kTVMFFIInt || ti == TVMFFITypeIndex::kTVMFFIBool;
+        if (!integral && !(m_float && ti == TVMFFITypeIndex::kTVMFFIFloat)) return false;
+        m_metas.push_back(*task_meta(t));
+        int64_t i = ti == TVMFFITypeIndex::kTVMFFIBool ? int64_t(t->cast<bool>()) : integral ? t->cast<int64_t>() : 0;
+        if (m_float) m_floats.push_back(integral ? double(i) : t->cast<double>());
+        else m_ints.push_back(i);
+        ff_free_any(t);
+        return true;
+    }
+
+    static Any element(const DLTensor& t, size_t i) {
+        const char* p = static_cast<const char*>(t.data) + t.byte_offset;
+        switch (t.dtype.code) {
+            case kDLInt:
+                switch (t.dtype.bits) {
+                    case 8:  return int64_t(reinterpret_cast<const int8_t*>(p)[i]);
+                    case 16: return int64_t(reinterpret_cast<const int16_t*>(p)[i]);
+                    case 32: return int64_t(reinterpret_cast<const int32_t*>(p)[i]);
+                    case 64: return reinterpret_cast<const int64_t*>(p)[i];
+                }
+                break;
+            case kDLUInt:
+                switch (t.dtype.bits) {
+                    case 8:  return int64_t(reinterpret_cast<const uint8_t*>(p)[i]);
+                    case 16: return int64_t(reinterpret_cast<const uint16_t*>(p)[i]);
+                    case 32: return int64_t(reinterpret_cast<const uint32_t*>(p)[i]);
+                    case 64: return int64_t(reinterpret_cast<const uint64_t*>(p)[i]);
+                }
+                break;
+            case kDLFloat:
+                switch (t.dtype.bits) {
+                    case 32: return double(reinterpret_cast<const float*>(p)[i]);
+                    case 64: return reinterpret_cast<const double*>(p)[i];
+                }
+                break;
+            case kDLBool:
+                if (t.dtype.bits == 8) return bool(reinterpret_cast<const uint8_t*>(p)[i]);
+                break;
+        }
+        tvm_assert(false, "vectorized svc: unsupported result dtype");
+        return Any();
+    }
+
+    // Runs `fn` on the pending batch; returns what the node's svc should return.
+    // An array of one result per task gives each result the metadata of its
+    // task (deadline, priority, ingress stamp, request); any other result gets
+    // the first task's.
+    template <typename N>
+    Any* flush(N* node) {
+        Any* go_on = reinterpret_cast<Any*>(FFToken::Key::GO_ON);
+        size_t n = size();
+        if (n == 0) return go_on;
+
+        DLDataType dtype{uint8_t(m_float ? kDLFloat : kDLInt), 64, 1};
+        auto batch = tvm::ffi::Tensor::FromNDAlloc(HostAlloc{}, tvm::ffi::Shape({int64_t(n)}), dtype, DLDevice{kDLCPU, 0});
+        std::memcpy(batch->data, m_float ? static_cast<const void*>(m_floats.data()) : static_cast<const void*>(m_ints.data()), n * 8);
+        m_ints.clear();
+        m_floats.clear();
+        std::vector<TaskMeta> metas;
+        metas.swap(m_metas);
+        m_metas.reserve(m_max_batch);
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+        m_items.fetch_add(n, std::memory_order_relaxed);
+
+        // latency of every batched task, from its ingress to the end of the batch
+        struct Record {
+            LatencyProbe& probe;
+            const std::vector<TaskMeta>& metas;
+            ~Record() {
+                if (!probe.m_record) return;
+                int64_t now = now_ns();
+                for (const auto& m : metas) {
+                    if (m.ingress_ns != 0) probe.m_hist.record(now - m.ingress_ns);
+                }
+            }
+        } record{node->m_latency, metas};
+
+        Any r;
+        {
+            TaskScope scope(metas[0]);
+            LatencyProbe::Scope probe(node->m_latency, nullptr);  // stamps, records nothing
+            r = m_fn(std::move(batch));
+        }
+        if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+            return reinterpret_cast<Any*>(r.cast<FFToken_ref>()->key);
+        }
+        if (r.type_index() == TVMFFITypeIndex::kTVMFFINone) return go_on;
+        if (r.type_index() != TVMFFITypeIndex::kTVMFFITensor) {
+            TaskScope scope(metas[0]);
+            return ff_alloc_any(std::move(r));
+        }
+
+        auto out = r.cast<tvm::ffi::Tensor>();
+        tvm_assert(out->device.device_type == kDLCPU && out->ndim <= 1 && out.IsContiguous(),
+                   "vectorized svc must return a contiguous 1-D CPU array");
+        size_t len = out->ndim == 0 ? 1 : size_t(out->shape[0]);
+        for (size_t i = 0; i < len; ++i) {
+            TaskScope scope(metas[len == n ? i : 0]);
+            node->ff_send_out(ff_alloc_any(element(*out.get(), i)));
+        }
+        return go_on;
+    }
+
+    // The node's svc for `t` while vectorized; `process` is its usual path.
+    template <typename N, typename F>
+    Any* svc(N* node, Any* t, F&& process) {
+        Any* go_on = reinterpret_cast<Any*>(FFToken::Key::GO_ON);
+        if (node->m_expiry.expired(t)) {  // never batched
+            Any* r = node->m_expiry.handle(t);
+            if (!ff_is_token(r)) {
+                node->ff_send_out(r);
+            } else if (r != go_on) {
+                return r;
+            }
+            if (size() > 0 && LaneWindow::input_empty(node)) return flush(node);
+            return go_on;
+        }
+        if (add(t)) {
+            if (size() >= m_max_batch || LaneWindow::input_empty(node)) return flush(node);
+            return reinterpret_cast<Any*>(FFToken::Key::GO_ON);
+        }
+        Any* r = flush(node);
+        if (!ff_is_token(r)) {
+            node->ff_send_out(r);
+        } else if (reinterpret_cast<uintptr_t>(r) != uintptr_t(FFToken::Key::GO_ON)) {
+            ff_free_any(t);
+            return r;
+        }
+        return process(t);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("batches", int64_t(m_batches.load(std::memory_order_relaxed)));
+        m.Set("items",   int64_t(m_items.load(std::memory_order_relaxed)));
+        return m;
+    }
+};
+
+// How a node calls its callbacks, packed in the `svc_num_args` constructor
+// argument. Python subclasses pass bound methods along with their exact
+// arity, so a task costs a single call into Python.
+namespace node_call {
+
+constexpr int kTask      = 1;        // svc(task)
+constexpr int kSelfTask  = 2;        // svc(self, task)
+constexpr int kNoArgs    = 3;        // svc()
+constexpr int kArityMask = 0xff;
+constexpr int kInitBound = 1 << 8;   // svc_init() rather than svc_init(self)
+constexpr int kEndBound  = 1 << 9;   // svc_end() rather than svc_end(self)
+constexpr int kEosBound  = 1 << 10;  // eosnotify without self...
+constexpr int kEosWithId = 1 << 11;  // ...taking the channel id
+
+template <typename Self>
+static inline tvm::ffi::Any svc(const tvm::ffi::Function& fn, int flags, Self* self, tvm::ffi::Any* t) {
+    switch (flags & kArityMask) {
+        case kTask:   return fn(t != nullptr ? *t : tvm::ffi::Any());
+        case kNoArgs: return fn();
+        default:      return fn(self, t != nullptr ? *t : tvm::ffi::Any());
+    }
+}
+
+template <typename Self>
+static inline int svc_init(const tvm::ffi::Function& fn, int flags, Self* self) {
+    if (!fn.defined()) return 0;
+    auto ret = (flags & kInitBound) ? fn() : fn(self);
+    return ret.template cast<int>();
+}
+
+template <typename Self>
+static inline void svc_end(const tvm::ffi::Function& fn, int flags, Self* self) {
+    if (!fn.defined()) return;
+    if (flags & kEndBound) fn(); else fn(self);
+}
+
+// Bound eosnotify only: unbound ones keep each node's own signature.
+static inline void eosnotify(const tvm::ffi::Function& fn, int flags, ssize_t id) {
+    if (flags & kEosWithId) fn(int64_t(id)); else fn();
+}
+
+} // namespace node_call
+
+struct Node : public tvm::ffi::Object {
+    using FF_ABC_NODE = ff::ff_node;
+    std::unique_ptr<FF_ABC_NODE> m_object;
+
+    explicit Node(tvm::ffi::UnsafeInit) : m_object(nullptr) {}
+
+    template <typename Derived>
+    Node(Derived&& obj)
+        : m_object(std::make_unique<Derived>(std::forward<Derived>(obj)))
+    {
+        static_assert(std::is_base_of<FF_ABC_NODE, Derived>::value,
+                      "Wrapped object must be a derived class of the base type.");
+    }
+
+    FFTVM_DECLARE_OBJECT_INFO(Node, tvm::ffi::Object);
+};
+DEFINE_TVM_OBJECT_REF(Node)
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Node)
+SUPPRESS_NO_METHOD_WARNING();
+FFTVM_REGISTER_METHODS_END();
+#endif
+
+
+
+struct SiSoNode : Node {
+    using Fn        = tvm::ffi::Function;
+    using Any       = tvm::ffi::Any;
+    using ObjectRef = tvm::ffi::ObjectRef;
+
+    struct SiSoNodeImpl : ff::ff_node_t<Any> {
+        SiSoNode* m_self;
+        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
+        int m_svc_num_args;
+        LaneWindow m_lanes;
+        ExpiryPolicy m_expiry;
+        LatencyProbe m_latency;
+        PerfCounters m_perf;
+        BudgetPort m_budget;
+        Vectorizer m_vector;
+
+        SiSoNodeImpl(SiSoNode* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) :
+            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+
+
+        Any* process(Any* t) {
+            if (m_expiry.expired(t)) return m_expiry.handle(t);
+            TaskScope scope(t);
+            LatencyProbe::Scope probe(m_latency, t);
+            Any r = node_call::svc(m_svc, m_svc_num_args, m_self, t);
+            ff_free_any(t);
+
+            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+
+                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
+                if (tkn == GO_ON) scope.dropped();
                 return tkn;
             }
             
             return ff_alloc_any(std::move(r));        
         }
 
+        Any* svc(Any* t) override {
+            PerfCounters::Scope perf(m_perf);
+            if (t != nullptr && m_vector.enabled()) return m_vector.svc(this, t, [this](Any* x) { return process(x); });
+            if (t == nullptr || !m_lanes.enabled()) return process(t);
+            m_lanes.push(t);
+            return m_lanes.serve(this, [this](Any* x) { return process(x); });
+        }
+
         int svc_init() override {
-            if (m_svc_init.defined()) {
-                auto ret = m_svc_init(m_self);
-                return ret.cast<int>();
-            }
-            return 0;
+            m_budget.enter();
+            m_perf.open();
+            return node_call::svc_init(m_svc_init, m_svc_num_args, m_self);
         }
 
         void svc_end() override {
-            if(m_svc_end.defined()) {
-                m_svc_end(m_self);
-            }
+            node_call::svc_end(m_svc_end, m_svc_num_args, m_self);
+            m_perf.close();
+            m_budget.leave();
         }
 
         void eosnotify(ssize_t id)  {
-            if(m_eosnotify.defined()) {
+            Any* r = m_vector.flush(this);
+            if (!ff_is_token(r)) ff_send_out(r);
+            m_lanes.flush(this, [this](Any* x) { return process(x); });
+            if (!m_eosnotify.defined()) return;
+            if (m_svc_num_args & node_call::kEosBound) {
+                node_call::eosnotify(m_eosnotify, m_svc_num_args, id);
+            } else {
                 m_eosnotify(m_self, id);
             }
         }
     };
 
-    MiSoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
-        m_object = std::make_unique<MiSoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    SiSoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<SiSoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
     }
 
-    MiSoNodeImpl* get() const {
-        return static_cast<MiSoNodeImpl*>(m_object.get());    
+    SiSoNodeImpl* get() const {
+        return static_cast<SiSoNodeImpl*>(m_object.get());    
     }
 
-    FFTVM_DECLARE_NODE_INFO(MiSoNode);
+    FFTVM_DECLARE_NODE_INFO(SiSoNode);
 };
 
 
-DEFINE_TVM_OBJECT_REF(MiSoNode);
-
+DEFINE_TVM_OBJECT_REF(SiSoNode);
 #ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(MiSoNode);
+FFTVM_REGISTER_METHODS(SiSoNode);
 CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function, tvm::ffi::Function, tvm::ffi::Function)
-METHOD("ff_send_out", [](MiSoNode* t, tvm::ffi::Any task) {
+METHOD("ff_send_out_prio", [](SiSoNode* t, tvm::ffi::Any task, int64_t priority) {
+    t->get()->ff_send_out(ff_alloc_any_prio(std::move(task), priority));
+});
+METHOD("ff_send_out_deadline", [](SiSoNode* t, tvm::ffi::Any task, int64_t deadline_us) {
+    t->get()->ff_send_out(ff_alloc_any_deadline(std::move(task), deadline_us));
+});
+METHOD("configure_expiry", [](SiSoNode* t, tvm::ffi::String mode, tvm::ffi::Optional<tvm::ffi::Function> divert) {
+    t->get()->m_expiry.configure(mode, divert.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("expiry_stats", [](SiSoNode* t) {
+    return t->get()->m_expiry.stats();
+});
+METHOD("configure_latency", [](SiSoNode* t, bool stamp, bool record) {
+    t->get()->m_latency.configure(stamp, record);
+    return t;
+});
+METHOD("latency_stats", [](SiSoNode* t) {
+    return t->get()->m_latency.stats();
+});
+METHOD("reset_latency", [](SiSoNode* t) {
+    t->get()->m_latency.m_hist.reset();
+});
+METHOD("configure_perf", [](SiSoNode* t, tvm::ffi::String mode) {
+    t->get()->m_perf.configure(mode);
+    return t;
+});
+METHOD("perf_stats", [](SiSoNode* t) {
+    return t->get()->m_perf.stats();
+});
+METHOD("configure_byte_budget", [](SiSoNode* t, ByteBudget_ref budget, int64_t edge_limit, tvm::ffi::String name) {
+    t->get()->m_budget.configure(budget, edge_limit, name);
+    return t;
+});
+METHOD("configure_lanes", [](SiSoNode* t, int64_t lanes, int64_t window, int64_t starvation_limit, bool edf, tvm::ffi::Optional<tvm::ffi::Function> classifier) {
+    t->get()->m_lanes.configure(size_t(lanes), size_t(window), uint32_t(starvation_limit), edf, classifier.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("lane_stats", [](SiSoNode* t) {
+    return t->get()->m_lanes.stats();
+});
+METHOD("configure_vectorized", [](SiSoNode* t, int64_t max_batch, tvm::ffi::String dtype, tvm::ffi::Optional<tvm::ffi::Function> fn) {
+    tvm_assert(max_batch == 0 || !t->get()->m_lanes.enabled(), "a node cannot have both lanes and a vectorized svc");
+    t->get()->m_vector.configure(size_t(std::max<int64_t>(max_batch, 0)), dtype, fn.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("vector_stats", [](SiSoNode* t) {
+    return t->get()->m_vector.stats();
+});
+METHOD("ff_send_out", [](SiSoNode* t, tvm::ffi::Any task) {
     if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
         void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
         t->get()->ff_send_out(tkn);
@@ -386,56 +1467,166 @@ FFTVM_REGISTER_METHODS_END();
 #endif
 
 
-
-struct MiMoNode : Node {
+struct SiMoNode : Node {
     using Fn        = tvm::ffi::Function;
     using Any       = tvm::ffi::Any;
     using ObjectRef = tvm::ffi::ObjectRef;
 
-    struct MiNodeForwarder : ff::ff_minode_t<Any> {
+    struct SiMoNodeImpl : ff::ff_monode_t<Any> {
+        Node* m_self;
+        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
+        int m_svc_num_args;
+        LaneWindow m_lanes;
+        ExpiryPolicy m_expiry;
+        LatencyProbe m_latency;
+        PerfCounters m_perf;
+        BudgetPort m_budget;
+        Vectorizer m_vector;
+        Router m_router;
+        ff::ff_node* m_gather = nullptr;  // input side of a MiMoNode
+
+        SiMoNodeImpl(Node* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) :
+            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+
+        Any* process(Any* t) {
+            if (m_expiry.expired(t)) return m_expiry.handle(t);
+            TaskScope scope(t);
+            LatencyProbe::Scope probe(m_latency, t);
+            Any r = node_call::svc(m_svc, m_svc_num_args, m_self, t);
+            ff_free_any(t);
+
+            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+
+                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
+                if (tkn == GO_ON) scope.dropped();
+                return tkn;
+            }
+            
+            return ff_alloc_any(std::move(r));        
+        }
+
+        Any* serve(Any* t) {
+            if (t != nullptr && m_vector.enabled()) return m_vector.svc(this, t, [this](Any* x) { return process(x); });
+            if (t == nullptr || !m_lanes.enabled()) return process(t);
+            m_lanes.push(t);
+            return m_lanes.serve(this, [this](Any* x) { return process(x); });
+        }
+
         Any* svc(Any* t) override {
-            return t;
+            PerfCounters::Scope perf(m_perf);
+            Any* r = serve(t);
+            if (r == nullptr || ff_is_token(r) || !m_router.enabled()) return r;
+            m_router.route(this, r);
+            return GO_ON;
         }
-    };
 
-    struct MiMoNodeInternal {
-        MiNodeForwarder m_in;
-        SiMoNode::SiMoNodeImpl m_out;
+        // Hides ff_monode_t::ff_send_out(task) so that every task the node
+        // emits (Python ff_send_out, vectorizer and lane flushes) is routed.
+        bool ff_send_out(void* task) {
+            if (task == nullptr || ff_is_token(task) || !m_router.enabled()) return ff::ff_monode_t<Any>::ff_send_out(task);
+            return m_router.route(this, static_cast<Any*>(task));
+        }
 
-        template <typename... Args>
-        MiMoNodeInternal(Args&&... args) : 
-            m_in(), 
-            m_out(std::forward<Args>(args)...) {}
-    };
+        int svc_init() override {
+            m_budget.enter();
+            m_perf.open();
+            if (m_gather != nullptr) m_lanes.watch(m_gather);
+            return node_call::svc_init(m_svc_init, m_svc_num_args, m_self);
+        }
 
-    struct MiMoNodeImpl : private MiMoNodeInternal, public ff::ff_comb {
+        void svc_end() override {
+            node_call::svc_end(m_svc_end, m_svc_num_args, m_self);
+            m_perf.close();
+            m_budget.leave();
+        }
 
-        using ff::ff_comb::ff_send_out; 
-        using ff::ff_comb::ff_send_out_to;
 
-        template <typename... Args>
-        MiMoNodeImpl(Args&&... args) : 
-            MiMoNodeInternal(std::forward<Args>(args)...),
-            ff::ff_comb(&this->m_in, &this->m_out) {}
+        void eosnotify(ssize_t id)  {
+            Any* r = m_vector.flush(this);
+            if (!ff_is_token(r)) ff_send_out(r);
+            m_lanes.flush(this, [this](Any* x) { return process(x); });
+            if (!m_eosnotify.defined()) return;
+            if (m_svc_num_args & node_call::kEosBound) {
+                node_call::eosnotify(m_eosnotify, m_svc_num_args, id);
+            } else {
+                m_eosnotify(m_self);
+            }
+        }
     };
 
-    MiMoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
-        m_object = std::make_unique<MiMoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    SiMoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<SiMoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
     }
 
-    MiMoNodeImpl* get() const {
-        return static_cast<MiMoNodeImpl*>(m_object.get());    
+    SiMoNodeImpl* get() const {
+        return static_cast<SiMoNodeImpl*>(m_object.get());    
     }
 
-    FFTVM_DECLARE_NODE_INFO(MiMoNode);
+    FFTVM_DECLARE_NODE_INFO(SiMoNode);
 };
 
 
-DEFINE_TVM_OBJECT_REF(MiMoNode);
+DEFINE_TVM_OBJECT_REF(SiMoNode);
 #ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(MiMoNode);
-CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function,  tvm::ffi::Function, tvm::ffi::Function)
-METHOD("ff_send_out", [](MiMoNode* t, tvm::ffi::Any task) {
+FFTVM_REGISTER_METHODS(SiMoNode);
+CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function, tvm::ffi::Function, tvm::ffi::Function)
+METHOD("ff_send_out_prio", [](SiMoNode* t, tvm::ffi::Any task, int64_t priority) {
+    t->get()->ff_send_out(ff_alloc_any_prio(std::move(task), priority));
+});
+METHOD("ff_send_out_deadline", [](SiMoNode* t, tvm::ffi::Any task, int64_t deadline_us) {
+    t->get()->ff_send_out(ff_alloc_any_deadline(std::move(task), deadline_us));
+});
+METHOD("configure_expiry", [](SiMoNode* t, tvm::ffi::String mode, tvm::ffi::Optional<tvm::ffi::Function> divert) {
+    t->get()->m_expiry.configure(mode, divert.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("expiry_stats", [](SiMoNode* t) {
+    return t->get()->m_expiry.stats();
+});
+METHOD("configure_latency", [](SiMoNode* t, bool stamp, bool record) {
+    t->get()->m_latency.configure(stamp, record);
+    return t;
+});
+METHOD("latency_stats", [](SiMoNode* t) {
+    return t->get()->m_latency.stats();
+});
+METHOD("reset_latency", [](SiMoNode* t) {
+    t->get()->m_latency.m_hist.reset();
+});
+METHOD("configure_perf", [](SiMoNode* t, tvm::ffi::String mode) {
+    t->get()->m_perf.configure(mode);
+    return t;
+});
+METHOD("perf_stats", [](SiMoNode* t) {
+    return t->get()->m_perf.stats();
+});
+METHOD("configure_byte_budget", [](SiMoNode* t, ByteBudget_ref budget, int64_t edge_limit, tvm::ffi::String name) {
+    t->get()->m_budget.configure(budget, edge_limit, name);
+    return t;
+});
+METHOD("configure_lanes", [](SiMoNode* t, int64_t lanes, int64_t window, int64_t starvation_limit, bool edf, tvm::ffi::Optional<tvm::ffi::Function> classifier) {
+    t->get()->m_lanes.configure(size_t(lanes), size_t(window), uint32_t(starvation_limit), edf, classifier.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("lane_stats", [](SiMoNode* t) {
+    return t->get()->m_lanes.stats();
+});
+METHOD("configure_vectorized", [](SiMoNode* t, int64_t max_batch, tvm::ffi::String dtype, tvm::ffi::Optional<tvm::ffi::Function> fn) {
+    tvm_assert(max_batch == 0 || !t->get()->m_lanes.enabled(), "a node cannot have both lanes and a vectorized svc");
+    t->get()->m_vector.configure(size_t(std::max<int64_t>(max_batch, 0)), dtype, fn.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("vector_stats", [](SiMoNode* t) {
+    return t->get()->m_vector.stats();
+});
+METHOD("configure_routing", [](SiMoNode* t, tvm::ffi::String strategy, tvm::ffi::Optional<tvm::ffi::Function> fn) {
+    t->get()->m_router.configure(strategy, fn.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("routing_stats", [](SiMoNode* t) {
+    return t->get()->m_router.stats();
+});
+METHOD("ff_send_out", [](SiMoNode* t, tvm::ffi::Any task) {
     if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
         void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
         t->get()->ff_send_out(tkn);
@@ -444,7 +1635,15 @@ METHOD("ff_send_out", [](MiMoNode* t, tvm::ffi::Any task) {
    }
 });
 
-METHOD("ff_send_out_to", [](MiMoNode* t, tvm::ffi::Any task, int id) {
+
+METHOD("broadcast", [](SiMoNode* t, tvm::ffi::Any task) {
+    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+        ff_broadcast(t->get(), reinterpret_cast<tvm::ffi::Any*>(task.cast<FFToken_ref>()->key));
+    } else {
+        ff_broadcast(t->get(), ff_alloc_any(std::move(task)));
+    }
+});
+METHOD("ff_send_out_to", [](SiMoNode* t, tvm::ffi::Any task, int id) {
     if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
         void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
         t->get()->ff_send_out_to(tkn, id);
@@ -456,218 +1655,5211 @@ FFTVM_REGISTER_METHODS_END();
 #endif
 
 
+struct MiSoNode : Node {
+    using Fn        = tvm::ffi::Function;
+    using Any       = tvm::ffi::Any;
+    using ObjectRef = tvm::ffi::ObjectRef;
 
-struct Pipeline : Node {
-    Pipeline() : Node(ff::ff_pipeline()) {}
-    
-    std::vector<tvm::ffi::Any> m_owned_deps;
+    struct MiSoNodeImpl : ff::ff_minode_t<Any> {
+        MiSoNode* m_self;
+        Fn m_svc, m_svc_init, m_svc_end, m_eosnotify;
+        int m_svc_num_args;
+        LaneWindow m_lanes;
+        ExpiryPolicy m_expiry;
+        LatencyProbe m_latency;
+        PerfCounters m_perf;
+        BudgetPort m_budget;
+
+        MiSoNodeImpl(MiSoNode* self, Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify):
+            m_self(self), m_svc(svc), m_svc_num_args(svc_num_args), m_svc_init(svc_init), m_svc_end(svc_end), m_eosnotify(eosnotify) {}
+
+
+        Any* svc(Any* t) override {
+            PerfCounters::Scope perf(m_perf);
+            if (t == nullptr || !m_lanes.enabled()) return process(t);
+            m_lanes.push(t);
+            return m_lanes.serve(this, [this](Any* x) { return process(x); });
+        }
+
+        Any* process(Any* t) {
+            if (m_expiry.expired(t)) return m_expiry.handle(t);
+            TaskScope scope(t);
+            LatencyProbe::Scope probe(m_latency, t);
+            Any r = node_call::svc(m_svc, m_svc_num_args, m_self, t);
+            ff_free_any(t);
+
+            if (r.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+
+                Any* tkn = reinterpret_cast<Any *>(r.cast<FFToken_ref>()->key); // [[ UNSAFE ]] this is not a real Any* it is void*
+                if (tkn == GO_ON) scope.dropped();
+                return tkn;
+            }
+            
+            return ff_alloc_any(std::move(r));        
+        }
+
+        int svc_init() override {
+            m_budget.enter();
+            m_perf.open();
+            m_lanes.watch(this);
+            return node_call::svc_init(m_svc_init, m_svc_num_args, m_self);
+        }
+
+        void svc_end() override {
+            node_call::svc_end(m_svc_end, m_svc_num_args, m_self);
+            m_perf.close();
+            m_budget.leave();
+        }
+
+        void eosnotify(ssize_t id)  {
+            m_lanes.flush(this, [this](Any* x) { return process(x); });
+            if (!m_eosnotify.defined()) return;
+            if (m_svc_num_args & node_call::kEosBound) {
+                node_call::eosnotify(m_eosnotify, m_svc_num_args, id);
+            } else {
+                m_eosnotify(m_self, id);
+            }
+        }
+    };
+
+    MiSoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<MiSoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    }
+
+    MiSoNodeImpl* get() const {
+        return static_cast<MiSoNodeImpl*>(m_object.get());    
+    }
+
+    FFTVM_DECLARE_NODE_INFO(MiSoNode);
+};
+
+
+DEFINE_TVM_OBJECT_REF(MiSoNode);
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(MiSoNode);
+CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function, tvm::ffi::Function, tvm::ffi::Function)
+METHOD("ff_send_out_prio", [](MiSoNode* t, tvm::ffi::Any task, int64_t priority) {
+    t->get()->ff_send_out(ff_alloc_any_prio(std::move(task), priority));
+});
+METHOD("ff_send_out_deadline", [](MiSoNode* t, tvm::ffi::Any task, int64_t deadline_us) {
+    t->get()->ff_send_out(ff_alloc_any_deadline(std::move(task), deadline_us));
+});
+METHOD("configure_expiry", [](MiSoNode* t, tvm::ffi::String mode, tvm::ffi::Optional<tvm::ffi::Function> divert) {
+    t->get()->m_expiry.configure(mode, divert.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("expiry_stats", [](MiSoNode* t) {
+    return t->get()->m_expiry.stats();
+});
+METHOD("configure_latency", [](MiSoNode* t, bool stamp, bool record) {
+    t->get()->m_latency.configure(stamp, record);
+    return t;
+});
+METHOD("latency_stats", [](MiSoNode* t) {
+    return t->get()->m_latency.stats();
+});
+METHOD("reset_latency", [](MiSoNode* t) {
+    t->get()->m_latency.m_hist.reset();
+});
+METHOD("configure_perf", [](MiSoNode* t, tvm::ffi::String mode) {
+    t->get()->m_perf.configure(mode);
+    return t;
+});
+METHOD("perf_stats", [](MiSoNode* t) {
+    return t->get()->m_perf.stats();
+});
+METHOD("configure_byte_budget", [](MiSoNode* t, ByteBudget_ref budget, int64_t edge_limit, tvm::ffi::String name) {
+    t->get()->m_budget.configure(budget, edge_limit, name);
+    return t;
+});
+METHOD("configure_lanes", [](MiSoNode* t, int64_t lanes, int64_t window, int64_t starvation_limit, bool edf, tvm::ffi::Optional<tvm::ffi::Function> classifier) {
+    t->get()->m_lanes.configure(size_t(lanes), size_t(window), uint32_t(starvation_limit), edf, classifier.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("lane_stats", [](MiSoNode* t) {
+    return t->get()->m_lanes.stats();
+});
+METHOD("ff_send_out", [](MiSoNode* t, tvm::ffi::Any task) {
+    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
+        t->get()->ff_send_out(tkn);
+   } else {
+        t->get()->ff_send_out(ff_alloc_any(std::move(task))); 
+   }
+});
+FFTVM_REGISTER_METHODS_END();
+#endif
+
+
+
+struct MiMoNode : Node {
+    using Fn        = tvm::ffi::Function;
+    using Any       = tvm::ffi::Any;
+    using ObjectRef = tvm::ffi::ObjectRef;
+
+    struct MiNodeForwarder : ff::ff_minode_t<Any> {
+        Any* svc(Any* t) override {
+            return t;
+        }
+    };
+
+    struct MiMoNodeInternal {
+        MiNodeForwarder m_in;
+        SiMoNode::SiMoNodeImpl m_out;
+
+        template <typename... Args>
+        MiMoNodeInternal(Args&&... args) : 
+            m_in(), 
+            m_out(std::forward<Args>(args)...) {
+            m_out.m_gather = &m_in;
+        }
+    };
+
+    struct MiMoNodeImpl : private MiMoNodeInternal, public ff::ff_comb {
+
+        using ff::ff_comb::ff_send_out; 
+        using ff::ff_comb::ff_send_out_to;
+
+        template <typename... Args>
+        MiMoNodeImpl(Args&&... args) : 
+            MiMoNodeInternal(std::forward<Args>(args)...),
+            ff::ff_comb(&this->m_in, &this->m_out) {}
+
+        SiMoNode::SiMoNodeImpl& out() { return this->m_out; }
+    };
+
+    MiMoNode(Fn svc, int svc_num_args, Fn svc_init, Fn svc_end, Fn eosnotify) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<MiMoNodeImpl>(this, svc, svc_num_args, svc_init, svc_end, eosnotify);
+    }
+
+    MiMoNodeImpl* get() const {
+        return static_cast<MiMoNodeImpl*>(m_object.get());    
+    }
+
+    FFTVM_DECLARE_NODE_INFO(MiMoNode);
+};
+
+
+DEFINE_TVM_OBJECT_REF(MiMoNode);
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(MiMoNode);
+CONSTRUCTOR(tvm::ffi::Function, int, tvm::ffi::Function,  tvm::ffi::Function, tvm::ffi::Function)
+METHOD("ff_send_out_prio", [](MiMoNode* t, tvm::ffi::Any task, int64_t priority) {
+    t->get()->out().ff_send_out(ff_alloc_any_prio(std::move(task), priority));
+});
+METHOD("ff_send_out_deadline", [](MiMoNode* t, tvm::ffi::Any task, int64_t deadline_us) {
+    t->get()->out().ff_send_out(ff_alloc_any_deadline(std::move(task), deadline_us));
+});
+METHOD("configure_expiry", [](MiMoNode* t, tvm::ffi::String mode, tvm::ffi::Optional<tvm::ffi::Function> divert) {
+    t->get()->out().m_expiry.configure(mode, divert.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("expiry_stats", [](MiMoNode* t) {
+    return t->get()->out().m_expiry.stats();
+});
+METHOD("configure_lanes", [](MiMoNode* t, int64_t lanes, int64_t window, int64_t starvation_limit, bool edf, tvm::ffi::Optional<tvm::ffi::Function> classifier) {
+    t->get()->out().m_lanes.configure(size_t(lanes), size_t(window), uint32_t(starvation_limit), edf, classifier.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("lane_stats", [](MiMoNode* t) {
+    return t->get()->out().m_lanes.stats();
+});
+METHOD("configure_routing", [](MiMoNode* t, tvm::ffi::String strategy, tvm::ffi::Optional<tvm::ffi::Function> fn) {
+    t->get()->out().m_router.configure(strategy, fn.value_or(tvm::ffi::Function()));
+    return t;
+});
+METHOD("routing_stats", [](MiMoNode* t) {
+    return t->get()->out().m_router.stats();
+});
+METHOD("ff_send_out", [](MiMoNode* t, tvm::ffi::Any task) {
+    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
+        t->get()->ff_send_out(tkn);
+   } else {
+        t->get()->out().ff_send_out(ff_alloc_any(std::move(task))); 
+   }
+});
+
+METHOD("broadcast", [](MiMoNode* t, tvm::ffi::Any task) {
+    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+        ff_broadcast(t->get(), reinterpret_cast<tvm::ffi::Any*>(task.cast<FFToken_ref>()->key));
+    } else {
+        ff_broadcast(t->get(), ff_alloc_any(std::move(task)));
+    }
+});
+METHOD("ff_send_out_to", [](MiMoNode* t, tvm::ffi::Any task, int id) {
+    if (task.type_index() == FFToken::_GetOrAllocRuntimeTypeIndex()) {
+        void* tkn = reinterpret_cast<void *>(task.cast<FFToken_ref>()->key);
+        t->get()->ff_send_out_to(tkn, id);
+   } else {
+        t->get()->ff_send_out_to(ff_alloc_any(std::move(task)), id); 
+   }
+});
+FFTVM_REGISTER_METHODS_END();
+#endif
+
+
+#ifdef FFTVM_WITH_PYTHON
+// ---------------------------------------------------------------------------
+// InterpreterNode: a SiSo node whose svc is Python code running in its own
+// subinterpreter with its own GIL (CPython >= 3.12), so Python stages in a farm
+// run in parallel. On free-threaded builds there is no GIL to hand off and the
+// node just attaches a thread state of the main interpreter; elsewhere it falls
+// back to the shared GIL. Python objects cannot cross interpreters, so the code
+// is given as source and tasks are converted at the boundary: scalars, strings
+// and containers by value, CPU tensors as memoryviews over their data.
+// ---------------------------------------------------------------------------
+
+namespace py {
+
+constexpr int kMaxDepth = 64;
+
+// A tensor lent to Python for the duration of one call.
+struct View {
+    PyObject* mv;
+    tvm::ffi::Tensor tensor;
+};
+
+// Exporter of a lent tensor's buffer. Memoryviews hold it (as their `obj`),
+// so the tensor outlives any view Python code keeps past the call.
+struct TensorBuffer {
+    PyObject_HEAD
+    struct Lent {
+        tvm::ffi::Tensor tensor;
+        void* buf;
+        Py_ssize_t len, itemsize;
+        const char* format;
+        std::vector<Py_ssize_t> shape, strides;
+    }* lent;
+};
+
+static int tensor_buffer_get(PyObject* self, Py_buffer* view, int flags) {
+    const auto& l = *reinterpret_cast<TensorBuffer*>(self)->lent;
+    if (!(flags & PyBUF_STRIDES) && !l.tensor.IsContiguous()) {
+        PyErr_SetString(PyExc_BufferError, "tensor is not contiguous");
+        view->obj = nullptr;
+        return -1;
+    }
+    view->buf        = l.buf;
+    view->len        = l.len;
+    view->itemsize   = l.itemsize;
+    view->readonly   = 0;
+    view->format     = (flags & PyBUF_FORMAT) ? const_cast<char*>(l.format) : nullptr;
+    view->ndim       = int(l.shape.size());
+    view->shape      = (flags & PyBUF_ND) ? const_cast<Py_ssize_t*>(l.shape.data()) : nullptr;
+    view->strides    = (flags & PyBUF_STRIDES) ? const_cast<Py_ssize_t*>(l.strides.data()) : nullptr;
+    view->suboffsets = nullptr;
+    view->internal   = nullptr;
+    Py_INCREF(self);
+    view->obj        = self;
+    return 0;
+}
+
+static void tensor_buffer_dealloc(PyObject* self) {
+    delete reinterpret_cast<TensorBuffer*>(self)->lent;
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+// A heap type per interpreter (static types cannot be shared by interpreters
+// with their own GIL), made by the node's thread in start().
+static PyObject* new_tensor_buffer_type() {
+    static PyType_Slot slots[] = {
+        {Py_bf_getbuffer, reinterpret_cast<void*>(tensor_buffer_get)},
+        {Py_tp_dealloc,   reinterpret_cast<void*>(tensor_buffer_dealloc)},
+        {0, nullptr},
+    };
+    static PyType_Spec spec = {"fftvm.TensorBuffer", sizeof(TensorBuffer), 0, Py_TPFLAGS_DEFAULT, slots};
+    return PyType_FromSpec(&spec);
+}
+
+// The TensorBuffer type of the interpreter the calling node thread runs.
+static thread_local PyObject* tls_tensor_buffer_type = nullptr;
+
+// Buffer-protocol format of a dtype, nullptr when Python has none.
+static const char* buffer_format(DLDataType dt) {
+    if (dt.lanes != 1) return nullptr;
+    switch (dt.code) {
+        case kDLInt:
+            switch (dt.bits) { case 8: return "b"; case 16: return "h"; case 32: return "i"; case 64: return "q"; }
+            break;
+        case kDLUInt:
+            switch (dt.bits) { case 8: return "B"; case 16: return "H"; case 32: return "I"; case 64: return "Q"; }
+            break;
+        case kDLFloat:
+            switch (dt.bits) { case 16: return "e"; case 32: return "f"; case 64: return "d"; }
+            break;
+        case kDLBool:
+            if (dt.bits == 8) return "?";
+            break;
+    }
+    return nullptr;
+}
+
+// "Type: message" of the pending Python exception, which is cleared.
+static std::string error_message() {
+    PyObject *type, *value, *tb;
+    PyErr_Fetch(&type, &value, &tb);
+    PyErr_NormalizeException(&type, &value, &tb);
+    std::string msg = type ? reinterpret_cast<PyTypeObject*>(type)->tp_name : "unknown error";
+    if (value) {
+        if (PyObject* s = PyObject_Str(value)) {
+            if (const char* c = PyUnicode_AsUTF8(s)) msg = msg + ": " + c;
+            Py_DECREF(s);
+        }
+    }
+    PyErr_Clear();
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(tb);
+    return msg;
+}
+
+static PyObject* tensor_view(const tvm::ffi::Tensor& t, std::vector<View>& views) {
+    if (t->device.device_type != kDLCPU) {
+        PyErr_SetString(PyExc_TypeError, "only CPU tensors can enter an InterpreterNode");
+        return nullptr;
+    }
+    const char* fmt = buffer_format(t->dtype);
+    Py_ssize_t itemsize = (t->dtype.bits * t->dtype.lanes + 7) / 8;
+    std::vector<Py_ssize_t> shape, strides;
+    if (fmt == nullptr) {
+        // No Python equivalent: exposed as flat bytes.
+        if (!t.IsContiguous()) {
+            PyErr_SetString(PyExc_TypeError, "non-contiguous tensor with a dtype Python cannot represent");
+            return nullptr;
+        }
+        fmt = "B";
+        itemsize = 1;
+        shape.push_back(Py_ssize_t(tvm::ffi::GetDataSize(*t.get())));
+        strides.push_back(1);
+    } else {
+        shape.resize(t->ndim);
+        strides.resize(t->ndim);
+        Py_ssize_t compact = itemsize;
+        for (int i = t->ndim - 1; i >= 0; --i) {
+            shape[i] = Py_ssize_t(t->shape[i]);
+            strides[i] = t->strides ? Py_ssize_t(t->strides[i]) * itemsize : compact;
+            compact *= shape[i];
+        }
+    }
+
+    auto type = reinterpret_cast<PyTypeObject*>(tls_tensor_buffer_type);
+    if (type == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "tensors can only enter an InterpreterNode on its own thread");
+        return nullptr;
+    }
+    PyObject* owner = type->tp_alloc(type, 0);
+    if (owner == nullptr) return nullptr;
+    reinterpret_cast<TensorBuffer*>(owner)->lent = new TensorBuffer::Lent{
+        t, static_cast<char*>(t->data) + t->byte_offset, Py_ssize_t(tvm::ffi::GetDataSize(*t.get())),
+        itemsize, fmt, std::move(shape), std::move(strides)};
+    PyObject* mv = PyMemoryView_FromObject(owner);
+    Py_DECREF(owner);  // the view holds it
+    if (mv == nullptr) return nullptr;
+    Py_INCREF(mv);
+    views.push_back({mv, t});
+    return mv;
+}
+
+static PyObject* to_py(const tvm::ffi::Any& v, std::vector<View>& views, int depth = 0) {
+    if (depth > kMaxDepth) {
+        PyErr_SetString(PyExc_ValueError, "task nested too deeply");
+        return nullptr;
+    }
+    switch (v.type_index()) {
+        case TVMFFITypeIndex::kTVMFFINone:
+            Py_RETURN_NONE;
+        case TVMFFITypeIndex::kTVMFFIBool:
+            return PyBool_FromLong(v.cast<bool>());
+        case TVMFFITypeIndex::kTVMFFIInt:
+            return PyLong_FromLongLong(v.cast<int64_t>());
+        case TVMFFITypeIndex::kTVMFFIFloat:
+            return PyFloat_FromDouble(v.cast<double>());
+        case TVMFFITypeIndex::kTVMFFISmallStr:
+        case TVMFFITypeIndex::kTVMFFIStr: {
+            auto s = v.cast<tvm::ffi::String>();
+            return PyUnicode_FromStringAndSize(s.data(), Py_ssize_t(s.size()));
+        }
+        case TVMFFITypeIndex::kTVMFFISmallBytes:
+        case TVMFFITypeIndex::kTVMFFIBytes: {
+            auto b = v.cast<tvm::ffi::Bytes>();
+            return PyBytes_FromStringAndSize(b.data(), Py_ssize_t(b.size()));
+        }
+        case TVMFFITypeIndex::kTVMFFIShape: {
+            auto s = v.cast<tvm::ffi::Shape>();
+            PyObject* tup = PyTuple_New(Py_ssize_t(s.size()));
+            if (tup == nullptr) return nullptr;
+            for (size_t i = 0; i < s.size(); ++i) {
+                PyObject* d = PyLong_FromLongLong(s[i]);
+                if (d == nullptr) { Py_DECREF(tup); return nullptr; }
+                PyTuple_SET_ITEM(tup, Py_ssize_t(i), d);
+            }
+            return tup;
+        }
+        case TVMFFITypeIndex::kTVMFFIArray: {
+            auto a = v.cast<tvm::ffi::Array<tvm::ffi::Any>>();
+            PyObject* list = PyList_New(Py_ssize_t(a.size()));
+            if (list == nullptr) return nullptr;
+            for (size_t i = 0; i < a.size(); ++i) {
+                PyObject* e = to_py(a[i], views, depth + 1);
+                if (e == nullptr) { Py_DECREF(list); return nullptr; }
+                PyList_SET_ITEM(list, Py_ssize_t(i), e);
+            }
+            return list;
+        }
+        case TVMFFITypeIndex::kTVMFFIMap: {
+            auto m = v.cast<tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any>>();
+            PyObject* dict = PyDict_New();
+            if (dict == nullptr) return nullptr;
+            for (const auto& kv : m) {
+                PyObject* k = to_py(kv.first, views, depth + 1);
+                PyObject* e = k ? to_py(kv.second, views, depth + 1) : nullptr;
+                int rc = e ? PyDict_SetItem(dict, k, e) : -1;
+                Py_XDECREF(k);
+                Py_XDECREF(e);
+                if (rc != 0) { Py_DECREF(dict); return nullptr; }
+            }
+            return dict;
+        }
+        case TVMFFITypeIndex::kTVMFFITensor:
+            return tensor_view(v.cast<tvm::ffi::Tensor>(), views);
+        default:
+            PyErr_Format(PyExc_TypeError, "task of type %s cannot enter an InterpreterNode", v.GetTypeKey().c_str());
+            return nullptr;
+    }
+}
+
+// Returns false with a Python exception set when `o` has no task equivalent.
+// A memoryview over a lent tensor gives back that tensor (no copy).
+static bool from_py(PyObject* o, tvm::ffi::Any* out, const std::vector<View>& views, int depth = 0) {
+    if (depth > kMaxDepth) {
+        PyErr_SetString(PyExc_ValueError, "result nested too deeply");
+        return false;
+    }
+    if (o == Py_None) {
+        *out = tvm::ffi::Any();
+    } else if (PyBool_Check(o)) {
+        *out = bool(o == Py_True);
+    } else if (PyLong_Check(o)) {
+        long long v = PyLong_AsLongLong(o);
+        if (v == -1 && PyErr_Occurred()) return false;
+        *out = int64_t(v);
+    } else if (PyFloat_Check(o)) {
+        *out = PyFloat_AS_DOUBLE(o);
+    } else if (PyUnicode_Check(o)) {
+        Py_ssize_t n;
+        const char* s = PyUnicode_AsUTF8AndSize(o, &n);
+        if (s == nullptr) return false;
+        *out = tvm::ffi::String(s, size_t(n));
+    } else if (PyBytes_Check(o)) {
+        *out = tvm::ffi::Bytes(PyBytes_AS_STRING(o), size_t(PyBytes_GET_SIZE(o)));
+    } else if (PyList_Check(o) || PyTuple_Check(o)) {
+        PyObject* seq = PySequence_Fast(o, "");
+        if (seq == nullptr) return false;
+        tvm::ffi::Array<tvm::ffi::Any> a;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); ++i) {
+            tvm::ffi::Any e;
+            if (!from_py(PySequence_Fast_GET_ITEM(seq, i), &e, views, depth + 1)) {
+                Py_DECREF(seq);
+                return false;
+            }
+            a.push_back(e);
+        }
+        Py_DECREF(seq);
+        *out = a;
+    } else if (PyDict_Check(o)) {
+        tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any> m;
+        PyObject *k, *v;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(o, &pos, &k, &v)) {
+            tvm::ffi::Any ka, va;
+            if (!from_py(k, &ka, views, depth + 1) || !from_py(v, &va, views, depth + 1)) return false;
+            m.Set(ka, va);
+        }
+        *out = m;
+    } else if (PyObject_CheckBuffer(o)) {
+        if (PyMemoryView_Check(o)) {
+            const Py_buffer* b = PyMemoryView_GET_BUFFER(o);
+            for (const auto& v : views) {
+                const auto& t = v.tensor;
+                if (b->buf == static_cast<char*>(t->data) + t->byte_offset &&
+                    size_t(b->len) == tvm::ffi::GetDataSize(*t.get())) {
+                    *out = t;
+                    return true;
+                }
+            }
+        }
+        Py_buffer b;
+        if (PyObject_GetBuffer(o, &b, PyBUF_C_CONTIGUOUS) != 0) return false;
+        *out = tvm::ffi::Bytes(static_cast<const char*>(b.buf), size_t(b.len));
+        PyBuffer_Release(&b);
+    } else {
+        PyErr_Format(PyExc_TypeError, "cannot turn a %.200s into a task", Py_TYPE(o)->tp_name);
+        return false;
+    }
+    return true;
+}
+
+// Releases the lent memoryviews: Python code keeping one gets a released view.
+static void release_views(std::vector<View>& views) {
+    for (auto& v : views) {
+        PyObject* r = PyObject_CallMethod(v.mv, "release", nullptr);
+        if (r == nullptr) PyErr_Clear();  // still exported: its TensorBuffer keeps the tensor alive
+        Py_XDECREF(r);
+        Py_DECREF(v.mv);
+    }
+    views.clear();
+}
+
+} // namespace py
+
+struct InterpreterNode : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Counters {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<const char*> mode{"idle"};
+    };
+
+    struct InterpreterNodeImpl : ff::ff_node_t<Any> {
+        std::string m_code, m_entry;
+        bool m_own_gil;
+        Counters& m_counters;
+
+        PyThreadState* m_ts = nullptr;
+        bool m_subinterpreter = false;
+        PyObject* m_globals = nullptr;
+        PyObject* m_svc = nullptr;
+        PyObject* m_go_on = nullptr;
+        PyObject* m_eos = nullptr;
+        PyObject* m_buffer_type = nullptr;
+        std::vector<py::View> m_views;
+
+        InterpreterNodeImpl(std::string code, std::string entry, bool own_gil, Counters& counters)
+            : m_code(std::move(code)), m_entry(std::move(entry)), m_own_gil(own_gil), m_counters(counters) {}
+
+        // Holds the node's thread state for one call.
+        struct Attach {
+            PyThreadState*& m_ts;
+            explicit Attach(PyThreadState*& ts) : m_ts(ts) { PyEval_RestoreThread(ts); }
+            ~Attach() { m_ts = PyEval_SaveThread(); }
+        };
+
+        // ff_send_out(task) as seen by the Python code.
+        static PyObject* py_send_out(PyObject* self, PyObject* arg) {
+            auto node = static_cast<InterpreterNodeImpl*>(PyCapsule_GetPointer(self, nullptr));
+            Any task;
+            if (!py::from_py(arg, &task, node->m_views)) return nullptr;
+            Any* t = ff_alloc_any(std::move(task));
+            bool ok;
+            Py_BEGIN_ALLOW_THREADS
+            ok = node->ff_send_out(t);
+            Py_END_ALLOW_THREADS
+            if (!ok) {
+                ff_free_any(t);
+                PyErr_SetString(PyExc_RuntimeError, "ff_send_out failed");
+                return nullptr;
+            }
+            Py_RETURN_NONE;
+        }
+
+        // Creates the interpreter on the node's thread and runs the code.
+        void start() {
+#if defined(Py_GIL_DISABLED)
+            m_ts = PyThreadState_New(PyInterpreterState_Main());
+            PyEval_RestoreThread(m_ts);
+            m_counters.mode.store("free-threaded");
+#elif PY_VERSION_HEX >= 0x030C0000
+            if (m_own_gil) {
+                PyInterpreterConfig cfg = {};
+                cfg.use_main_obmalloc = 0;
+                cfg.allow_fork = 0;
+                cfg.allow_exec = 0;
+                cfg.allow_threads = 1;
+                cfg.allow_daemon_threads = 0;
+                cfg.check_multi_interp_extensions = 1;
+                cfg.gil = PyInterpreterConfig_OWN_GIL;
+                // it is created from an attached thread state, which this
+                // FastFlow thread does not have yet: borrow one of the main
+                // interpreter, then drop it and attach the new interpreter's
+                PyGILState_STATE gil = PyGILState_Ensure();
+                PyThreadState* main_ts = PyThreadState_Get();
+                PyStatus st = Py_NewInterpreterFromConfig(&m_ts, &cfg);
+                if (!PyStatus_Exception(st)) PyThreadState_Swap(main_ts);
+                PyGILState_Release(gil);
+                tvm_assert(!PyStatus_Exception(st), std::string("InterpreterNode: cannot create a subinterpreter: ") +
+                                                    (st.err_msg ? st.err_msg : "unknown error"));
+                PyEval_RestoreThread(m_ts);
+                m_subinterpreter = true;
+                m_counters.mode.store("subinterpreter");
+            }
+#endif
+            if (m_ts == nullptr) {
+                m_ts = PyThreadState_New(PyInterpreterState_Main());
+                PyEval_RestoreThread(m_ts);
+                m_counters.mode.store("shared-gil");
+            }
+
+            std::string err;
+            m_buffer_type = py::new_tensor_buffer_type();
+            py::tls_tensor_buffer_type = m_buffer_type;
+            static PyMethodDef send_out_def = {"ff_send_out", py_send_out, METH_O, "Pushes a task to the next stage."};
+            m_globals = PyDict_New();
+            m_go_on = PyObject_CallNoArgs(reinterpret_cast<PyObject*>(&PyBaseObject_Type));
+            m_eos = PyObject_CallNoArgs(reinterpret_cast<PyObject*>(&PyBaseObject_Type));
+            PyObject* self = PyCapsule_New(this, nullptr, nullptr);
+            PyObject* send_out = self ? PyCFunction_New(&send_out_def, self) : nullptr;
+            PyObject* name = PyUnicode_FromString("__fftvm__");
+            Py_XDECREF(self);
+            bool ok = m_buffer_type && m_globals && m_go_on && m_eos && send_out && name &&
+                      PyDict_SetItemString(m_globals, "__builtins__", PyEval_GetBuiltins()) == 0 &&
+                      PyDict_SetItemString(m_globals, "__name__", name) == 0 &&
+                      PyDict_SetItemString(m_globals, "GO_ON", m_go_on) == 0 &&
+                      PyDict_SetItemString(m_globals, "EOS", m_eos) == 0 &&
+                      PyDict_SetItemString(m_globals, "ff_send_out", send_out) == 0;
+            Py_XDECREF(send_out);
+            Py_XDECREF(name);
+            if (ok) {
+                PyObject* r = PyRun_String(m_code.c_str(), Py_file_input, m_globals, m_globals);
+                ok = r != nullptr;
+                Py_XDECREF(r);
+            }
+            if (ok) {
+                m_svc = PyDict_GetItemString(m_globals, m_entry.c_str());
+                Py_XINCREF(m_svc);
+                if (m_svc == nullptr || !PyCallable_Check(m_svc)) {
+                    PyErr_Format(PyExc_NameError, "no function '%s' defined by the code", m_entry.c_str());
+                    ok = false;
+                }
+            }
+            if (ok) ok = call_hook("svc_init");
+            if (!ok) {
+                err = py::error_message();
+                stop_attached();
+                tvm_assert(false, "InterpreterNode: " + err);
+            }
+            m_ts = PyEval_SaveThread();
+        }
+
+        bool call_hook(const char* name) {
+            PyObject* fn = PyDict_GetItemString(m_globals, name);
+            if (fn == nullptr) return true;
+            PyObject* r = PyObject_CallNoArgs(fn);
+            Py_XDECREF(r);
+            return r != nullptr;
+        }
+
+        // Tears the interpreter down; the thread state must be attached.
+        void stop_attached() {
+            Py_CLEAR(m_svc);
+            Py_CLEAR(m_go_on);
+            Py_CLEAR(m_eos);
+            Py_CLEAR(m_globals);
+            py::tls_tensor_buffer_type = nullptr;
+            Py_CLEAR(m_buffer_type);  // views kept by the code still hold it
+            if (m_subinterpreter) {
+                Py_EndInterpreter(m_ts);
+            } else {
+                PyThreadState_Clear(m_ts);
+                PyThreadState_DeleteCurrent();
+            }
+            m_ts = nullptr;
+            m_subinterpreter = false;
+        }
+
+        int svc_init() override {
+            start();
+            return 0;
+        }
+
+        Any* svc(Any* t) override {
+            TaskScope scope(t);
+            Any out;
+            PyObject* r = nullptr;
+            bool eos = false, go_on = false;
+            {
+                Attach attach(m_ts);
+                PyObject* arg = t != nullptr ? py::to_py(*t, m_views) : (Py_INCREF(Py_None), Py_None);
+                if (arg != nullptr) {
+                    r = PyObject_CallOneArg(m_svc, arg);
+                    Py_DECREF(arg);
+                }
+                eos = r != nullptr && r == m_eos;
+                go_on = r != nullptr && r == m_go_on;
+                bool ok = r != nullptr && (eos || go_on || py::from_py(r, &out, m_views));
+                std::string err = ok ? std::string() : py::error_message();
+                py::release_views(m_views);
+                Py_XDECREF(r);
+                tvm_assert(ok, "InterpreterNode: " + err);
+            }
+            ff_free_any(t);
+            m_counters.tasks.fetch_add(1, std::memory_order_relaxed);
+            if (eos) return EOS;
+            if (go_on || out.type_index() == TVMFFITypeIndex::kTVMFFINone) {
+                scope.dropped();
+                return GO_ON;
+            }
+            return ff_alloc_any(std::move(out));
+        }
+
+        void svc_end() override {
+            if (m_ts == nullptr) return;
+            PyEval_RestoreThread(m_ts);
+            if (!call_hook("svc_end")) PyErr_Clear();
+            stop_attached();
+        }
+    };
+
+    Counters m_counters;
+
+    InterpreterNode(tvm::ffi::String code, tvm::ffi::String entry, bool own_gil) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<InterpreterNodeImpl>(std::string(code), std::string(entry), own_gil, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("tasks", int64_t(m_counters.tasks.load(std::memory_order_relaxed)));
+        m.Set("mode",  tvm::ffi::String(m_counters.mode.load()));
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(InterpreterNode);
+};
+
+DEFINE_TVM_OBJECT_REF(InterpreterNode)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(InterpreterNode)
+    CONSTRUCTOR(tvm::ffi::String, tvm::ffi::String, bool)
+    METHOD("stats", [](InterpreterNode* n) {
+        return n->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+#endif // FFTVM_WITH_PYTHON
+
+
+struct Pipeline : Node {
+    Pipeline() : Node(ff::ff_pipeline()) {}
+    
+    std::vector<tvm::ffi::Any> m_owned_deps;
+
+    ff::ff_pipeline* get() const {
+        return static_cast<ff::ff_pipeline*>(m_object.get());    
+    }
+
+    void add_stage(const Node_ref& n) {
+        m_owned_deps.emplace_back(n);
+        get()->add_stage(n->m_object.get());
+    }
+
+    FFTVM_DECLARE_NODE_INFO(Pipeline);
+};
+
+DEFINE_TVM_OBJECT_REF(Pipeline)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Pipeline)
+    CONSTRUCTOR();
+
+    METHOD("add_stage", [](Pipeline* t, Node_ref n){
+        t->add_stage(n);
+        return t;
+    })
+
+    METHOD("run", [](Pipeline* t, bool skip_init = false) {
+        t->get()->run();
+    })
+
+    METHOD("wait", [](Pipeline* t) {
+        t->get()->wait();
+    })
+
+    METHOD("run_and_wait_end", [](Pipeline* t) {
+        t->get()->run_and_wait_end();
+    })
+
+    METHOD("wrap_around", [](Pipeline* t) {
+        tvm_assert(t->get()->wrap_around() == 0, "error while calling ff_pipeline::wrap_around");
+        return t;
+    })
+
+    // Threads sleep on empty channels instead of spinning (set before running).
+    METHOD("blocking_mode", [](Pipeline* t, bool blocking) {
+        t->get()->blocking_mode(blocking);
+        return t;
+    })
+
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// Native iterative loop: a pipeline LoopEntry -> body... -> LoopExit wrapped
+// around. Tasks entering from upstream start at iteration 0 (the count lives in
+// TaskMeta, so tasks the body derives from them keep it). At the exit a task
+// leaves the loop, forwarded downstream, when `converged(task)` is true or it
+// has completed `max_iterations` trips (0 = no limit); otherwise it goes
+// around again. The entry counts the tasks inside the loop and sends EOS once
+// upstream has ended and the last one has left, so every task must come out
+// of the body as exactly one task. Tasks inside the body are marked (see
+// TaskMeta::loops): a body node dropping one, which would leave the loop
+// waiting forever, fails instead, and so does the exit seeing more tasks
+// leave than entered.
+struct Loop : Node {
+    using Any = tvm::ffi::Any;
+
+    // Sent by the exit through the feedback channel when the loop drained after
+    // upstream EOS, to wake the entry up.
+    static constexpr uint32_t kDrained = UINT32_MAX;
+
+    struct State {
+        int64_t max_iterations;
+        tvm::ffi::Function converged;
+        std::atomic<int64_t> in_flight{0};
+        std::atomic<bool> upstream_done{false}, eos_claimed{false};
+        std::atomic<uint64_t> entered{0}, iterations{0}, converged_count{0}, exhausted{0};
+
+        // Entry and exit both check for the end; only one sends EOS.
+        bool claim_eos() {
+            return upstream_done.load() && in_flight.load() == 0 && !eos_claimed.exchange(true);
+        }
+    };
+
+    struct Entry : ff::ff_minode_t<Any> {
+        State& m_state;
+        size_t m_upstream_eos = 0;
+
+        explicit Entry(State& state) : m_state(state) {}
+
+        int svc_init() override {
+            m_upstream_eos = 0;
+            m_state.in_flight = 0;
+            m_state.upstream_done = false;
+            m_state.eos_claimed = false;
+            return 0;
+        }
+
+        Any* svc(Any* t) override {
+            if (fromInput()) {
+                t = ff_unshare(t);
+                task_meta(t)->iteration = 0;
+                task_meta(t)->loops++;
+                m_state.in_flight++;
+                m_state.entered.fetch_add(1, std::memory_order_relaxed);
+                return t;
+            }
+            if (task_meta(t)->iteration == kDrained) {
+                ff_free_any(t);
+                return EOS;
+            }
+            return t;
+        }
+
+        void eosnotify(ssize_t) override {
+            if (m_state.eos_claimed.load()) return;  // our own EOS coming back
+            size_t in = get_num_inchannels(), feedback = get_num_feedbackchannels();
+            size_t upstream = in > feedback ? in - feedback : 1;
+            if (++m_upstream_eos < upstream) return;
+            m_state.upstream_done = true;
+            if (m_state.claim_eos()) ff_send_out(EOS);
+        }
+    };
+
+    struct Exit : ff::ff_monode_t<Any> {
+        State& m_state;
+
+        explicit Exit(State& state) : m_state(state) {}
+
+        bool done(Any* t) {
+            auto meta = task_meta(t);
+            if (m_state.converged.defined() && m_state.converged(*t).cast<bool>()) {
+                m_state.converged_count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (m_state.max_iterations > 0 && int64_t(meta->iteration) + 1 >= m_state.max_iterations) {
+                m_state.exhausted.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        Any* svc(Any* t) override {
+            m_state.iterations.fetch_add(1, std::memory_order_relaxed);
+            if (!done(t)) {
+                t = ff_unshare(t);
+                task_meta(t)->iteration++;
+                ff_send_out_to(t, 0);  // feedback channels come first
+                return GO_ON;
+            }
+
+            tvm_assert(m_state.in_flight.fetch_sub(1) > 0,
+                       "Loop: more tasks left the body than entered it; every task must come out of the "
+                       "loop body as exactly one task");
+
+            // forward downstream, or drop when the loop is the last stage
+            t = ff_unshare(t);
+            auto meta = task_meta(t);
+            if (meta->loops > 0) meta->loops--;
+            size_t feedback = get_num_feedbackchannels();
+            if (get_num_outchannels() > feedback) ff_send_out_to(t, int(feedback));
+            else ff_free_any(t);
+
+            if (m_state.claim_eos()) {
+                Any* wake = ff_alloc_any(Any());
+                task_meta(wake)->iteration = kDrained;
+                ff_send_out_to(wake, 0);
+            }
+            return GO_ON;
+        }
+    };
+
+    State m_state;
+    std::unique_ptr<Entry> m_entry;
+    std::unique_ptr<Exit> m_exit;
+    std::vector<tvm::ffi::Any> m_owned_deps;
+
+    Loop(tvm::ffi::Array<Node_ref> body, int64_t max_iterations, tvm::ffi::Optional<tvm::ffi::Function> converged)
+        : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(!body.empty(), "Loop: the body needs at least one stage");
+        tvm_assert(max_iterations >= 0, "Loop: max_iterations must be >= 0");
+        tvm_assert(max_iterations > 0 || converged.has_value(), "Loop: needs max_iterations or converged, or it never ends");
+        m_state.max_iterations = max_iterations;
+        m_state.converged = converged.value_or(tvm::ffi::Function());
+        m_entry = std::make_unique<Entry>(m_state);
+        m_exit = std::make_unique<Exit>(m_state);
+
+        auto pipe = std::make_unique<ff::ff_pipeline>();
+        pipe->add_stage(m_entry.get());
+        for (const auto& n : body) {
+            pipe->add_stage(n->m_object.get());
+            m_owned_deps.emplace_back(n);
+        }
+        pipe->add_stage(m_exit.get());
+        tvm_assert(pipe->wrap_around() == 0, "Loop: error while calling ff_pipeline::wrap_around");
+        m_object = std::move(pipe);
+    }
+
+    ~Loop() {
+        m_object.reset();  // the pipeline goes before the entry/exit it points to
+    }
+
+    ff::ff_pipeline* get() const {
+        return static_cast<ff::ff_pipeline*>(m_object.get());
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("entered",    int64_t(m_state.entered.load(std::memory_order_relaxed)));
+        m.Set("iterations", int64_t(m_state.iterations.load(std::memory_order_relaxed)));
+        m.Set("converged",  int64_t(m_state.converged_count.load(std::memory_order_relaxed)));
+        m.Set("exhausted",  int64_t(m_state.exhausted.load(std::memory_order_relaxed)));
+        m.Set("in_flight",  m_state.in_flight.load());
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(Loop);
+};
+
+DEFINE_TVM_OBJECT_REF(Loop)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Loop)
+    CONSTRUCTOR(tvm::ffi::Array<Node_ref>, int64_t, tvm::ffi::Optional<tvm::ffi::Function>)
+    METHOD("stats", [](Loop* l) {
+        return l->stats();
+    })
+    METHOD("run_and_wait_end", [](Loop* l) {
+        l->get()->run_and_wait_end();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+
+struct Farm : Node {
+    Farm() : Node(ff::ff_farm()) {}
+
+    std::vector<tvm::ffi::Any> m_owned_deps;
+
+    ff::ff_farm* get() const {
+        return static_cast<ff::ff_farm*>(m_object.get());    
+    }
+
+    void add_workers(const tvm::ffi::Array<Node_ref>& w) {
+        std::set<ff::ff_node *> ptr_set;
+        for (const auto& n : w) {
+            auto ptr = n->m_object.get();
+            tvm_assert(ptr_set.find(ptr) == ptr_set.end(), 
+            "You are trying to construct a farm with multiple instances of the same fastflow node! "
+                "Common python error: farm.add_workers([worker_node] * N). Tips: you must construct workers indipendently!"
+            );
+
+            ptr_set.insert(ptr);
+        }
+
+        get()->add_workers(std::vector<ff::ff_node *>(ptr_set.begin(), ptr_set.end()));
+
+        for (const auto& n : w) {
+            m_owned_deps.emplace_back(n);
+        }
+    }
+
+    // No node: FastFlow's default collector.
+    void add_collector(const tvm::ffi::Optional<Node_ref>& copt) {
+        if (!copt.has_value()) {
+            get()->add_collector(nullptr);
+            return;
+        }
+
+        get()->add_collector(copt.value()->m_object.get());
+        m_owned_deps.emplace_back(copt.value());
+    }
+
+    void add_emitter(const tvm::ffi::Optional<Node_ref>& eopt) {
+        if (!eopt.has_value()) {
+            get()->add_collector(nullptr);
+            return;
+        }
+
+        get()->add_emitter(eopt.value()->m_object.get());
+        m_owned_deps.emplace_back(eopt.value());
+    }
+
+    FFTVM_DECLARE_NODE_INFO(Farm);
+    
+};
+
+DEFINE_TVM_OBJECT_REF(Farm)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Farm)
+    CONSTRUCTOR()
+    METHOD("add_workers", [](Farm* f, tvm::ffi::Array<Node_ref> w) {
+        f->add_workers(w);
+        return f;
+    })
+    
+    METHOD("add_collector", [](Farm* f, tvm::ffi::Optional<Node_ref> copt) {
+        f->add_collector(copt);
+        return f;
+    })
+
+    METHOD("add_emitter", [](Farm* f, tvm::ffi::Optional<Node_ref> eopt) {
+        f->add_emitter(eopt);
+        return f;
+    })
+
+    METHOD("wrap_around", [](Farm* f) {
+        tvm_assert(f->get()->wrap_around() == 0, "error while calling ff_farm::wrap_around");
+        return f;
+    })
+
+    METHOD("blocking_mode", [](Farm* f, bool blocking) {
+        f->get()->blocking_mode(blocking);
+        return f;
+    })
+
+    METHOD("set_scheduling_ondemand", [](Farm* f, int64_t inbufferentries) {
+        f->get()->set_scheduling_ondemand(int(inbufferentries));
+        return f;
+    })
+
+    METHOD("run_and_wait_end", [](Farm* t) {
+        t->get()->run_and_wait_end();
+    })
+
+    
+    METHOD("debug_info", [](Farm* f) {
+        std::cout << "FarmNode debug infos:" << std::endl;
+        std::cout << "Cardinality: " << f->get()->cardinality() << std::endl;
+        std::cout << "isMultiOutput: " << f->get()->isMultiOutput() << std::endl;
+        std::cout << "isMultiInput: " << f->get()->isMultiInput() << std::endl;
+        // std::cout << "get_num_inchannels: " << f->get()->get_num_inchannels() << std::endl;
+        // std::cout << "get_num_outchannels: " << f->get()->get_num_outchannels() << std::endl;
+        std::cout << std::endl;
+
+        return f;
+    });
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// ElasticFarm: a farm that keeps a fixed pool of worker threads but only feeds
+// the first `active` of them (at most `max_workers`). Workers that stop
+// receiving tasks block on their (empty) input channel, so with blocking mode
+// enabled (the default) they give their core back until the policy thaws
+// them again.
+//
+// The emitter dispatches every task to the active worker with the shortest
+// backlog (tasks sent but not yet seen by the collector). The number of
+// active workers is re-evaluated every `interval_ms`, by the emitter when a
+// task arrives and by a timer thread while none does, so an idle farm scales
+// down too. Scaling up/down only happens after `hysteresis` consecutive
+// samples agree, to avoid flapping.
+//
+// NOTE: backlog is measured as sent - collected, so workers are expected to
+// produce one result per task (the usual map-like farm).
+struct ElasticFarm : Node {
+    using Any   = tvm::ffi::Any;
+    using Clock = std::chrono::steady_clock;
+
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> v{0};
+    };
+
+    struct Event {
+        int64_t t_ms;
+        int64_t from;
+        int64_t to;
+    };
+
+    struct State {
+        int64_t min_workers;
+        int64_t max_workers;  // 0 = the whole pool
+        double  scale_up_backlog;
+        double  scale_down_backlog;
+        double  scale_down_utilization;
+        int64_t hysteresis;
+        int64_t interval_ms;
+
+        size_t nworkers = 0;
+        std::vector<Counter> sent, done;
+        std::atomic<int64_t> active{0};
+        std::atomic<uint64_t> scale_up_events{0}, scale_down_events{0};
+
+        std::mutex events_mtx;
+        std::vector<Event> events;
+        Clock::time_point t0;
+
+        uint64_t backlog(size_t i) const {
+            uint64_t s = sent[i].v.load(std::memory_order_relaxed);
+            uint64_t d = done[i].v.load(std::memory_order_relaxed);
+            return s > d ? s - d : 0;
+        }
+
+        int64_t limit() const {
+            return max_workers > 0 ? std::min<int64_t>(max_workers, nworkers) : int64_t(nworkers);
+        }
+    };
+
+    struct Emitter : ff::ff_monode_t<Any> {
+        State* m_state;
+        std::mutex m_mtx;  // sampling state, m_stop
+        std::condition_variable m_cv;
+        bool m_stop = false;
+        std::thread m_timer;
+        int64_t m_up_streak = 0, m_down_streak = 0;
+        Clock::time_point m_last_sample;
+
+        explicit Emitter(State* state) : m_state(state) {}
+
+        ~Emitter() { stop_timer(); }
+
+        int svc_init() override {
+            auto& s = *m_state;
+            tvm_assert(s.nworkers > 0, "ElasticFarm has no workers");
+            for (size_t i = 0; i < s.nworkers; ++i) {
+                s.sent[i].v.store(0, std::memory_order_relaxed);
+                s.done[i].v.store(0, std::memory_order_relaxed);
+            }
+            int64_t initial = std::clamp<int64_t>(s.min_workers, 1, s.limit());
+            s.active.store(initial, std::memory_order_relaxed);
+            s.scale_up_events.store(0, std::memory_order_relaxed);
+            s.scale_down_events.store(0, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lk(s.events_mtx);
+                s.events.clear();
+            }
+            s.t0 = m_last_sample = Clock::now();
+            m_up_streak = m_down_streak = 0;
+            stop_timer();  // left running by a run that did not reach svc_end
+            m_stop = false;
+            m_timer = std::thread([this] {
+                auto period = std::chrono::milliseconds(std::max<int64_t>(m_state->interval_ms, 1));
+                std::unique_lock<std::mutex> lk(m_mtx);
+                while (!m_cv.wait_for(lk, period, [this] { return m_stop; })) sample();
+            });
+            return 0;
+        }
+
+        void stop_timer() {
+            if (!m_timer.joinable()) return;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            m_timer.join();
+        }
+
+        void svc_end() override { stop_timer(); }
+
+        void rescale(int64_t from, int64_t to) {
+            auto& s = *m_state;
+            s.active.store(to, std::memory_order_relaxed);
+            (to > from ? s.scale_up_events : s.scale_down_events).fetch_add(1, std::memory_order_relaxed);
+            auto t_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - s.t0).count();
+            std::lock_guard<std::mutex> lk(s.events_mtx);
+            s.events.push_back({t_ms, from, to});
+        }
+
+        // With m_mtx held.
+        void sample() {
+            auto& s = *m_state;
+            auto now = Clock::now();
+            if (now - m_last_sample < std::chrono::milliseconds(s.interval_ms)) return;
+            m_last_sample = now;
+
+            int64_t active = s.active.load(std::memory_order_relaxed);
+            uint64_t total = 0;
+            int64_t busy = 0;
+            for (int64_t i = 0; i < active; ++i) {
+                uint64_t b = s.backlog(i);
+                total += b;
+                busy  += b > 0;
+            }
+
+            double avg_backlog = double(total) / active;
+            double utilization = double(busy) / active;
+
+            bool want_up   = avg_backlog >= s.scale_up_backlog && active < s.limit();
+            bool want_down = avg_backlog <= s.scale_down_backlog
+                          && utilization <= s.scale_down_utilization
+                          && active > std::max<int64_t>(s.min_workers, 1);
+
+            m_up_streak   = want_up   ? m_up_streak + 1   : 0;
+            m_down_streak = want_down ? m_down_streak + 1 : 0;
+
+            if (m_up_streak >= s.hysteresis) {
+                rescale(active, active + 1);
+                m_up_streak = 0;
+            } else if (m_down_streak >= s.hysteresis) {
+                rescale(active, active - 1);
+                m_down_streak = 0;
+            }
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t != nullptr, "ElasticFarm must be fed by an upstream stage");
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                sample();
+            }
+
+            auto& s = *m_state;
+            int64_t active = s.active.load(std::memory_order_relaxed);
+            int64_t target = 0;
+            uint64_t best = UINT64_MAX;
+            for (int64_t i = 0; i < active && best != 0; ++i) {
+                uint64_t b = s.backlog(i);
+                if (b < best) {
+                    best = b;
+                    target = i;
+                }
+            }
+
+            s.sent[target].v.fetch_add(1, std::memory_order_relaxed);
+            ff_send_out_to(t, target);
+            return GO_ON;
+        }
+    };
+
+    struct Collector : ff::ff_minode_t<Any> {
+        State* m_state;
+
+        explicit Collector(State* state) : m_state(state) {}
+
+        Any* svc(Any* t) override {
+            ssize_t id = get_channel_id();
+            if (id >= 0 && size_t(id) < m_state->nworkers) {
+                m_state->done[id].v.fetch_add(1, std::memory_order_relaxed);
+            }
+            return t;
+        }
+    };
+
+    std::unique_ptr<State> m_state;
+    std::unique_ptr<Emitter> m_emitter;
+    std::unique_ptr<Collector> m_collector;
+    std::vector<ff::ff_node *> m_workers;
+    std::vector<tvm::ffi::Any> m_owned_deps;
+
+    ElasticFarm(int64_t min_workers, double scale_up_backlog, double scale_down_backlog,
+                double scale_down_utilization, int64_t hysteresis, int64_t interval_ms,
+                int64_t max_workers, bool blocking)
+        : Node(ff::ff_farm()), m_state(std::make_unique<State>())
+    {
+        tvm_assert(min_workers >= 1, "ElasticFarm: min_workers must be >= 1");
+        tvm_assert(max_workers == 0 || max_workers >= min_workers, "ElasticFarm: max_workers must be 0 or >= min_workers");
+        tvm_assert(scale_up_backlog > scale_down_backlog, "ElasticFarm: scale_up_backlog must be greater than scale_down_backlog");
+        tvm_assert(hysteresis >= 1, "ElasticFarm: hysteresis must be >= 1");
+        tvm_assert(interval_ms >= 0, "ElasticFarm: interval_ms must be >= 0");
+
+        m_state->min_workers            = min_workers;
+        m_state->max_workers            = max_workers;
+        m_state->scale_up_backlog       = scale_up_backlog;
+        m_state->scale_down_backlog     = scale_down_backlog;
+        m_state->scale_down_utilization = scale_down_utilization;
+        m_state->hysteresis             = hysteresis;
+        m_state->interval_ms            = interval_ms;
+
+        m_emitter   = std::make_unique<Emitter>(m_state.get());
+        m_collector = std::make_unique<Collector>(m_state.get());
+
+        get()->add_emitter(m_emitter.get());
+        get()->add_collector(m_collector.get());
+        // parked workers sleep on their empty channel instead of spinning
+        get()->blocking_mode(blocking);
+    }
+
+    ff::ff_farm* get() const {
+        return static_cast<ff::ff_farm*>(m_object.get());
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        auto& s = *m_state;
+        tvm::ffi::Array<int64_t> dispatched, completed;
+        for (size_t i = 0; i < s.nworkers; ++i) {
+            dispatched.push_back(int64_t(s.sent[i].v.load(std::memory_order_relaxed)));
+            completed.push_back(int64_t(s.done[i].v.load(std::memory_order_relaxed)));
+        }
+
+        tvm::ffi::Array<tvm::ffi::Any> events;
+        {
+            std::lock_guard<std::mutex> lk(s.events_mtx);
+            for (const auto& e : s.events) {
+                events.push_back(tvm::ffi::Array<int64_t>{e.t_ms, e.from, e.to});
+            }
+        }
+
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("workers",           int64_t(s.nworkers));
+        m.Set("min_workers",       s.min_workers);
+        m.Set("max_workers",       s.limit());
+        m.Set("active_workers",    s.active.load(std::memory_order_relaxed));
+        m.Set("scale_up_events",   int64_t(s.scale_up_events.load(std::memory_order_relaxed)));
+        m.Set("scale_down_events", int64_t(s.scale_down_events.load(std::memory_order_relaxed)));
+        m.Set("events",            events);
+        m.Set("dispatched",        dispatched);
+        m.Set("completed",         completed);
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(ElasticFarm);
+};
+
+DEFINE_TVM_OBJECT_REF(ElasticFarm)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(ElasticFarm)
+    CONSTRUCTOR(int64_t, double, double, double, int64_t, int64_t, int64_t, bool)
+    METHOD("add_workers", [](ElasticFarm* f, tvm::ffi::Array<Node_ref> w) {
+        std::set<ff::ff_node *> ptr_set(f->m_workers.begin(), f->m_workers.end());
+        std::vector<ff::ff_node *> added;
+        for (const auto& n : w) {
+            auto ptr = n->m_object.get();
+            tvm_assert(ptr_set.find(ptr) == ptr_set.end(),
+            "You are trying to construct a farm with multiple instances of the same fastflow node! "
+                "Common python error: farm.add_workers([worker_node] * N). Tips: you must construct workers indipendently!"
+            );
+
+            ptr_set.insert(ptr);
+            added.push_back(ptr);
+        }
+
+        f->get()->add_workers(added);
+        f->m_workers.insert(f->m_workers.end(), added.begin(), added.end());
+
+        auto& s = *f->m_state;
+        s.nworkers = f->m_workers.size();
+        s.sent = std::vector<ElasticFarm::Counter>(s.nworkers);
+        s.done = std::vector<ElasticFarm::Counter>(s.nworkers);
+
+        for (const auto& n : w) {
+            f->m_owned_deps.emplace_back(n);
+        }
+        return f;
+    })
+
+    METHOD("run_and_wait_end", [](ElasticFarm* t) {
+        t->get()->run_and_wait_end();
+    })
+
+    METHOD("stats", [](ElasticFarm* f) {
+        return f->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// StealingFarm: farm variant for irregular task costs. The emitter only seeds
+// tasks round-robin into per-worker deques; the FastFlow channels towards the
+// workers carry just "doorbells" to wake parked workers. A worker drains its
+// own deque from the front and, when it runs dry, steals half of the longest
+// peer deque from the back.
+//
+// Workers must be SiSoNodes: their implementation is swapped with a
+// StealWorker that keeps the user callbacks (so self.ff_send_out still works)
+// but owns the dispatch loop.
+struct StealingFarm : Node {
+    using Any = tvm::ffi::Any;
+
+    struct alignas(64) Deque {
+        std::mutex mtx;
+        std::deque<Any*> q;
+        std::atomic<size_t> size{0};
+        std::atomic<bool> parked{true};
+        std::atomic<bool> retired{false};
+        std::atomic<uint64_t> executed{0}, stolen{0};
+
+        // seq_cst: pairs with the parked flag (store size, load parked here;
+        // store parked, load size in the worker), so either the seeder sees
+        // the worker parked or the worker sees the task.
+        void push_back(Any* t) {
+            std::lock_guard<std::mutex> lk(mtx);
+            q.push_back(t);
+            size.store(q.size(), std::memory_order_seq_cst);
+        }
+
+        Any* pop_front() {
+            if (size.load(std::memory_order_acquire) == 0) return nullptr;
+            std::lock_guard<std::mutex> lk(mtx);
+            if (q.empty()) return nullptr;
+            Any* t = q.front();
+            q.pop_front();
+            size.store(q.size(), std::memory_order_release);
+            return t;
+        }
+
+        // moves up to half of the tasks (at least one) from the back of this deque into `out`
+        size_t steal_half(std::vector<Any*>& out) {
+            std::lock_guard<std::mutex> lk(mtx);
+            size_t n = (q.size() + 1) / 2;
+            for (size_t i = 0; i < n; ++i) {
+                out.push_back(q.back());
+                q.pop_back();
+            }
+            size.store(q.size(), std::memory_order_release);
+            return n;
+        }
+    };
+
+    struct State {
+        std::vector<Deque> deques;
+    };
+
+    // Not a real task: wakes up a parked worker.
+    static Any* doorbell() {
+        static Any bell;
+        return &bell;
+    }
+
+    struct StealWorker : SiSoNode::SiSoNodeImpl {
+        State* m_state;
+        size_t m_id;
+        std::vector<Any*> m_loot;
+        bool m_retired = false;
+
+        StealWorker(State* state, size_t id, SiSoNode* self, SiSoNode::Fn svc, int svc_num_args,
+                    SiSoNode::Fn svc_init, SiSoNode::Fn svc_end, SiSoNode::Fn eosnotify) :
+            SiSoNodeImpl(self, svc, svc_num_args, svc_init, svc_end, eosnotify), m_state(state), m_id(id) {}
+
+        // Lanes and vectorized svc reorder or batch what the worker receives,
+        // but a stealing worker takes its tasks from the deques instead.
+        static bool adoptable(const SiSoNodeImpl& from) {
+            return !from.m_lanes.enabled() && !from.m_vector.enabled();
+        }
+
+        // Keeps what was configured on the node before it joined the farm.
+        void adopt(const SiSoNodeImpl& from) {
+            m_expiry.m_mode = from.m_expiry.m_mode;
+            m_expiry.m_divert = from.m_expiry.m_divert;
+            m_latency.configure(from.m_latency.m_stamp, from.m_latency.m_record);
+            m_perf.m_mode = from.m_perf.m_mode;
+            m_budget = from.m_budget;
+        }
+
+        int svc_init() override {
+            m_retired = false;
+            return SiSoNodeImpl::svc_init();
+        }
+
+        Any* steal() {
+            auto& deques = m_state->deques;
+            size_t victim = m_id, longest = 0;
+            for (size_t i = 0; i < deques.size(); ++i) {
+                if (i == m_id) continue;
+                size_t sz = deques[i].size.load(std::memory_order_acquire);
+                if (sz > longest) {
+                    longest = sz;
+                    victim = i;
+                }
+            }
+            if (longest == 0) return nullptr;
+
+            m_loot.clear();
+            deques[victim].steal_half(m_loot);
+            if (m_loot.empty()) return nullptr;
+
+            auto& own = deques[m_id];
+            own.stolen.fetch_add(m_loot.size(), std::memory_order_relaxed);
+            // keep the first stolen task, park the others in our own deque
+            for (size_t i = 1; i < m_loot.size(); ++i) own.push_back(m_loot[i]);
+            return m_loot[0];
+        }
+
+        bool any_work() const {
+            for (auto& d : m_state->deques) {
+                if (d.size.load(std::memory_order_seq_cst) > 0) return true;
+            }
+            return false;
+        }
+
+        // Runs tasks until there is none left to take; returns GO_ON, or the
+        // first other token (EOS, GO_OUT) svc returned, which ends the worker.
+        Any* drain() {
+            auto& own = m_state->deques[m_id];
+            while (true) {
+                Any* t = own.pop_front();
+                if (t == nullptr) t = steal();
+                if (t == nullptr) return GO_ON;
+
+                Any* r;
+                {
+                    PerfCounters::Scope perf(m_perf);
+                    r = SiSoNodeImpl::process(t);
+                }
+                own.executed.fetch_add(1, std::memory_order_relaxed);
+                if (!ff_is_token(r)) {
+                    ff_send_out(r);
+                } else if (r != GO_ON) {
+                    // left parked == false: the seeder never rings us again,
+                    // and what is left in our deque goes to the peers
+                    m_retired = true;
+                    own.retired.store(true);
+                    return r;
+                }
+            }
+        }
+
+        Any* svc(Any* t) override {
+            if (t != doorbell()) {
+                // tasks are only expected through the deques
+                m_state->deques[m_id].push_back(t);
+            }
+
+            auto& own = m_state->deques[m_id];
+            own.parked.store(false, std::memory_order_relaxed);
+            while (true) {
+                Any* r = drain();
+                if (r != GO_ON) return r;
+                own.parked.store(true, std::memory_order_seq_cst);
+                // a task may have been seeded after our last look: if we can
+                // un-park ourselves nobody else will ring us, so keep going.
+                if (!any_work() || !own.parked.exchange(false)) break;
+            }
+            return GO_ON;
+        }
+
+        void eosnotify(ssize_t id) override {
+            // the seeder is done: everything left in the deques is ours to steal
+            m_state->deques[m_id].parked.store(false);
+            if (!m_retired) drain();
+            SiSoNodeImpl::eosnotify(id);
+        }
+    };
+
+    struct Seeder : ff::ff_monode_t<Any> {
+        State* m_state;
+        size_t m_next = 0;
+
+        explicit Seeder(State* state) : m_state(state) {}
+
+        // Workers only touch the deques after a doorbell or our EOS, so this
+        // is the place to undo what the previous run left behind.
+        int svc_init() override {
+            m_next = 0;
+            for (auto& d : m_state->deques) {
+                d.parked.store(true);
+                d.retired.store(false);
+                d.executed.store(0, std::memory_order_relaxed);
+                d.stolen.store(0, std::memory_order_relaxed);
+            }
+            return 0;
+        }
+
+        static bool ring(Deque& d) {
+            return d.parked.load(std::memory_order_seq_cst) && d.parked.exchange(false);
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t != nullptr, "StealingFarm must be fed by an upstream stage");
+            auto& deques = m_state->deques;
+            size_t target = m_next;
+            for (size_t i = 0; i < deques.size() && deques[target].retired.load(); ++i) {
+                target = (target + 1) % deques.size();
+            }
+            m_next = (target + 1) % deques.size();
+
+            deques[target].push_back(t);
+            // one doorbell per task: the owner if it is parked, otherwise a
+            // parked peer that will steal it. Busy workers find it on their own.
+            if (ring(deques[target])) {
+                ff_send_out_to(doorbell(), target);
+                return GO_ON;
+            }
+            for (size_t i = 1; i < deques.size(); ++i) {
+                size_t peer = (target + i) % deques.size();
+                if (ring(deques[peer])) {
+                    ff_send_out_to(doorbell(), peer);
+                    break;
+                }
+            }
+            return GO_ON;
+        }
+    };
+
+    std::unique_ptr<State> m_state;
+    std::unique_ptr<Seeder> m_seeder;
+    std::vector<tvm::ffi::Any> m_owned_deps;
+    bool m_has_workers = false;
+
+    StealingFarm() : Node(ff::ff_farm()), m_state(std::make_unique<State>()) {
+        m_seeder = std::make_unique<Seeder>(m_state.get());
+        get()->add_emitter(m_seeder.get());
+    }
+
+    ff::ff_farm* get() const {
+        return static_cast<ff::ff_farm*>(m_object.get());
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Array<int64_t> executed, stolen;
+        for (auto& d : m_state->deques) {
+            executed.push_back(int64_t(d.executed.load(std::memory_order_relaxed)));
+            stolen.push_back(int64_t(d.stolen.load(std::memory_order_relaxed)));
+        }
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("workers",  int64_t(m_state->deques.size()));
+        m.Set("executed", executed);
+        m.Set("stolen",   stolen);
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(StealingFarm);
+};
+
+DEFINE_TVM_OBJECT_REF(StealingFarm)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(StealingFarm)
+    CONSTRUCTOR()
+    METHOD("add_workers", [](StealingFarm* f, tvm::ffi::Array<SiSoNode_ref> w) {
+        tvm_assert(!f->m_has_workers, "StealingFarm: add_workers can only be called once");
+        std::set<const SiSoNode *> obj_set;
+        for (const auto& n : w) {
+            tvm_assert(obj_set.find(n.get()) == obj_set.end(),
+            "You are trying to construct a farm with multiple instances of the same fastflow node! "
+                "Common python error: farm.add_workers([worker_node] * N). Tips: you must construct workers indipendently!"
+            );
+            obj_set.insert(n.get());
+            tvm_assert(StealingFarm::StealWorker::adoptable(*n->get()),
+                       "StealingFarm: workers cannot use priority lanes or a vectorized svc");
+        }
+
+        auto& state = *f->m_state;
+        state.deques = std::vector<StealingFarm::Deque>(w.size());
+
+        std::vector<ff::ff_node *> workers;
+        for (size_t i = 0; i < w.size(); ++i) {
+            SiSoNode_ref n = w[i];
+            auto* old = n->get();
+            auto worker = std::make_unique<StealingFarm::StealWorker>(
+                &state, i, old->m_self, old->m_svc, old->m_svc_num_args, old->m_svc_init, old->m_svc_end, old->m_eosnotify);
+            worker->adopt(*old);
+            n->m_object = std::move(worker);
+            workers.push_back(n->m_object.get());
+            f->m_owned_deps.emplace_back(n);
+        }
+
+        f->get()->add_workers(workers);
+        f->m_has_workers = true;
+        return f;
+    })
+
+    METHOD("add_collector", [](StealingFarm* f, tvm::ffi::Optional<Node_ref> copt) {
+        if (!copt.has_value()) {
+            f->get()->add_collector(nullptr);
+            return f;
+        }
+
+        f->get()->add_collector(copt.value()->m_object.get());
+        f->m_owned_deps.emplace_back(copt.value());
+        return f;
+    })
+
+    METHOD("run_and_wait_end", [](StealingFarm* t) {
+        t->get()->run_and_wait_end();
+    })
+
+    METHOD("stats", [](StealingFarm* f) {
+        return f->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// EdfEmitter: farm emitter dispatching earliest deadline first. Arrived tasks
+// are drained from the farm's input channel into a deadline-ordered window;
+// tasks already expired at dispatch time are dropped. Use it with on-demand
+// scheduling, so tasks wait in the window (where they can be reordered)
+// rather than in the workers' queues:
+//   Farm().add_emitter(EdfEmitter()).add_workers(...).set_scheduling_ondemand(1)
+struct EdfEmitter : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Counters {
+        std::atomic<uint64_t> dispatched{0}, dropped{0};
+    };
+
+    struct EdfEmitterImpl : ff::ff_monode_t<Any> {
+        LaneWindow m_window;
+        bool m_drop_expired;
+        Counters& m_counters;
+
+        EdfEmitterImpl(size_t window, bool drop_expired, Counters& counters)
+            : m_drop_expired(drop_expired), m_counters(counters) {
+            m_window.configure(1, window, 0, true, tvm::ffi::Function());
+        }
+
+        Any* dispatch(Any* t) {
+            int64_t d = task_meta(t)->deadline_ns;
+            if (m_drop_expired && d != 0 && now_ns() > d) {
+                ff_free_any(t);
+                m_counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                return GO_ON;
+            }
+            m_counters.dispatched.fetch_add(1, std::memory_order_relaxed);
+            return t;
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t != nullptr, "EdfEmitter must be fed by an upstream stage");
+            m_window.push(t);
+            return m_window.serve(this, [this](Any* x) { return dispatch(x); });
+        }
+
+        void eosnotify(ssize_t) override {
+            m_window.flush(this, [this](Any* x) { return dispatch(x); });
+        }
+    };
+
+    Counters m_counters;
+
+    EdfEmitter(int64_t window, bool drop_expired) : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(window >= 1, "EdfEmitter: window must be >= 1");
+        m_object = std::make_unique<EdfEmitterImpl>(size_t(window), drop_expired, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("dispatched", int64_t(m_counters.dispatched.load(std::memory_order_relaxed)));
+        m.Set("dropped",    int64_t(m_counters.dropped.load(std::memory_order_relaxed)));
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(EdfEmitter);
+};
+
+DEFINE_TVM_OBJECT_REF(EdfEmitter)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(EdfEmitter)
+    CONSTRUCTOR(int64_t, bool)
+    METHOD("stats", [](EdfEmitter* e) {
+        return e->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+struct A2A : Node {
+    A2A() : Node(ff::ff_a2a()) {}
+
+    std::vector<tvm::ffi::Any> m_owned_deps;
+
+    ff::ff_a2a* get() const {
+        return static_cast<ff::ff_a2a*>(m_object.get());    
+    }
+
+    std::vector<ff::ff_node *> own_set(const tvm::ffi::Array<Node_ref>& w, const char* method) {
+        std::set<ff::ff_node *> ptr_set;
+        for (const auto& n : w) {
+            auto ptr = n->m_object.get();
+            tvm_assert(ptr_set.find(ptr) == ptr_set.end(), 
+            std::string("You are trying to construct an a2a with multiple instances of the same fastflow node! "
+                "Common python error: a2a.") + method + "([worker_node] * N). Tips: you must construct workers indipendently!"
+            );
+
+            ptr_set.insert(ptr);
+        }
+
+
+        for (const auto& n : w) {
+            m_owned_deps.emplace_back(n);
+        }
+
+        return std::vector<ff::ff_node *>(ptr_set.begin(), ptr_set.end());
+    }
+
+    void add_firstset(const tvm::ffi::Array<Node_ref>& w) {
+        get()->add_firstset(own_set(w, "add_firstset"));
+    }
+
+    void add_secondset(const tvm::ffi::Array<Node_ref>& w) {
+        get()->add_secondset(own_set(w, "add_secondset"));
+    }
+
+    FFTVM_DECLARE_NODE_INFO(A2A);
+};
+
+
+DEFINE_TVM_OBJECT_REF(A2A)
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(A2A)
+CONSTRUCTOR()
+    METHOD("add_firstset", [](A2A* t, tvm::ffi::Array<Node_ref> w){
+        t->add_firstset(w);
+        return t;
+    })
+
+
+    METHOD("add_secondset", [](A2A* t, tvm::ffi::Array<Node_ref> w){
+        t->add_secondset(w);
+        return t;
+    })
+
+    METHOD("run_and_wait_end", [](A2A* t) {
+        t->get()->run_and_wait_end();
+    })
+
+    METHOD("debug_info", [](A2A* t) {
+        std::cout << "A2ANode debug infos:" << std::endl;
+        std::cout << "Cardinality: " << t->get()->cardinality() << std::endl;
+        // std::cout << "get_num_inchannels: " << t->get()->get_num_inchannels() << std::endl;
+        // std::cout << "get_num_outchannels: " << t->get()->get_num_outchannels() << std::endl;
+        ff::svector<ff::ff_node *> o_nodes; 
+        ff::svector<ff::ff_node *> i_nodes; 
+        t->get()->get_out_nodes(o_nodes);
+        t->get()->get_in_nodes(i_nodes);
+        std::cout << "in_nodes size: " << i_nodes.size() << std::endl;
+        std::cout << "out_nodes size: " << o_nodes.size() << std::endl;
+        std::cout << std::endl;
+        return t;
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// `path` itself, or every regular file of the directory `path` in name order.
+static std::vector<std::string> list_input_files(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    if (fs::is_directory(path)) {
+        for (const auto& e : fs::directory_iterator(path)) {
+            if (e.is_regular_file()) files.push_back(e.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    } else {
+        files.push_back(path);
+    }
+    return files;
+}
+
+// A read-only file mapping shared by all the Tensor views cut from it.
+// MAP_PRIVATE + PROT_WRITE: consumers that write into a view only touch
+// copy-on-write pages, never the file.
+struct MappedFile : tvm::ffi::Object {
+    std::string m_path;
+    uint8_t* m_base = nullptr;
+    size_t m_size = 0;
+
+    explicit MappedFile(std::string path) : m_path(std::move(path)) {
+        int fd = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+        tvm_assert(fd >= 0, "cannot open " + m_path + ": " + std::strerror(errno));
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            tvm_assert(false, "cannot stat " + m_path + ": " + std::strerror(err));
+        }
+
+        m_size = size_t(st.st_size);
+        if (m_size > 0) {
+            void* p = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            int err = errno;
+            ::close(fd);
+            tvm_assert(p != MAP_FAILED, "cannot mmap " + m_path + ": " + std::strerror(err));
+            m_base = static_cast<uint8_t*>(p);
+            ::madvise(m_base, m_size, MADV_SEQUENTIAL);
+        } else {
+            ::close(fd);
+        }
+    }
+
+    ~MappedFile() {
+        if (m_base) ::munmap(m_base, m_size);
+    }
+
+    void willneed(size_t offset, size_t len) const {
+        if (offset >= m_size || len == 0) return;
+        len = std::min(len, m_size - offset);
+        // madvise wants a page aligned address
+        static const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        size_t aligned = offset & ~(page - 1);
+        ::madvise(m_base + aligned, len + (offset - aligned), MADV_WILLNEED);
+    }
+
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.MappedFile", MappedFile, tvm::ffi::Object);
+};
+
+// NDAlloc used with Tensor::FromNDAlloc: the tensor "allocates" by pointing
+// into the mapping and keeps the mapping alive until it is destroyed.
+struct MappedViewAlloc {
+    tvm::ffi::ObjectPtr<MappedFile> m_file;
+
+    void AllocData(DLTensor* tensor, uint8_t* data) {
+        tensor->data = data;
+        tensor->byte_offset = 0;
+    }
+
+    void FreeData(DLTensor*) {}
+};
+
+// Parses the header of a .npy file (format versions 1.0, 2.0 and 3.0).
+// Returns false if `base` does not start with the npy magic string.
+static bool npy_parse_header(const uint8_t* base, size_t size, size_t& data_offset,
+                             DLDataType& dtype, std::vector<int64_t>& shape) {
+    static const char magic[] = "\x93NUMPY";
+    if (size < 10 || std::memcmp(base, magic, 6) != 0) return false;
+
+    uint8_t major = base[6];
+    size_t header_len, prefix;
+    if (major == 1) {
+        header_len = size_t(base[8]) | (size_t(base[9]) << 8);
+        prefix = 10;
+    } else {
+        tvm_assert(size >= 12, "truncated npy header");
+        header_len = size_t(base[8]) | (size_t(base[9]) << 8) | (size_t(base[10]) << 16) | (size_t(base[11]) << 24);
+        prefix = 12;
+    }
+    tvm_assert(prefix + header_len <= size, "truncated npy header");
+    std::string header(reinterpret_cast<const char*>(base + prefix), header_len);
+    data_offset = prefix + header_len;
+
+    auto value_of = [&](const std::string& key) {
+        size_t k = header.find("'" + key + "'");
+        tvm_assert(k != std::string::npos, "npy header has no '" + key + "' entry");
+        size_t colon = header.find(':', k);
+        tvm_assert(colon != std::string::npos, "malformed npy header");
+        size_t begin = header.find_first_not_of(' ', colon + 1);
+        return begin;
+    };
+
+    // 'descr': '<f4'
+    size_t d = value_of("descr");
+    tvm_assert(header[d] == '\'', "unsupported npy descr (structured dtypes are not supported)");
+    std::string descr = header.substr(d + 1, header.find('\'', d + 1) - d - 1);
+    tvm_assert(descr.size() >= 3, "malformed npy descr: " + descr);
+    tvm_assert(descr[0] != '>' || descr.substr(1) == "u1" || descr.substr(1) == "i1",
+               "big endian npy files are not supported: " + descr);
+    char kind = descr[1];
+    int bytes = std::stoi(descr.substr(2));
+    dtype.lanes = 1;
+    dtype.bits = uint8_t(bytes * 8);
+    switch (kind) {
+        case 'f': dtype.code = kDLFloat; break;
+        case 'i': dtype.code = kDLInt; break;
+        case 'u': dtype.code = kDLUInt; break;
+        case 'b': dtype.code = kDLBool; dtype.bits = 8; break;
+        default: tvm_assert(false, "unsupported npy dtype: " + descr);
+    }
+
+    size_t f = value_of("fortran_order");
+    tvm_assert(header.compare(f, 5, "False") == 0, "fortran ordered npy files are not supported");
+
+    // 'shape': (100, 3, 224, 224), -- or () for scalars
+    size_t s = value_of("shape");
+    size_t close = header.find(')', s);
+    tvm_assert(header[s] == '(' && close != std::string::npos, "malformed npy shape");
+    std::string dims = header.substr(s + 1, close - s - 1);
+    shape.clear();
+    size_t pos = 0;
+    while (pos < dims.size()) {
+        size_t comma = dims.find(',', pos);
+        std::string tok = dims.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (tok.find_first_not_of(' ') != std::string::npos) shape.push_back(std::stoll(tok));
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return true;
+}
+
+// MmapSource: native source node that memory maps a file (or every regular
+// file of a directory, in name order) and emits fixed-shape records as Tensors
+// that are zero-copy views into the mapping.
+//
+// For .npy files dtype and record shape default to the file's dtype and
+// shape[1:]; raw dumps need both, plus an optional header to skip.
+// `readahead` records ahead of the cursor are hinted with MADV_WILLNEED.
+// When used as a middle stage every input task is taken as a path.
+struct MmapSource : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Config {
+        std::string path;
+        std::vector<int64_t> record_shape;
+        std::string dtype;
+        int64_t readahead;
+        int64_t header_bytes;
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> files{0}, records{0}, bytes{0}, skipped_bytes{0};
+    };
+
+    struct MmapSourceImpl : ff::ff_node_t<Any> {
+        const Config& m_cfg;
+        Counters& m_counters;
+        const BudgetPort& m_budget;
+
+        MmapSourceImpl(const Config& cfg, Counters& counters, const BudgetPort& budget)
+            : m_cfg(cfg), m_counters(counters), m_budget(budget) {}
+
+        int svc_init() override {
+            m_budget.enter();
+            return 0;
+        }
+
+        void svc_end() override { m_budget.leave(); }
+
+        void emit_file(const std::string& path) {
+            auto file = tvm::ffi::make_object<MappedFile>(path);
+            m_counters.files.fetch_add(1, std::memory_order_relaxed);
+            if (file->m_size == 0) return;
+
+            size_t offset = size_t(m_cfg.header_bytes);
+            DLDataType dtype;
+            std::vector<int64_t> shape = m_cfg.record_shape;
+            std::vector<int64_t> npy_shape;
+            size_t npy_offset;
+            if (npy_parse_header(file->m_base, file->m_size, npy_offset, dtype, npy_shape)) {
+                offset = npy_offset;
+                if (shape.empty() && npy_shape.size() > 1) shape.assign(npy_shape.begin() + 1, npy_shape.end());
+            } else {
+                tvm_assert(!m_cfg.dtype.empty() && !shape.empty(),
+                           "MmapSource: " + path + " is not a .npy file, record_shape and dtype are required");
+            }
+            if (!m_cfg.dtype.empty()) dtype = tvm::ffi::StringToDLDataType(m_cfg.dtype);
+
+            size_t elems = 1;
+            for (auto d : shape) elems *= size_t(d);
+            size_t record_bytes = elems * ((size_t(dtype.bits) * dtype.lanes + 7) / 8);
+            tvm_assert(record_bytes > 0, "MmapSource: empty record");
+
+            size_t nrecords = offset < file->m_size ? (file->m_size - offset) / record_bytes : 0;
+            size_t window = size_t(m_cfg.readahead) * record_bytes;
+            size_t hinted_until = offset;
+            tvm::ffi::Shape tshape(shape);
+
+            for (size_t i = 0; i < nrecords; ++i) {
+                size_t off = offset + i * record_bytes;
+                if (window > 0 && off + window > hinted_until) {
+                    // hint a whole window at a time instead of one record at a time
+                    size_t from = std::max(hinted_until, off);
+                    file->willneed(from, off + 2 * window - from);
+                    hinted_until = off + 2 * window;
+                }
+
+                tvm::ffi::Tensor view = tvm::ffi::Tensor::FromNDAlloc(
+                    MappedViewAlloc{file}, tshape, dtype, DLDevice{kDLCPU, 0}, file->m_base + off);
+                ff_send_out(ff_alloc_any(Any(std::move(view))));
+            }
+
+            m_counters.records.fetch_add(nrecords, std::memory_order_relaxed);
+            m_counters.bytes.fetch_add(nrecords * record_bytes, std::memory_order_relaxed);
+            m_counters.skipped_bytes.fetch_add(file->m_size - std::min(file->m_size, offset + nrecords * record_bytes),
+                                               std::memory_order_relaxed);
+        }
+
+        Any* svc(Any* t) override {
+            if (t == nullptr) {
+                for (const auto& f : list_input_files(m_cfg.path)) emit_file(f);
+                return EOS;
+            }
+
+            std::string path = t->cast<tvm::ffi::String>();
+            ff_free_any(t);
+            for (const auto& f : list_input_files(path)) emit_file(f);
+            return GO_ON;
+        }
+    };
+
+    Config m_cfg;
+    Counters m_counters;
+    BudgetPort m_budget;
+
+    MmapSource(tvm::ffi::String path, tvm::ffi::Array<int64_t> record_shape, tvm::ffi::String dtype,
+               int64_t readahead, int64_t header_bytes) : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(readahead >= 0, "MmapSource: readahead must be >= 0");
+        tvm_assert(header_bytes >= 0, "MmapSource: header_bytes must be >= 0");
+        m_cfg.path = path;
+        m_cfg.record_shape.assign(record_shape.begin(), record_shape.end());
+        m_cfg.dtype = dtype;
+        m_cfg.readahead = readahead;
+        m_cfg.header_bytes = header_bytes;
+        m_object = std::make_unique<MmapSourceImpl>(m_cfg, m_counters, m_budget);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("files",         int64_t(m_counters.files.load(std::memory_order_relaxed)));
+        m.Set("records",       int64_t(m_counters.records.load(std::memory_order_relaxed)));
+        m.Set("bytes",         int64_t(m_counters.bytes.load(std::memory_order_relaxed)));
+        m.Set("skipped_bytes", int64_t(m_counters.skipped_bytes.load(std::memory_order_relaxed)));
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(MmapSource);
+};
+
+DEFINE_TVM_OBJECT_REF(MmapSource)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(MmapSource)
+    CONSTRUCTOR(tvm::ffi::String, tvm::ffi::Array<int64_t>, tvm::ffi::String, int64_t, int64_t)
+    METHOD("stats", [](MmapSource* s) {
+        return s->stats();
+    })
+    METHOD("configure_byte_budget", [](MmapSource* s, ByteBudget_ref budget, int64_t edge_limit, tvm::ffi::String name) {
+        s->m_budget.configure(budget, edge_limit, name);
+        return s;
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// Pool of equally sized, page aligned host buffers. Buffers are handed out as
+// Tensors (see PooledBufferAlloc) and come back to the pool when the last
+// reference to the Tensor is dropped.
+struct BufferPool : tvm::ffi::Object {
+    size_t m_buffer_size;
+    std::vector<uint8_t*> m_all;
+    std::vector<uint8_t*> m_free;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+
+    BufferPool(size_t buffer_size, size_t count) : m_buffer_size(buffer_size) {
+        static const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        size_t rounded = (buffer_size + page - 1) / page * page;
+        for (size_t i = 0; i < count; ++i) {
+            void* p = std::aligned_alloc(page, rounded);
+            tvm_assert(p != nullptr, "Out of memory");
+            m_all.push_back(static_cast<uint8_t*>(p));
+        }
+        m_free = m_all;
+    }
+
+    ~BufferPool() {
+        for (auto p : m_all) std::free(p);
+    }
+
+    // nullptr if no buffer was released within `timeout`
+    uint8_t* acquire(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        if (!m_cv.wait_for(lk, timeout, [&] { return !m_free.empty(); })) return nullptr;
+        uint8_t* p = m_free.back();
+        m_free.pop_back();
+        return p;
+    }
+
+    uint8_t* acquire() {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_cv.wait(lk, [&] { return !m_free.empty(); });
+        uint8_t* p = m_free.back();
+        m_free.pop_back();
+        return p;
+    }
+
+    uint8_t* try_acquire() {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_free.empty()) return nullptr;
+        uint8_t* p = m_free.back();
+        m_free.pop_back();
+        return p;
+    }
+
+    void release(uint8_t* p) {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_free.push_back(p);
+        }
+        m_cv.notify_one();
+    }
+
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.BufferPool", BufferPool, tvm::ffi::Object);
+};
+
+struct PooledBufferAlloc {
+    tvm::ffi::ObjectPtr<BufferPool> m_pool;
+
+    void AllocData(DLTensor* tensor, uint8_t* data) {
+        tensor->data = data;
+        tensor->byte_offset = 0;
+    }
+
+    void FreeData(DLTensor* tensor) {
+        m_pool->release(static_cast<uint8_t*>(tensor->data));
+    }
+};
+
+struct ReadRequest {
+    int fd;
+    uint64_t offset;
+    size_t len;
+    uint8_t* buf;
+    uint64_t seq;
+};
+
+struct ReadCompletion {
+    uint64_t seq;
+    ssize_t res;  // bytes read or -errno
+};
+
+struct ReadBackend {
+    virtual ~ReadBackend() = default;
+    virtual void submit(const ReadRequest& r) = 0;
+    virtual ReadCompletion wait() = 0;
+    virtual const char* name() const = 0;
+};
+
+// Fallback backend: a fixed set of threads doing blocking pread().
+struct ThreadPoolReadBackend : ReadBackend {
+    std::vector<std::thread> m_threads;
+    std::mutex m_mtx;
+    std::condition_variable m_req_cv, m_done_cv;
+    std::deque<ReadRequest> m_reqs;
+    std::deque<ReadCompletion> m_done;
+    bool m_stop = false;
+
+    explicit ThreadPoolReadBackend(size_t nthreads) {
+        for (size_t i = 0; i < nthreads; ++i) {
+            m_threads.emplace_back([this] { loop(); });
+        }
+    }
+
+    ~ThreadPoolReadBackend() override {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_stop = true;
+        }
+        m_req_cv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    void loop() {
+        while (true) {
+            ReadRequest r;
+            {
+                std::unique_lock<std::mutex> lk(m_mtx);
+                m_req_cv.wait(lk, [&] { return m_stop || !m_reqs.empty(); });
+                if (m_reqs.empty()) return;
+                r = m_reqs.front();
+                m_reqs.pop_front();
+            }
+
+            ssize_t total = 0;
+            while (size_t(total) < r.len) {
+                ssize_t n = ::pread(r.fd, r.buf + total, r.len - total, off_t(r.offset + total));
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) { total = -errno; break; }
+                if (n == 0) break;
+                total += n;
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                m_done.push_back({r.seq, total});
+            }
+            m_done_cv.notify_one();
+        }
+    }
+
+    void submit(const ReadRequest& r) override {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_reqs.push_back(r);
+        }
+        m_req_cv.notify_one();
+    }
+
+    ReadCompletion wait() override {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_done_cv.wait(lk, [&] { return !m_done.empty(); });
+        ReadCompletion c = m_done.front();
+        m_done.pop_front();
+        return c;
+    }
+
+    const char* name() const override { return "threadpool"; }
+};
+
+#ifdef FFTVM_WITH_IO_URING
+struct IoUringReadBackend : ReadBackend {
+    struct io_uring m_ring;
+
+    explicit IoUringReadBackend(unsigned depth) {
+        int ret = io_uring_queue_init(depth, &m_ring, 0);
+        if (ret < 0) throw std::runtime_error(std::string("io_uring_queue_init: ") + std::strerror(-ret));
+    }
+
+    ~IoUringReadBackend() override {
+        io_uring_queue_exit(&m_ring);
+    }
+
+    void submit(const ReadRequest& r) override {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+        tvm_assert(sqe != nullptr, "io_uring submission queue is full");
+        io_uring_prep_read(sqe, r.fd, r.buf, unsigned(r.len), r.offset);
+        io_uring_sqe_set_data64(sqe, r.seq);
+        int ret = io_uring_submit(&m_ring);
+        tvm_assert(ret >= 0, std::string("io_uring_submit: ") + std::strerror(-ret));
+    }
+
+    ReadCompletion wait() override {
+        struct io_uring_cqe* cqe = nullptr;
+        int ret;
+        do {
+            ret = io_uring_wait_cqe(&m_ring, &cqe);
+        } while (ret == -EINTR);
+        tvm_assert(ret >= 0, std::string("io_uring_wait_cqe: ") + std::strerror(-ret));
+        ReadCompletion c{io_uring_cqe_get_data64(cqe), ssize_t(cqe->res)};
+        io_uring_cqe_seen(&m_ring, cqe);
+        return c;
+    }
+
+    const char* name() const override { return "io_uring"; }
+};
+#endif
+
+static std::unique_ptr<ReadBackend> make_read_backend(size_t max_inflight) {
+#ifdef FFTVM_WITH_IO_URING
+    try {
+        return std::make_unique<IoUringReadBackend>(unsigned(max_inflight));
+    } catch (const std::runtime_error&) {
+        // e.g. io_uring disabled by seccomp/sysctl: fall back to threads
+    }
+#endif
+    return std::make_unique<ThreadPoolReadBackend>(max_inflight);
+}
+
+// FileReader: native source node streaming one file (or every regular file of
+// a directory, in name order) in fixed-size chunks with several reads in
+// flight. Chunks are read into pooled buffers and emitted in file order as
+// 1-D uint8 Tensors (or copied into Bytes).
+//
+// The read-ahead depth adapts between min_inflight and max_inflight: it grows
+// while the node waits on the disk and shrinks while it waits on downstream.
+struct FileReader : Node {
+    using Any   = tvm::ffi::Any;
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        std::string path;
+        int64_t chunk_size;
+        int64_t min_inflight;
+        int64_t max_inflight;
+        bool as_bytes;
+        int64_t stall_timeout_ms;  // how long downstream may hold every buffer; < 0: forever
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> files{0}, chunks{0}, bytes{0};
+        std::atomic<int64_t> depth{0}, max_depth{0};
+        std::atomic<const char*> backend{""};
+    };
+
+    struct FileReaderImpl : ff::ff_node_t<Any> {
+        struct Pending {
+            size_t file;
+            uint8_t* buf;
+            uint64_t offset;
+            size_t len;
+            ssize_t res = 0;  // bytes read so far
+            bool done = false;
+        };
+
+        struct OpenFile {
+            int fd;
+            size_t outstanding;
+        };
+
+        const Config& m_cfg;
+        Counters& m_counters;
+        tvm::ffi::ObjectPtr<BufferPool> m_pool;
+
+        FileReaderImpl(const Config& cfg, Counters& counters) : m_cfg(cfg), m_counters(counters) {}
+
+        int svc_init() override {
+            // buffers in flight + as many again to be held downstream
+            m_pool = tvm::ffi::make_object<BufferPool>(size_t(m_cfg.chunk_size), size_t(2 * m_cfg.max_inflight));
+            return 0;
+        }
+
+        void svc_end() override {
+            m_pool.reset();
+        }
+
+        void emit(uint8_t* buf, size_t n) {
+            if (m_cfg.as_bytes) {
+                tvm::ffi::Bytes b(reinterpret_cast<const char*>(buf), n);
+                m_pool->release(buf);
+                ff_send_out(ff_alloc_any(Any(std::move(b))));
+            } else {
+                tvm::ffi::Tensor t = tvm::ffi::Tensor::FromNDAlloc(
+                    PooledBufferAlloc{m_pool}, tvm::ffi::Shape({int64_t(n)}), DLDataType{kDLUInt, 8, 1}, DLDevice{kDLCPU, 0}, buf);
+                ff_send_out(ff_alloc_any(Any(std::move(t))));
+            }
+        }
+
+        void read_all(const std::vector<std::string>& paths) {
+            auto backend = make_read_backend(size_t(m_cfg.max_inflight));
+            m_counters.backend.store(backend->name());
+
+            const size_t chunk = size_t(m_cfg.chunk_size);
+            int64_t depth = m_cfg.min_inflight;
+            m_counters.depth.store(depth);
+            m_counters.max_depth.store(depth);
+
+            std::vector<OpenFile> files;
+            std::deque<Pending> window;      // window[i] has seq == base_seq + i
+            uint64_t base_seq = 0, next_seq = 0;
+            size_t file_idx = 0;
+            uint64_t file_off = 0, file_size = 0;
+            int64_t inflight = 0;
+
+            Clock::duration waited_io{0}, waited_downstream{0};
+            size_t since_adapt = 0;
+
+            auto close_if_done = [&](size_t f) {
+                if (--files[f].outstanding == 0) ::close(files[f].fd);
+            };
+
+            auto next_chunk_available = [&]() {
+                while (file_idx < paths.size() && (files.size() <= file_idx || file_off >= file_size)) {
+                    if (files.size() > file_idx) {
+                        // current file fully submitted: drop the submission reference
+                        close_if_done(file_idx);
+                        ++file_idx;
+                        file_off = 0;
+                        continue;
+                    }
+                    int fd = ::open(paths[file_idx].c_str(), O_RDONLY | O_CLOEXEC);
+                    tvm_assert(fd >= 0, "cannot open " + paths[file_idx] + ": " + std::strerror(errno));
+                    struct stat st;
+                    tvm_assert(::fstat(fd, &st) == 0, "cannot stat " + paths[file_idx]);
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    files.push_back({fd, 1});
+                    file_size = uint64_t(st.st_size);
+                    m_counters.files.fetch_add(1, std::memory_order_relaxed);
+                }
+                return file_idx < paths.size();
+            };
+
+            while (true) {
+                // 1. keep `depth` reads in flight
+                while (inflight < depth && next_chunk_available()) {
+                    uint8_t* buf = m_pool->try_acquire();
+                    if (buf == nullptr && inflight == 0) {
+                        // downstream holds every buffer: wait for one back
+                        if (m_cfg.stall_timeout_ms < 0) {
+                            buf = m_pool->acquire();
+                        } else {
+                            buf = m_pool->acquire(std::chrono::milliseconds(m_cfg.stall_timeout_ms));
+                        }
+                        tvm_assert(buf != nullptr, "FileReader: downstream has held all " + std::to_string(2 * m_cfg.max_inflight) +
+                                   " chunk buffers for " + std::to_string(m_cfg.stall_timeout_ms) +
+                                   " ms; release chunks (copy what must be kept), use output=\"bytes\" or raise stall_timeout_ms");
+                    }
+                    if (buf == nullptr) break;  // downstream holds every buffer
+
+                    size_t len = size_t(std::min<uint64_t>(chunk, file_size - file_off));
+                    backend->submit({files[file_idx].fd, file_off, len, buf, next_seq++});
+                    window.push_back({file_idx, buf, file_off, len});
+                    files[file_idx].outstanding++;
+                    file_off += len;
+                    inflight++;
+                }
+
+                if (inflight == 0) break;
+
+                // 2. wait for one completion
+                auto t0 = Clock::now();
+                ReadCompletion c = backend->wait();
+                waited_io += Clock::now() - t0;
+                inflight--;
+
+                Pending& p = window[c.seq - base_seq];
+                tvm_assert(c.res >= 0, "read failed on " + paths[p.file] + ": " + std::strerror(int(-c.res)));
+                p.res += c.res;
+                if (c.res > 0 && size_t(p.res) < p.len) {
+                    // short read (NFS, FUSE, pipes): read the rest of the chunk
+                    backend->submit({files[p.file].fd, p.offset + uint64_t(p.res), p.len - size_t(p.res), p.buf + p.res, c.seq});
+                    inflight++;
+                    continue;
+                }
+                p.done = true;  // full, or cut short by the end of the file
+
+                // 3. emit completed chunks in order
+                auto t1 = Clock::now();
+                while (!window.empty() && window.front().done) {
+                    Pending front = window.front();
+                    window.pop_front();
+                    base_seq++;
+                    close_if_done(front.file);
+                    if (front.res == 0) {
+                        m_pool->release(front.buf);
+                        continue;
+                    }
+                    m_counters.chunks.fetch_add(1, std::memory_order_relaxed);
+                    m_counters.bytes.fetch_add(uint64_t(front.res), std::memory_order_relaxed);
+                    emit(front.buf, size_t(front.res));
+                }
+                waited_downstream += Clock::now() - t1;
+
+                // 4. adapt the read-ahead depth to the consumption rate
+                if (++since_adapt == 8) {
+                    if (waited_io > waited_downstream && depth < m_cfg.max_inflight) {
+                        depth++;
+                    } else if (waited_downstream > 2 * waited_io && depth > m_cfg.min_inflight) {
+                        depth--;
+                    }
+                    m_counters.depth.store(depth, std::memory_order_relaxed);
+                    if (depth > m_counters.max_depth.load(std::memory_order_relaxed)) {
+                        m_counters.max_depth.store(depth, std::memory_order_relaxed);
+                    }
+                    waited_io = waited_downstream = Clock::duration{0};
+                    since_adapt = 0;
+                }
+            }
+        }
+
+        Any* svc(Any* t) override {
+            if (t == nullptr) {
+                read_all(list_input_files(m_cfg.path));
+                return EOS;
+            }
+
+            std::string path = t->cast<tvm::ffi::String>();
+            ff_free_any(t);
+            read_all(list_input_files(path));
+            return GO_ON;
+        }
+    };
+
+    Config m_cfg;
+    Counters m_counters;
+
+    FileReader(tvm::ffi::String path, int64_t chunk_size, int64_t min_inflight, int64_t max_inflight, bool as_bytes,
+               int64_t stall_timeout_ms)
+        : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(chunk_size > 0, "FileReader: chunk_size must be > 0");
+        tvm_assert(min_inflight >= 1 && max_inflight >= min_inflight, "FileReader: need 1 <= min_inflight <= max_inflight");
+        m_cfg.path = path;
+        m_cfg.chunk_size = chunk_size;
+        m_cfg.min_inflight = min_inflight;
+        m_cfg.max_inflight = max_inflight;
+        m_cfg.as_bytes = as_bytes;
+        m_cfg.stall_timeout_ms = stall_timeout_ms;
+        m_object = std::make_unique<FileReaderImpl>(m_cfg, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("backend",   tvm::ffi::String(m_counters.backend.load()));
+        m.Set("files",     int64_t(m_counters.files.load(std::memory_order_relaxed)));
+        m.Set("chunks",    int64_t(m_counters.chunks.load(std::memory_order_relaxed)));
+        m.Set("bytes",     int64_t(m_counters.bytes.load(std::memory_order_relaxed)));
+        m.Set("depth",     m_counters.depth.load(std::memory_order_relaxed));
+        m.Set("max_depth", m_counters.max_depth.load(std::memory_order_relaxed));
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(FileReader);
+};
+
+DEFINE_TVM_OBJECT_REF(FileReader)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(FileReader)
+    CONSTRUCTOR(tvm::ffi::String, int64_t, int64_t, int64_t, bool, int64_t)
+    METHOD("stats", [](FileReader* r) {
+        return r->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Wire codec for tasks crossing a process boundary. Small fields are packed
+// into a staging buffer while large payloads (tensor data, long strings) are
+// referenced in place, so a sender hands them to writev without copying.
+// Decoded tensors get their memory from a size-class pool. Values are written
+// in host byte order: both ends are expected to share the architecture.
+// ---------------------------------------------------------------------------
+
+// Host buffers in power-of-two size classes. Released buffers are cached up to
+// `max_cached` bytes and handed out again by acquire().
+struct SizeClassPool : tvm::ffi::Object {
+    static constexpr int kMinShift = 6;  // 64 B
+    static constexpr int kClasses  = 40;
+
+    std::mutex m_mtx;
+    std::vector<void*> m_free[kClasses];
+    size_t m_cached = 0;
+    size_t m_max_cached;
+    std::atomic<uint64_t> m_hits{0}, m_misses{0};
+
+    explicit SizeClassPool(size_t max_cached) : m_max_cached(max_cached) {}
+
+    ~SizeClassPool() {
+        for (auto& list : m_free)
+            for (auto p : list) std::free(p);
+    }
+
+    static int size_class(size_t n) {
+        int c = 0;
+        while ((size_t(1) << (c + kMinShift)) < n) ++c;
+        tvm_assert(c < kClasses, "SizeClassPool: allocation too large");
+        return c;
+    }
+
+    static size_t class_size(int c) { return size_t(1) << (c + kMinShift); }
+
+    void* acquire(size_t n) {
+        int c = size_class(n);
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (!m_free[c].empty()) {
+                void* p = m_free[c].back();
+                m_free[c].pop_back();
+                m_cached -= class_size(c);
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+        }
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        void* p = std::aligned_alloc(64, class_size(c));
+        tvm_assert(p != nullptr, "Out of memory");
+        return p;
+    }
+
+    void release(void* p, size_t n) {
+        int c = size_class(n);
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_cached + class_size(c) <= m_max_cached) {
+                m_free[c].push_back(p);
+                m_cached += class_size(c);
+                return;
+            }
+        }
+        std::free(p);
+    }
+
+    // Pool shared by every decoder of the process.
+    static tvm::ffi::ObjectPtr<SizeClassPool> global() {
+        static auto pool = tvm::ffi::make_object<SizeClassPool>(size_t(256) << 20);
+        return pool;
+    }
+
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.SizeClassPool", SizeClassPool, tvm::ffi::Object);
+};
+
+struct SizeClassAlloc {
+    tvm::ffi::ObjectPtr<SizeClassPool> m_pool;
+    size_t m_nbytes;
+
+    void AllocData(DLTensor* tensor) {
+        tensor->data = m_pool->acquire(m_nbytes);
+        tensor->byte_offset = 0;
+    }
+
+    void FreeData(DLTensor* tensor) {
+        m_pool->release(tensor->data, m_nbytes);
+    }
+};
+
+namespace wire {
+
+enum class Tag : uint8_t {
+    None, Bool, Int, Float, Str, Bytes, Tensor, Array, Map, Shape
+};
+
+constexpr uint32_t kMaxDims  = 8;
+constexpr int      kMaxDepth = 64;
+// Payloads below this size are copied into the staging buffer: an extra
+// iovec costs more than the copy.
+constexpr size_t kGatherThreshold = 4096;
+
+// Scatter-gather encoder. Referenced payloads are kept alive until clear().
+class Writer {
+  public:
+    void write(const tvm::ffi::Any& v) { write(v, 0); }
+
+    size_t size() const { return m_head.size() + m_ref_bytes; }
+    bool empty() const { return size() == 0; }
+
+    // Appends the iovecs describing the encoded bytes, in order.
+    void gather(std::vector<struct iovec>& iov) const {
+        size_t at = 0;
+        for (const auto& r : m_refs) {
+            if (r.at > at) iov.push_back({const_cast<char*>(m_head.data()) + at, r.at - at});
+            iov.push_back({const_cast<char*>(r.data), r.len});
+            at = r.at;
+        }
+        if (m_head.size() > at) iov.push_back({const_cast<char*>(m_head.data()) + at, m_head.size() - at});
+    }
+
+    // Contiguous copy of the encoded bytes.
+    std::string str() const {
+        std::vector<struct iovec> iov;
+        gather(iov);
+        std::string out;
+        out.reserve(size());
+        for (auto& v : iov) out.append(static_cast<const char*>(v.iov_base), v.iov_len);
+        return out;
+    }
+
+    void clear() {
+        m_head.clear();
+        m_refs.clear();
+        m_keep.clear();
+        m_ref_bytes = 0;
+    }
+
+  private:
+    struct Ref {
+        size_t at;  // position in m_head the payload goes before
+        const char* data;
+        size_t len;
+    };
+
+    std::string m_head;
+    std::vector<Ref> m_refs;
+    std::vector<tvm::ffi::ObjectRef> m_keep;
+    size_t m_ref_bytes = 0;
+
+    template <typename T>
+    void put(const T& v) {
+        m_head.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void put_data(const char* data, size_t n, const tvm::ffi::ObjectRef& owner) {
+        put(uint64_t(n));
+        if (n < kGatherThreshold || !owner.defined()) {
+            m_head.append(data, n);
+        } else {
+            m_refs.push_back({m_head.size(), data, n});
+            m_keep.push_back(owner);
+            m_ref_bytes += n;
+        }
+    }
+
+    void write(const tvm::ffi::Any& v, int depth) {
+        tvm_assert(depth < kMaxDepth, "wire: value nested too deeply");
+        switch (v.type_index()) {
+            case TVMFFITypeIndex::kTVMFFINone:
+                put(Tag::None);
+                break;
+            case TVMFFITypeIndex::kTVMFFIBool:
+                put(Tag::Bool);
+                put(uint8_t(v.cast<bool>()));
+                break;
+            case TVMFFITypeIndex::kTVMFFIInt:
+                put(Tag::Int);
+                put(v.cast<int64_t>());
+                break;
+            case TVMFFITypeIndex::kTVMFFIFloat:
+                put(Tag::Float);
+                put(v.cast<double>());
+                break;
+            case TVMFFITypeIndex::kTVMFFISmallStr:
+            case TVMFFITypeIndex::kTVMFFIStr: {
+                auto s = v.cast<tvm::ffi::String>();
+                put(Tag::Str);
+                put_data(s.data(), s.size(), s);
+                break;
+            }
+            case TVMFFITypeIndex::kTVMFFISmallBytes:
+            case TVMFFITypeIndex::kTVMFFIBytes: {
+                auto b = v.cast<tvm::ffi::Bytes>();
+                put(Tag::Bytes);
+                put_data(b.data(), b.size(), b);
+                break;
+            }
+            case TVMFFITypeIndex::kTVMFFIShape: {
+                auto s = v.cast<tvm::ffi::Shape>();
+                put(Tag::Shape);
+                put(uint64_t(s.size()));
+                for (int64_t d : s) put(d);
+                break;
+            }
+            case TVMFFITypeIndex::kTVMFFIArray: {
+                auto a = v.cast<tvm::ffi::Array<tvm::ffi::Any>>();
+                put(Tag::Array);
+                put(uint64_t(a.size()));
+                for (const auto& e : a) write(e, depth + 1);
+                break;
+            }
+            case TVMFFITypeIndex::kTVMFFIMap: {
+                auto m = v.cast<tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any>>();
+                put(Tag::Map);
+                put(uint64_t(m.size()));
+                for (const auto& kv : m) {
+                    write(kv.first, depth + 1);
+                    write(kv.second, depth + 1);
+                }
+                break;
+            }
+            case TVMFFITypeIndex::kTVMFFITensor: {
+                auto t = v.cast<tvm::ffi::Tensor>();
+                tvm_assert(t->device.device_type == kDLCPU, "wire: only CPU tensors can be sent");
+                tvm_assert(t.IsContiguous(), "wire: only contiguous tensors can be sent");
+                tvm_assert(t->ndim <= int(kMaxDims), "wire: too many dimensions");
+                put(Tag::Tensor);
+                put(t->dtype);
+                put(uint32_t(t->ndim));
+                for (int i = 0; i < t->ndim; ++i) put(int64_t(t->shape[i]));
+                put_data(static_cast<const char*>(t->data) + t->byte_offset, tvm::ffi::GetDataSize(*t.get()), t);
+                break;
+            }
+            default:
+                tvm_assert(false, "wire: unsupported task type " + v.GetTypeKey());
+        }
+    }
+};
+
+// Byte source of the decoder.
+struct Reader {
+    virtual ~Reader() = default;
+    virtual void read(void* dst, size_t n) = 0;
+    virtual size_t remaining() const = 0;  // bytes left in the message
+
+    // A count of `unit`-byte items read from the message, checked against what
+    // is left of it before anything is allocated for them.
+    size_t get_count(size_t unit) {
+        auto n = get<uint64_t>();
+        tvm_assert(n <= remaining() / unit, "wire: length exceeds the message");
+        return size_t(n);
+    }
+
+    template <typename T>
+    T get() {
+        T v;
+        read(&v, sizeof(T));
+        return v;
+    }
+};
+
+struct MemoryReader : Reader {
+    const uint8_t* m_p;
+    const uint8_t* m_end;
+
+    MemoryReader(const void* data, size_t n) : m_p(static_cast<const uint8_t*>(data)), m_end(m_p + n) {}
+
+    void read(void* dst, size_t n) override {
+        tvm_assert(n <= size_t(m_end - m_p), "wire: truncated message");
+        std::memcpy(dst, m_p, n);
+        m_p += n;
+    }
+
+    size_t remaining() const override { return size_t(m_end - m_p); }
+
+    bool done() const { return m_p == m_end; }
+};
+
+// Decodes one value. Tensor memory comes from `pool`.
+static tvm::ffi::Any decode(Reader& r, const tvm::ffi::ObjectPtr<SizeClassPool>& pool, int depth = 0) {
+    tvm_assert(depth < kMaxDepth, "wire: value nested too deeply");
+    auto tag = r.get<Tag>();
+    switch (tag) {
+        case Tag::None:  return tvm::ffi::Any();
+        case Tag::Bool:  return bool(r.get<uint8_t>());
+        case Tag::Int:   return r.get<int64_t>();
+        case Tag::Float: return r.get<double>();
+        case Tag::Str:
+        case Tag::Bytes: {
+            std::string s(r.get_count(1), '\0');
+            r.read(s.data(), s.size());
+            if (tag == Tag::Str) return tvm::ffi::String(std::move(s));
+            return tvm::ffi::Bytes(std::move(s));
+        }
+        case Tag::Shape: {
+            std::vector<int64_t> dims(r.get_count(sizeof(int64_t)));
+            for (auto& d : dims) d = r.get<int64_t>();
+            return tvm::ffi::Shape(dims);
+        }
+        case Tag::Array: {
+            uint64_t n = r.get_count(sizeof(Tag));  // every element is at least a tag
+            tvm::ffi::Array<tvm::ffi::Any> a;
+            a.reserve(int64_t(n));
+            for (uint64_t i = 0; i < n; ++i) a.push_back(decode(r, pool, depth + 1));
+            return a;
+        }
+        case Tag::Map: {
+            uint64_t n = r.get_count(2 * sizeof(Tag));
+            tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any> m;
+            for (uint64_t i = 0; i < n; ++i) {
+                auto k = decode(r, pool, depth + 1);
+                m.Set(k, decode(r, pool, depth + 1));
+            }
+            return m;
+        }
+        case Tag::Tensor: {
+            auto dtype = r.get<DLDataType>();
+            auto ndim = r.get<uint32_t>();
+            tvm_assert(ndim <= kMaxDims, "wire: too many dimensions");
+            std::vector<int64_t> shape(ndim);
+            for (auto& d : shape) d = r.get<int64_t>();
+            auto n = r.get_count(1);
+            auto t = tvm::ffi::Tensor::FromNDAlloc(SizeClassAlloc{pool, n}, tvm::ffi::Shape(shape), dtype, DLDevice{kDLCPU, 0});
+            tvm_assert(tvm::ffi::GetDataSize(*t.get()) == n, "wire: tensor size mismatch");
+            r.read(t->data, n);
+            return t;
+        }
+    }
+    tvm_assert(false, "wire: unknown tag " + std::to_string(int(tag)));
+    return tvm::ffi::Any();
+}
+
+// Tasks travel in batches: a header followed by `ntasks` encoded values.
+constexpr uint32_t kBatchMagic = 0x66667462;  // "fftb"
+
+struct BatchHeader {
+    uint32_t magic;
+    uint32_t ntasks;
+    uint32_t eos;       // last message of the stream, ntasks == 0
+    uint32_t reserved;
+    uint64_t nbytes;    // payload bytes following the header
+};
+
+} // namespace wire
+
+#ifdef FFTVM_IMPL
+TVM_FFI_STATIC_INIT_BLOCK() {
+    tvm::ffi::reflection::GlobalDef()
+        .def("fftvm.wire_encode", [](tvm::ffi::Any v) {
+            wire::Writer w;
+            w.write(v);
+            return tvm::ffi::Bytes(w.str());
+        })
+        .def("fftvm.wire_decode", [](tvm::ffi::Bytes b) {
+            wire::MemoryReader r(b.data(), b.size());
+            auto v = wire::decode(r, SizeClassPool::global());
+            tvm_assert(r.done(), "wire: trailing bytes after value");
+            return v;
+        });
+}
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Shared-memory transport: ShmSink (producer process) -> ShmSource (consumer
+// process). A POSIX shm segment holds a single-producer/single-consumer ring of
+// fixed-size descriptors followed by a ring-allocated arena for payloads.
+// Tensor data is copied once into the arena by the producer; the consumer
+// emits Tensors that are views into the arena and flag their block as free
+// when released, so the producer can reclaim it.
+// ---------------------------------------------------------------------------
+
+namespace shm {
+
+constexpr uint64_t kMagic   = 0x66667476'6d73686dULL;  // "fftvmshm"
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kMaxDims = 8;
+constexpr size_t   kAlign   = 64;
+
+enum class Kind : uint32_t {
+    None, Bool, Int, Float, Str, Bytes, Tensor, Encoded, Eos
+};
+
+struct alignas(kAlign) Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t ring_slots;
+    uint64_t arena_size;
+    uint64_t ring_offset;
+    uint64_t arena_offset;
+
+    alignas(kAlign) std::atomic<uint64_t> head;        // next slot to write (producer)
+    alignas(kAlign) std::atomic<uint64_t> tail;        // next slot to read (consumer)
+    alignas(kAlign) std::atomic<uint64_t> arena_head;  // allocation cursor (producer)
+    uint64_t arena_tail;                               // reclaim cursor (producer only)
+    alignas(kAlign) std::atomic<uint32_t> ready;       // set last by the creator
+};
+
+struct Slot {
+    Kind kind;
+    uint32_t ndim;
+    DLDataType dtype;
+    uint32_t inline_len;
+    union {
+        int64_t i;
+        double f;
+    } value;
+    uint64_t block;       // arena offset of the BlockHeader, or UINT64_MAX
+    uint64_t nbytes;
+    int64_t shape[kMaxDims];
+    // inline payload follows, up to slot_size - sizeof(Slot)
+};
+
+struct alignas(kAlign) BlockHeader {
+    std::atomic<uint32_t> freed;
+    uint32_t skip;    // padding block up to the end of the arena
+    uint64_t size;    // including this header
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm transport needs lock-free 64-bit atomics");
+
+inline size_t align_up(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+// Spins, then yields, then sleeps: keeps latency low without burning a core
+// when the peer is slow.
+struct Backoff {
+    uint32_t n = 0;
+    void pause() {
+        if (n < 64) {
+            ++n;
+        } else if (n < 1024) {
+            ++n;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+};
+
+} // namespace shm
+
+struct ShmSegment : tvm::ffi::Object {
+    std::string m_name;
+    uint8_t* m_base = nullptr;
+    size_t m_size = 0;
+
+    ShmSegment(std::string name, size_t size, bool create) : m_name(std::move(name)), m_size(size) {
+        int fd;
+        if (create) {
+            ::shm_unlink(m_name.c_str());
+            fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            tvm_assert(fd >= 0, "shm_open(" + m_name + "): " + std::strerror(errno));
+            if (::ftruncate(fd, off_t(size)) != 0) {
+                int err = errno;
+                ::close(fd);
+                tvm_assert(false, "ftruncate(" + m_name + "): " + std::strerror(err));
+            }
+        } else {
+            fd = ::shm_open(m_name.c_str(), O_RDWR, 0600);
+            tvm_assert(fd >= 0, "shm_open(" + m_name + "): " + std::strerror(errno));
+            struct stat st;
+            ::fstat(fd, &st);
+            m_size = size_t(st.st_size);
+        }
+
+        void* p = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        tvm_assert(p != MAP_FAILED, "mmap(" + m_name + "): " + std::strerror(err));
+        m_base = static_cast<uint8_t*>(p);
+    }
+
+    ~ShmSegment() {
+        if (m_base) ::munmap(m_base, m_size);
+    }
+
+    shm::Header* header() const { return reinterpret_cast<shm::Header*>(m_base); }
+    shm::Slot* slot(uint64_t seq) const {
+        auto h = header();
+        return reinterpret_cast<shm::Slot*>(m_base + h->ring_offset + (seq % h->ring_slots) * h->slot_size);
+    }
+    uint8_t* arena() const { return m_base + header()->arena_offset; }
+    shm::BlockHeader* block(uint64_t off) const { return reinterpret_cast<shm::BlockHeader*>(arena() + off); }
+
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.ShmSegment", ShmSegment, tvm::ffi::Object);
+};
+
+struct ShmArenaViewAlloc {
+    tvm::ffi::ObjectPtr<ShmSegment> m_seg;
+    shm::BlockHeader* m_block;
+
+    void AllocData(DLTensor* tensor, uint8_t* data) {
+        tensor->data = data;
+        tensor->byte_offset = 0;
+    }
+
+    void FreeData(DLTensor*) {
+        m_block->freed.store(1, std::memory_order_release);
+    }
+};
+
+struct ShmCounters {
+    std::atomic<uint64_t> tasks{0}, bytes{0}, ring_stalls{0}, arena_stalls{0};
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> to_map() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("tasks",        int64_t(tasks.load(std::memory_order_relaxed)));
+        m.Set("bytes",        int64_t(bytes.load(std::memory_order_relaxed)));
+        m.Set("ring_stalls",  int64_t(ring_stalls.load(std::memory_order_relaxed)));
+        m.Set("arena_stalls", int64_t(arena_stalls.load(std::memory_order_relaxed)));
+        return m;
+    }
+};
+
+// ShmSink: terminal node that publishes every input task into a shm segment.
+// The segment is (re)created at svc_init; EOS is published at svc_end.
+struct ShmSink : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Config {
+        std::string name;
+        uint64_t ring_slots;
+        uint64_t slot_size;
+        uint64_t arena_size;
+    };
+
+    struct ShmSinkImpl : ff::ff_node_t<Any> {
+        const Config& m_cfg;
+        ShmCounters& m_counters;
+        tvm::ffi::ObjectPtr<ShmSegment> m_seg;
+
+        ShmSinkImpl(const Config& cfg, ShmCounters& counters) : m_cfg(cfg), m_counters(counters) {}
+
+        int svc_init() override {
+            using namespace shm;
+            size_t ring_offset  = align_up(sizeof(Header), kAlign);
+            size_t arena_offset = align_up(ring_offset + m_cfg.ring_slots * m_cfg.slot_size, 4096);
+            m_seg = tvm::ffi::make_object<ShmSegment>(m_cfg.name, arena_offset + m_cfg.arena_size, true);
+
+            auto h = new (m_seg->m_base) Header();
+            h->magic        = kMagic;
+            h->version      = kVersion;
+            h->slot_size    = uint32_t(m_cfg.slot_size);
+            h->ring_slots   = m_cfg.ring_slots;
+            h->arena_size   = m_cfg.arena_size;
+            h->ring_offset  = ring_offset;
+            h->arena_offset = arena_offset;
+            h->head.store(0, std::memory_order_relaxed);
+            h->tail.store(0, std::memory_order_relaxed);
+            h->arena_head.store(0, std::memory_order_relaxed);
+            h->arena_tail = 0;
+            h->ready.store(1, std::memory_order_release);
+            return 0;
+        }
+
+        // Reclaims freed blocks from the arena tail. Blocks are freed in any
+        // order, reclaimed in allocation order.
+        void reclaim() {
+            auto h = m_seg->header();
+            uint64_t head = h->arena_head.load(std::memory_order_relaxed);
+            while (h->arena_tail < head) {
+                auto b = m_seg->block(h->arena_tail % h->arena_size);
+                if (!b->freed.load(std::memory_order_acquire)) break;
+                h->arena_tail += b->size;
+            }
+        }
+
+        // Returns the arena offset of a block with at least `n` payload bytes.
+        uint64_t alloc_block(size_t n) {
+            using namespace shm;
+            auto h = m_seg->header();
+            size_t need = align_up(sizeof(BlockHeader) + n, kAlign);
+            tvm_assert(need <= h->arena_size, "ShmSink: payload of " + std::to_string(n) + " bytes does not fit the arena");
+
+            Backoff backoff;
+            bool stalled = false;
+            while (true) {
+                reclaim();
+                uint64_t head = h->arena_head.load(std::memory_order_relaxed);
+                uint64_t pos  = head % h->arena_size;
+                // a block never wraps: pad up to the end of the arena first
+                size_t pad  = pos + need > h->arena_size ? h->arena_size - pos : 0;
+                if (head + pad + need - h->arena_tail <= h->arena_size) {
+                    if (pad > 0) {
+                        auto skip = new (m_seg->block(pos)) BlockHeader();
+                        skip->skip = 1;
+                        skip->size = pad;
+                        skip->freed.store(1, std::memory_order_relaxed);
+                        head += pad;
+                        pos = 0;
+                    }
+                    auto b = new (m_seg->block(pos)) BlockHeader();
+                    b->skip = 0;
+                    b->size = need;
+                    b->freed.store(0, std::memory_order_relaxed);
+                    h->arena_head.store(head + need, std::memory_order_relaxed);
+                    return pos;
+                }
+                if (!stalled) {
+                    m_counters.arena_stalls.fetch_add(1, std::memory_order_relaxed);
+                    stalled = true;
+                }
+                backoff.pause();
+            }
+        }
+
+        uint8_t* block_data(uint64_t off) const {
+            return m_seg->arena() + off + sizeof(shm::BlockHeader);
+        }
+
+        shm::Slot* acquire_slot() {
+            auto h = m_seg->header();
+            uint64_t head = h->head.load(std::memory_order_relaxed);
+            shm::Backoff backoff;
+            bool stalled = false;
+            while (head - h->tail.load(std::memory_order_acquire) >= h->ring_slots) {
+                if (!stalled) {
+                    m_counters.ring_stalls.fetch_add(1, std::memory_order_relaxed);
+                    stalled = true;
+                }
+                backoff.pause();
+            }
+            auto s = m_seg->slot(head);
+            s->block = UINT64_MAX;
+            s->inline_len = 0;
+            s->ndim = 0;
+            s->nbytes = 0;
+            return s;
+        }
+
+        void publish() {
+            auto h = m_seg->header();
+            h->head.store(h->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        void put_buffer(shm::Slot* s, const char* data, size_t n) {
+            size_t inline_cap = m_cfg.slot_size - sizeof(shm::Slot);
+            s->nbytes = n;
+            if (n <= inline_cap) {
+                s->inline_len = uint32_t(n);
+                std::memcpy(reinterpret_cast<uint8_t*>(s) + sizeof(shm::Slot), data, n);
+            } else {
+                s->block = alloc_block(n);
+                std::memcpy(block_data(s->block), data, n);
+            }
+        }
+
+        void encode(const Any& v, shm::Slot* s) {
+            using shm::Kind;
+            switch (v.type_index()) {
+                case TVMFFITypeIndex::kTVMFFINone:
+                    s->kind = Kind::None;
+                    break;
+                case TVMFFITypeIndex::kTVMFFIBool:
+                    s->kind = Kind::Bool;
+                    s->value.i = v.cast<bool>();
+                    break;
+                case TVMFFITypeIndex::kTVMFFIInt:
+                    s->kind = Kind::Int;
+                    s->value.i = v.cast<int64_t>();
+                    break;
+                case TVMFFITypeIndex::kTVMFFIFloat:
+                    s->kind = Kind::Float;
+                    s->value.f = v.cast<double>();
+                    break;
+                case TVMFFITypeIndex::kTVMFFISmallStr:
+                case TVMFFITypeIndex::kTVMFFIStr: {
+                    auto str = v.cast<tvm::ffi::String>();
+                    s->kind = Kind::Str;
+                    put_buffer(s, str.data(), str.size());
+                    break;
+                }
+                case TVMFFITypeIndex::kTVMFFISmallBytes:
+                case TVMFFITypeIndex::kTVMFFIBytes: {
+                    auto bytes = v.cast<tvm::ffi::Bytes>();
+                    s->kind = Kind::Bytes;
+                    put_buffer(s, bytes.data(), bytes.size());
+                    break;
+                }
+                case TVMFFITypeIndex::kTVMFFITensor: {
+                    auto t = v.cast<tvm::ffi::Tensor>();
+                    tvm_assert(t->device.device_type == kDLCPU, "ShmSink: only CPU tensors can be shared");
+                    tvm_assert(t.IsContiguous(), "ShmSink: only contiguous tensors can be shared");
+                    tvm_assert(t->ndim <= int(shm::kMaxDims), "ShmSink: too many dimensions");
+                    s->kind = Kind::Tensor;
+                    s->dtype = t->dtype;
+                    s->ndim = uint32_t(t->ndim);
+                    for (int i = 0; i < t->ndim; ++i) s->shape[i] = t->shape[i];
+                    size_t n = tvm::ffi::GetDataSize(*t.get());
+                    s->nbytes = n;
+                    s->block = alloc_block(n);
+                    std::memcpy(block_data(s->block), static_cast<const uint8_t*>(t->data) + t->byte_offset, n);
+                    break;
+                }
+                default: {
+                    // containers go through the wire codec
+                    wire::Writer w;
+                    w.write(v);
+                    auto flat = w.str();
+                    s->kind = Kind::Encoded;
+                    put_buffer(s, flat.data(), flat.size());
+                    break;
+                }
+            }
+            m_counters.bytes.fetch_add(s->nbytes, std::memory_order_relaxed);
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t != nullptr, "ShmSink must be fed by an upstream stage");
+            auto s = acquire_slot();
+            encode(*t, s);
+            publish();
+            ff_free_any(t);
+            m_counters.tasks.fetch_add(1, std::memory_order_relaxed);
+            return GO_ON;
+        }
+
+        void svc_end() override {
+            if (!m_seg.defined()) return;
+            auto s = acquire_slot();
+            s->kind = shm::Kind::Eos;
+            publish();
+            m_seg.reset();
+        }
+    };
+
+    Config m_cfg;
+    ShmCounters m_counters;
+
+    ShmSink(tvm::ffi::String name, int64_t ring_slots, int64_t slot_size, int64_t arena_size) : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(ring_slots > 0, "ShmSink: ring_slots must be > 0");
+        tvm_assert(slot_size >= int64_t(sizeof(shm::Slot)), "ShmSink: slot_size must be >= " + std::to_string(sizeof(shm::Slot)));
+        tvm_assert(arena_size > 0, "ShmSink: arena_size must be > 0");
+        m_cfg = {std::string(name), uint64_t(ring_slots), shm::align_up(size_t(slot_size), 8), shm::align_up(size_t(arena_size), shm::kAlign)};
+        m_object = std::make_unique<ShmSinkImpl>(m_cfg, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        return m_counters.to_map();
+    }
+
+    FFTVM_DECLARE_NODE_INFO(ShmSink);
+};
+
+DEFINE_TVM_OBJECT_REF(ShmSink)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(ShmSink)
+    CONSTRUCTOR(tvm::ffi::String, int64_t, int64_t, int64_t)
+    METHOD("stats", [](ShmSink* s) {
+        return s->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// ShmSource: source node attaching to the segment published by a ShmSink
+// (waiting up to `timeout_ms` for it to appear) and emitting its tasks until
+// the producer's EOS. The name is unlinked once attached.
+struct ShmSource : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Config {
+        std::string name;
+        int64_t timeout_ms;
+    };
+
+    struct ShmSourceImpl : ff::ff_node_t<Any> {
+        const Config& m_cfg;
+        ShmCounters& m_counters;
+        tvm::ffi::ObjectPtr<SizeClassPool> m_pool = SizeClassPool::global();
+
+        ShmSourceImpl(const Config& cfg, ShmCounters& counters) : m_cfg(cfg), m_counters(counters) {}
+
+        tvm::ffi::ObjectPtr<ShmSegment> attach() {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_cfg.timeout_ms);
+            while (true) {
+                int fd = ::shm_open(m_cfg.name.c_str(), O_RDWR, 0600);
+                if (fd >= 0) {
+                    struct stat st;
+                    bool sized = ::fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(shm::Header);
+                    ::close(fd);
+                    if (sized) {
+                        auto seg = tvm::ffi::make_object<ShmSegment>(m_cfg.name, 0, false);
+                        if (seg->header()->ready.load(std::memory_order_acquire)) {
+                            tvm_assert(seg->header()->magic == shm::kMagic && seg->header()->version == shm::kVersion,
+                                       "ShmSource: " + m_cfg.name + " is not an fftvm segment");
+                            ::shm_unlink(m_cfg.name.c_str());
+                            return seg;
+                        }
+                    }
+                }
+                tvm_assert(std::chrono::steady_clock::now() < deadline, "ShmSource: timed out waiting for " + m_cfg.name);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        // Str, Bytes and Encoded payloads are copied out and their block freed.
+        Any decode_buffer(const tvm::ffi::ObjectPtr<ShmSegment>& seg, const shm::Slot* s) {
+            const char* data;
+            if (s->block == UINT64_MAX) {
+                data = reinterpret_cast<const char*>(s) + sizeof(shm::Slot);
+            } else {
+                data = reinterpret_cast<const char*>(seg->arena() + s->block + sizeof(shm::BlockHeader));
+            }
+            Any r;
+            if (s->kind == shm::Kind::Str) {
+                r = tvm::ffi::String(data, s->nbytes);
+            } else if (s->kind == shm::Kind::Bytes) {
+                r = tvm::ffi::Bytes(data, s->nbytes);
+            } else {
+                wire::MemoryReader in(data, s->nbytes);
+                r = wire::decode(in, m_pool);
+            }
+            if (s->block != UINT64_MAX) seg->block(s->block)->freed.store(1, std::memory_order_release);
+            return r;
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t == nullptr, "ShmSource is a source node and does not accept input tasks");
+            auto seg = attach();
+            auto h = seg->header();
+
+            while (true) {
+                uint64_t tail = h->tail.load(std::memory_order_relaxed);
+                shm::Backoff backoff;
+                while (h->head.load(std::memory_order_acquire) == tail) backoff.pause();
+
+                const shm::Slot* s = seg->slot(tail);
+                Any v;
+                switch (s->kind) {
+                    case shm::Kind::Eos:
+                        h->tail.store(tail + 1, std::memory_order_release);
+                        return EOS;
+                    case shm::Kind::None:  break;
+                    case shm::Kind::Bool:  v = bool(s->value.i); break;
+                    case shm::Kind::Int:   v = s->value.i; break;
+                    case shm::Kind::Float: v = s->value.f; break;
+                    case shm::Kind::Str:
+                    case shm::Kind::Bytes:
+                    case shm::Kind::Encoded: v = decode_buffer(seg, s); break;
+                    case shm::Kind::Tensor: {
+                        std::vector<int64_t> shape(s->shape, s->shape + s->ndim);
+                        v = tvm::ffi::Tensor::FromNDAlloc(
+                            ShmArenaViewAlloc{seg, seg->block(s->block)}, tvm::ffi::Shape(shape), s->dtype, DLDevice{kDLCPU, 0},
+                            seg->arena() + s->block + sizeof(shm::BlockHeader));
+                        break;
+                    }
+                }
+                m_counters.tasks.fetch_add(1, std::memory_order_relaxed);
+                m_counters.bytes.fetch_add(s->nbytes, std::memory_order_relaxed);
+                // the descriptor has been consumed, the payload may still be in use
+                h->tail.store(tail + 1, std::memory_order_release);
+                ff_send_out(ff_alloc_any(std::move(v)));
+            }
+        }
+    };
+
+    Config m_cfg;
+    ShmCounters m_counters;
+
+    ShmSource(tvm::ffi::String name, int64_t timeout_ms) : Node(tvm::ffi::UnsafeInit{}) {
+        m_cfg = {std::string(name), timeout_ms};
+        m_object = std::make_unique<ShmSourceImpl>(m_cfg, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        return m_counters.to_map();
+    }
+
+    FFTVM_DECLARE_NODE_INFO(ShmSource);
+};
+
+DEFINE_TVM_OBJECT_REF(ShmSource)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(ShmSource)
+    CONSTRUCTOR(tvm::ffi::String, int64_t)
+    METHOD("stats", [](ShmSource* s) {
+        return s->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// ---------------------------------------------------------------------------
+// TCP edges between process groups (see fftvm/distributed.py).
+// ---------------------------------------------------------------------------
+
+namespace net {
+
+static void write_all(int fd, struct iovec* iov, int iovcnt) {
+    static const int iov_max = int(::sysconf(_SC_IOV_MAX));
+    while (iovcnt > 0) {
+        ssize_t n = ::writev(fd, iov, std::min(iovcnt, iov_max));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            tvm_assert(false, std::string("writev: ") + std::strerror(errno));
+        }
+        while (iovcnt > 0 && size_t(n) >= iov->iov_len) {
+            n -= ssize_t(iov->iov_len);
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+            iov->iov_len -= size_t(n);
+        }
+    }
+}
+
+// Returns false if the peer closed the connection before the first byte.
+static bool read_all(int fd, void* buf, size_t len) {
+    auto p = static_cast<char*>(buf);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::read(fd, p + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            tvm_assert(false, std::string("read: ") + std::strerror(errno));
+        }
+        if (n == 0) {
+            tvm_assert(done == 0, "read: connection closed mid-message");
+            return false;
+        }
+        done += size_t(n);
+    }
+    return true;
+}
+
+// Buffered reader over a socket, bounded to the current message so that no
+// byte of the next one is consumed (poll() keeps reporting it). Large reads
+// go straight to their destination.
+struct FdReader : wire::Reader {
+    int m_fd;
+    size_t m_limit = 0;  // bytes of the message not yet read from the socket
+    std::vector<uint8_t> m_buf;
+    size_t m_pos = 0, m_len = 0;
+
+    explicit FdReader(int fd) : m_fd(fd), m_buf(64 << 10) {}
+
+    void begin(size_t nbytes) {
+        m_limit = nbytes;
+        m_pos = m_len = 0;
+    }
+
+    bool done() const { return m_limit == 0 && m_pos == m_len; }
+
+    size_t remaining() const override { return m_limit + (m_len - m_pos); }
+
+    void read(void* dst, size_t n) override {
+        auto out = static_cast<uint8_t*>(dst);
+        size_t buffered = std::min(n, m_len - m_pos);
+        std::memcpy(out, m_buf.data() + m_pos, buffered);
+        m_pos += buffered;
+        out += buffered;
+        n -= buffered;
+        if (n == 0) return;
+
+        tvm_assert(n <= m_limit, "wire: truncated message");
+        if (n >= m_buf.size()) {
+            tvm_assert(read_all(m_fd, out, n), "wire: connection closed mid-message");
+            m_limit -= n;
+            return;
+        }
+        m_len = std::min(m_buf.size(), m_limit);
+        tvm_assert(read_all(m_fd, m_buf.data(), m_len), "read: connection closed mid-message");
+        m_limit -= m_len;
+        std::memcpy(out, m_buf.data(), n);
+        m_pos = n;
+    }
+};
+
+static sockaddr_in resolve(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    int rc = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), nullptr, &hints, &res);
+    tvm_assert(rc == 0 && res != nullptr, "getaddrinfo(" + host + "): " + ::gai_strerror(rc));
+    sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+    ::freeaddrinfo(res);
+    addr.sin_port = htons(uint16_t(port));
+    return addr;
+}
+
+// "host:port" -> connected socket, retrying until the peer listens.
+static int connect_to(const std::string& endpoint, int64_t timeout_ms) {
+    auto colon = endpoint.rfind(':');
+    tvm_assert(colon != std::string::npos, "endpoint must be host:port, got " + endpoint);
+    auto addr = resolve(endpoint.substr(0, colon), std::stoi(endpoint.substr(colon + 1)));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        tvm_assert(fd >= 0, std::string("socket: ") + std::strerror(errno));
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        int err = errno;
+        ::close(fd);
+        tvm_assert(std::chrono::steady_clock::now() < deadline, "connect(" + endpoint + "): " + std::strerror(err));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+} // namespace net
+
+struct TcpCounters {
+    std::atomic<uint64_t> tasks{0}, batches{0}, bytes{0};
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> to_map() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("tasks",   int64_t(tasks.load(std::memory_order_relaxed)));
+        m.Set("batches", int64_t(batches.load(std::memory_order_relaxed)));
+        m.Set("bytes",   int64_t(bytes.load(std::memory_order_relaxed)));
+        return m;
+    }
+};
+
+// TcpSender: terminal node shipping its input tasks to one or more
+// TcpReceivers. Tasks are batched; a batch is flushed when it reaches
+// `batch_size` tasks or `batch_bytes` bytes, or as soon as the input channel
+// is empty, so batches grow with load and latency stays low when idle.
+// With several endpoints, batches are dealt round-robin.
+struct TcpSender : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Config {
+        std::vector<std::string> endpoints;
+        uint64_t batch_size;
+        uint64_t batch_bytes;
+        int64_t connect_timeout_ms;
+    };
+
+    struct TcpSenderImpl : ff::ff_node_t<Any> {
+        const Config& m_cfg;
+        TcpCounters& m_counters;
+        std::vector<int> m_fds;
+        size_t m_next = 0;
+        wire::Writer m_batch;
+        std::vector<struct iovec> m_iov;
+        uint32_t m_ntasks = 0;
+
+        TcpSenderImpl(const Config& cfg, TcpCounters& counters) : m_cfg(cfg), m_counters(counters) {}
+
+        int svc_init() override {
+            for (auto& ep : m_cfg.endpoints) m_fds.push_back(net::connect_to(ep, m_cfg.connect_timeout_ms));
+            m_next = 0;
+            m_batch.clear();
+            m_ntasks = 0;
+            return 0;
+        }
+
+        // Header and payload in a single writev; tensor data is not copied.
+        void send(int fd, const wire::BatchHeader& h) {
+            m_iov.clear();
+            m_iov.push_back({const_cast<wire::BatchHeader*>(&h), sizeof(h)});
+            m_batch.gather(m_iov);
+            net::write_all(fd, m_iov.data(), int(m_iov.size()));
+        }
+
+        void flush() {
+            if (m_ntasks == 0) return;
+            wire::BatchHeader h{wire::kBatchMagic, m_ntasks, 0, 0, m_batch.size()};
+            send(m_fds[m_next], h);
+            m_next = (m_next + 1) % m_fds.size();
+            m_counters.batches.fetch_add(1, std::memory_order_relaxed);
+            m_counters.bytes.fetch_add(sizeof(h) + m_batch.size(), std::memory_order_relaxed);
+            m_batch.clear();
+            m_ntasks = 0;
+        }
+
+        bool input_empty() const {
+            auto in = get_in_buffer();
+            return in == nullptr || in->empty();
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t != nullptr, "TcpSender must be fed by an upstream stage");
+            m_batch.write(*t);
+            ff_free_any(t);
+            ++m_ntasks;
+            m_counters.tasks.fetch_add(1, std::memory_order_relaxed);
+            if (m_ntasks >= m_cfg.batch_size || m_batch.size() >= m_cfg.batch_bytes || input_empty()) flush();
+            return GO_ON;
+        }
+
+        void svc_end() override {
+            if (m_fds.empty()) return;
+            flush();
+            wire::BatchHeader eos{wire::kBatchMagic, 0, 1, 0, 0};
+            for (int fd : m_fds) {
+                send(fd, eos);
+                ::shutdown(fd, SHUT_WR);
+                ::close(fd);
+            }
+            m_fds.clear();
+        }
+    };
+
+    Config m_cfg;
+    TcpCounters m_counters;
+
+    TcpSender(tvm::ffi::Array<tvm::ffi::String> endpoints, int64_t batch_size, int64_t batch_bytes, int64_t connect_timeout_ms)
+        : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(endpoints.size() > 0, "TcpSender: at least one endpoint is required");
+        tvm_assert(batch_size > 0 && batch_bytes > 0, "TcpSender: batch_size and batch_bytes must be > 0");
+        for (auto ep : endpoints) m_cfg.endpoints.emplace_back(ep);
+        m_cfg.batch_size = uint64_t(batch_size);
+        m_cfg.batch_bytes = uint64_t(batch_bytes);
+        m_cfg.connect_timeout_ms = connect_timeout_ms;
+        m_object = std::make_unique<TcpSenderImpl>(m_cfg, m_counters);
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        return m_counters.to_map();
+    }
+
+    FFTVM_DECLARE_NODE_INFO(TcpSender);
+};
+
+DEFINE_TVM_OBJECT_REF(TcpSender)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(TcpSender)
+    CONSTRUCTOR(tvm::ffi::Array<tvm::ffi::String>, int64_t, int64_t, int64_t)
+    METHOD("stats", [](TcpSender* s) {
+        return s->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// TcpReceiver: source node listening on host:port for `num_senders`
+// TcpSenders and emitting their tasks until every sender has sent its EOS.
+// Port 0 picks a free port, available through port() before the run.
+struct TcpReceiver : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Config {
+        std::string host;
+        int port;
+        int64_t num_senders;
+        int64_t timeout_ms;
+    };
+
+    struct Listener {
+        int fd = -1;
+        int port = 0;
+
+        ~Listener() { close(); }
+
+        void open(const Config& cfg) {
+            if (fd >= 0) return;
+            auto addr = net::resolve(cfg.host, cfg.port);
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            tvm_assert(fd >= 0, std::string("socket: ") + std::strerror(errno));
+            int one = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, int(cfg.num_senders)) != 0) {
+                int err = errno;
+                close();
+                tvm_assert(false, "TcpReceiver: cannot listen on " + cfg.host + ":" + std::to_string(cfg.port) + ": " + std::strerror(err));
+            }
+            socklen_t len = sizeof(addr);
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+            port = ntohs(addr.sin_port);
+        }
+
+        void close() {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+    };
+
+    struct TcpReceiverImpl : ff::ff_node_t<Any> {
+        const Config& m_cfg;
+        Listener& m_listener;
+        TcpCounters& m_counters;
+        tvm::ffi::ObjectPtr<SizeClassPool> m_pool = SizeClassPool::global();
+
+        TcpReceiverImpl(const Config& cfg, Listener& listener, TcpCounters& counters)
+            : m_cfg(cfg), m_listener(listener), m_counters(counters) {}
+
+        std::vector<pollfd> accept_all() {
+            m_listener.open(m_cfg);
+            std::vector<pollfd> peers;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_cfg.timeout_ms);
+            while (int64_t(peers.size()) < m_cfg.num_senders) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                tvm_assert(left > 0, "TcpReceiver: timed out waiting for senders");
+                pollfd p{m_listener.fd, POLLIN, 0};
+                if (::poll(&p, 1, int(left)) <= 0) continue;
+                int fd = ::accept(m_listener.fd, nullptr, nullptr);
+                if (fd >= 0) peers.push_back(pollfd{fd, POLLIN, 0});
+            }
+            // the next run listens again
+            m_listener.close();
+            return peers;
+        }
+
+        // Reads one batch from `fd` and forwards its tasks; false once the
+        // sender has sent its end of stream. A sender that goes away without
+        // one (crashed, or its graph failed) is an error, not the end.
+        bool receive(net::FdReader& in) {
+            wire::BatchHeader h;
+            tvm_assert(net::read_all(in.m_fd, &h, sizeof(h)),
+                       "TcpReceiver: a sender closed its connection without end of stream");
+            tvm_assert(h.magic == wire::kBatchMagic, "TcpReceiver: bad batch header");
+            if (h.eos) return false;
+
+            // decoded straight from the socket: tensor data lands in pooled buffers
+            in.begin(h.nbytes);
+            for (uint32_t i = 0; i < h.ntasks; ++i) ff_send_out(ff_alloc_any(wire::decode(in, m_pool)));
+            tvm_assert(in.done(), "TcpReceiver: batch size mismatch");
+
+            m_counters.tasks.fetch_add(h.ntasks, std::memory_order_relaxed);
+            m_counters.batches.fetch_add(1, std::memory_order_relaxed);
+            m_counters.bytes.fetch_add(sizeof(h) + h.nbytes, std::memory_order_relaxed);
+            return true;
+        }
+
+        Any* svc(Any* t) override {
+            tvm_assert(t == nullptr, "TcpReceiver is a source node and does not accept input tasks");
+            auto peers = accept_all();
+            struct Close {
+                std::vector<pollfd>& peers;
+                ~Close() {
+                    for (auto& p : peers) if (p.fd >= 0) ::close(p.fd);
+                }
+            } close_peers{peers};
+            std::vector<net::FdReader> readers;
+            for (auto& p : peers) readers.emplace_back(p.fd);
+            size_t open = peers.size();
+            while (open > 0) {
+                int rc = ::poll(peers.data(), peers.size(), -1);
+                if (rc < 0 && errno == EINTR) continue;
+                tvm_assert(rc > 0, std::string("poll: ") + std::strerror(errno));
+                for (size_t i = 0; i < peers.size(); ++i) {
+                    auto& p = peers[i];
+                    if (p.fd < 0 || !(p.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                    if (!receive(readers[i])) {
+                        ::close(p.fd);
+                        p.fd = -1;  // ignored by poll
+                        --open;
+                    }
+                }
+            }
+            return EOS;
+        }
+    };
+
+    Config m_cfg;
+    Listener m_listener;
+    TcpCounters m_counters;
+
+    TcpReceiver(tvm::ffi::String host, int64_t port, int64_t num_senders, int64_t timeout_ms) : Node(tvm::ffi::UnsafeInit{}) {
+        tvm_assert(port >= 0 && port < 65536, "TcpReceiver: invalid port");
+        tvm_assert(num_senders > 0, "TcpReceiver: num_senders must be > 0");
+        m_cfg = {std::string(host), int(port), num_senders, timeout_ms};
+        m_object = std::make_unique<TcpReceiverImpl>(m_cfg, m_listener, m_counters);
+    }
+
+    int64_t port() {
+        m_listener.open(m_cfg);
+        return m_listener.port;
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        return m_counters.to_map();
+    }
+
+    FFTVM_DECLARE_NODE_INFO(TcpReceiver);
+};
+
+DEFINE_TVM_OBJECT_REF(TcpReceiver)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(TcpReceiver)
+    CONSTRUCTOR(tvm::ffi::String, int64_t, int64_t, int64_t)
+    METHOD("port", [](TcpReceiver* r) {
+        return r->port();
+    })
+    METHOD("stats", [](TcpReceiver* r) {
+        return r->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Native stages from shared libraries (C ABI in fftvm_plugin.h). The plugin's
+// svc gets the graph's task pointers directly: no packed call per task.
+
+struct PluginLibrary : tvm::ffi::Object {
+    void* m_handle;
+    std::string m_path;
+
+    explicit PluginLibrary(std::string path) : m_path(std::move(path)) {
+        m_handle = dlopen(m_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        tvm_assert(m_handle != nullptr, "PluginNode: cannot load " + m_path + ": " + dlerror());
+    }
+
+    ~PluginLibrary() { dlclose(m_handle); }
+
+    const FFTVMPluginNode* entry(const std::string& symbol) const {
+        dlerror();
+        auto fn = reinterpret_cast<FFTVMPluginEntry>(dlsym(m_handle, symbol.c_str()));
+        tvm_assert(fn != nullptr, "PluginNode: no symbol " + symbol + " in " + m_path);
+        const FFTVMPluginNode* vt = fn();
+        tvm_assert(vt != nullptr && vt->abi_version == FFTVM_PLUGIN_ABI_VERSION,
+                   "PluginNode: " + symbol + " in " + m_path + " does not implement plugin ABI v" +
+                   std::to_string(FFTVM_PLUGIN_ABI_VERSION));
+        tvm_assert(vt->create != nullptr && vt->svc != nullptr && vt->destroy != nullptr,
+                   "PluginNode: " + symbol + " lacks create, svc or destroy");
+        return vt;
+    }
+
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.PluginLibrary", PluginLibrary, tvm::ffi::Object);
+};
+
+struct PluginNode : Node {
+    using Any = tvm::ffi::Any;
+
+    struct PluginNodeImpl : ff::ff_node_t<Any> {
+        // the library must outlive the state: destroyed after ~PluginNodeImpl runs
+        tvm::ffi::ObjectPtr<PluginLibrary> m_library;
+        const FFTVMPluginNode* m_vt;
+        void* m_state;
+        FFTVMPluginHost m_host;
+
+        static TVMFFIAny* host_alloc(void*) {
+            return reinterpret_cast<TVMFFIAny*>(ff_alloc_any(Any()));
+        }
+
+        static void host_free(void*, TVMFFIAny* task) {
+            ff_free_any(reinterpret_cast<Any*>(task));
+        }
+
+        static int host_send_out(void* node, TVMFFIAny* task) {
+            return static_cast<PluginNodeImpl*>(node)->ff_send_out(task) ? 0 : -1;
+        }
+
+        PluginNodeImpl(tvm::ffi::ObjectPtr<PluginLibrary> library, const std::string& symbol, const std::string& config)
+            : m_library(std::move(library)), m_vt(m_library->entry(symbol)) {
+            m_state = m_vt->create(config.data(), config.size());
+            tvm_assert(m_state != nullptr, "PluginNode: " + symbol + " failed to create its state");
+            m_host = FFTVMPluginHost{this, &host_alloc, &host_free, &host_send_out};
+        }
+
+        ~PluginNodeImpl() override { m_vt->destroy(m_state); }
+
+        int svc_init() override {
+            return m_vt->init != nullptr ? m_vt->init(m_state, &m_host) : 0;
+        }
+
+        Any* svc(Any* t) override {
+            t = ff_unshare(t);  // the plugin may update it in place
+            TaskScope scope(t);
+            return reinterpret_cast<Any*>(m_vt->svc(m_state, reinterpret_cast<TVMFFIAny*>(t), &m_host));
+        }
+
+        void svc_end() override {
+            if (m_vt->end != nullptr) m_vt->end(m_state, &m_host);
+        }
+    };
+
+    PluginNode(tvm::ffi::String path, tvm::ffi::String symbol, tvm::ffi::String config) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<PluginNodeImpl>(tvm::ffi::make_object<PluginLibrary>(std::string(path)),
+                                                    std::string(symbol), std::string(config));
+    }
+
+    FFTVM_DECLARE_NODE_INFO(PluginNode);
+};
+
+DEFINE_TVM_OBJECT_REF(PluginNode)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(PluginNode)
+    CONSTRUCTOR(tvm::ffi::String, tvm::ffi::String, tvm::ffi::String)
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// Windowed aggregation. Tasks are grouped by `key(task)` (one group without
+// it) and reduced over tumbling (slide == size) or sliding windows:
+//   count  windows of `size` tasks of the key, starting every `slide` tasks
+//   time   windows of `size` ms starting every `slide` ms, on the event time
+//          `time(task)` (ms) or the arrival time; a window closes once a later
+//          time is seen on any key, tasks older than a closed window are late
+// Each closed window is emitted as {"key", "start", "end", "count", "value"}
+// where value is the reduction of `value(task)` (the task itself by default);
+// windows still open at end of stream are emitted too. Keys are routed to a
+// single node, so the node can be partitioned across a farm by key.
+struct Window : Node {
+    using Any = tvm::ffi::Any;
+    using Fn  = tvm::ffi::Function;
+
+    enum class Reduce { Count, Sum, Min, Max, Mean, TensorSum, Custom };
+
+    // Running reduction of one window; integers stay integers until a float shows up.
+    struct Acc {
+        int64_t count = 0;
+        bool integral = true;
+        int64_t isum = 0, imin = INT64_MAX, imax = INT64_MIN;
+        double fsum = 0, fmin = INFINITY, fmax = -INFINITY;
+        std::vector<double> tensor;
+        std::vector<int64_t> shape;
+        Any state;  // custom reducers
+
+        void add_number(const Any& v) {
+            int32_t ti = v.type_index();
+            if (integral && (ti == TVMFFITypeIndex::kTVMFFIInt || ti == TVMFFITypeIndex::kTVMFFIBool)) {
+                int64_t i = ti == TVMFFITypeIndex::kTVMFFIBool ? int64_t(v.cast<bool>()) : v.cast<int64_t>();
+                isum += i;
+                imin = std::min(imin, i);
+                imax = std::max(imax, i);
+                return;
+            }
+            auto d = v.try_cast<double>();
+            tvm_assert(d.has_value(), "Window: values must be numbers for this reduction");
+            if (integral) {
+                integral = false;
+                fsum = double(isum);
+                if (count > 1) fmin = double(imin), fmax = double(imax);
+            }
+            fsum += *d;
+            fmin = std::min(fmin, *d);
+            fmax = std::max(fmax, *d);
+        }
+
+        void add_tensor(const Any& v) {
+            auto t = v.try_cast<tvm::ffi::Tensor>();
+            tvm_assert(t.has_value(), "Window: tensor_sum needs tensor values");
+            tvm_assert((*t)->device.device_type == kDLCPU && t->IsContiguous(), "Window: tensor_sum needs contiguous CPU tensors");
+            std::vector<int64_t> shape((*t)->shape, (*t)->shape + (*t)->ndim);
+            size_t n = 1;
+            for (int64_t d : shape) n *= size_t(d);
+            if (tensor.empty()) {
+                this->shape = shape;
+                tensor.assign(n, 0.0);
+            }
+            tvm_assert(shape == this->shape, "Window: tensor_sum over tensors of different shapes");
+            for (size_t i = 0; i < n; ++i) tensor[i] += Vectorizer::element(*t->get(), i).cast<double>();
+        }
+
+        void add(Reduce reduce, const Fn& reducer, const Any& v) {
+            ++count;
+            switch (reduce) {
+                case Reduce::Count:     break;
+                case Reduce::TensorSum: add_tensor(v); break;
+                case Reduce::Custom:    state = reducer(state, v); break;
+                default:                add_number(v); break;
+            }
+        }
+
+        Any result(Reduce reduce) const {
+            switch (reduce) {
+                case Reduce::Count: return count;
+                case Reduce::Sum:   return integral ? Any(isum) : Any(fsum);
+                case Reduce::Min:   return integral ? Any(imin) : Any(fmin);
+                case Reduce::Max:   return integral ? Any(imax) : Any(fmax);
+                case Reduce::Mean:  return (integral ? double(isum) : fsum) / double(count);
+                case Reduce::TensorSum: {
+                    tvm::ffi::Shape s(shape.begin(), shape.end());
+                    auto out = tvm::ffi::Tensor::FromNDAlloc(Vectorizer::HostAlloc{}, s, DLDataType{kDLFloat, 64, 1}, DLDevice{kDLCPU, 0});
+                    if (!tensor.empty()) std::memcpy(out->data, tensor.data(), tensor.size() * sizeof(double));
+                    return out;
+                }
+                default: return state;
+            }
+        }
+    };
+
+    struct KeyState {
+        int64_t seen = 0;            // count windows: tasks of this key so far
+        std::map<int64_t, Acc> open;  // by window start
+    };
+
+    struct WindowImpl : ff::ff_minode_t<Any> {
+        bool m_time;
+        int64_t m_size, m_slide;  // tasks, or ns
+        Fn m_key, m_value, m_reducer, m_clock;
+        Reduce m_reduce;
+        std::unordered_map<Any, KeyState, tvm::ffi::AnyHash, tvm::ffi::AnyEqual> m_keys;
+        int64_t m_watermark = INT64_MIN, m_next_close = INT64_MAX;
+        size_t m_eos = 0;
+        std::atomic<uint64_t> m_tasks{0}, m_windows{0}, m_late{0};
+
+        int svc_init() override {
+            m_keys.clear();
+            m_watermark = INT64_MIN;
+            m_next_close = INT64_MAX;
+            m_eos = 0;
+            return 0;
+        }
+
+        static int64_t floor_div(int64_t a, int64_t b) {
+            return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+        }
+
+        void emit(const Any& key, int64_t start, const Acc& acc) {
+            int64_t scale = m_time ? 1000000 : 1;  // time windows are reported in ms
+            tvm::ffi::Map<tvm::ffi::String, Any> w;
+            w.Set("key",   key);
+            w.Set("start", start / scale);
+            w.Set("end",   (start + m_size) / scale);
+            w.Set("count", acc.count);
+            w.Set("value", acc.result(m_reduce));
+            m_windows.fetch_add(1, std::memory_order_relaxed);
+            ff_send_out(ff_alloc_any(Any(std::move(w))));
+        }
+
+        // Emits the windows of `ks` ending at or before `until`, oldest first.
+        void close(const Any& key, KeyState& ks, int64_t until) {
+            while (!ks.open.empty() && ks.open.begin()->first + m_size <= until) {
+                emit(key, ks.open.begin()->first, ks.open.begin()->second);
+                ks.open.erase(ks.open.begin());
+            }
+        }
+
+        void advance(int64_t now) {
+            if (now <= m_watermark) return;
+            m_watermark = now;
+            if (m_watermark < m_next_close) return;
+            m_next_close = INT64_MAX;
+            for (auto it = m_keys.begin(); it != m_keys.end();) {
+                close(it->first, it->second, m_watermark);
+                if (it->second.open.empty()) {
+                    it = m_keys.erase(it);
+                    continue;
+                }
+                m_next_close = std::min(m_next_close, it->second.open.begin()->first + m_size);
+                ++it;
+            }
+        }
+
+        Any* svc(Any* t) override {
+            m_tasks.fetch_add(1, std::memory_order_relaxed);
+            Any key = m_key.defined() ? m_key(*t) : Any();
+            Any value = m_value.defined() ? m_value(*t) : *t;
+            int64_t pos = 0;
+            if (m_time) pos = m_clock.defined() ? int64_t(std::floor(m_clock(*t).cast<double>() * 1e6)) : now_ns();
+            ff_free_any(t);
+
+            KeyState& ks = m_keys[key];
+            if (!m_time) pos = ks.seen++;
+            bool late = false;
+            int64_t first = floor_div(pos - m_size, m_slide) + 1;
+            if (!m_time) first = std::max<int64_t>(first, 0);
+            for (int64_t k = first; k <= floor_div(pos, m_slide); ++k) {
+                int64_t start = k * m_slide;
+                if (m_time && start + m_size <= m_watermark) {  // already closed
+                    late = true;
+                    continue;
+                }
+                ks.open[start].add(m_reduce, m_reducer, value);
+                if (m_time) m_next_close = std::min(m_next_close, start + m_size);
+            }
+            if (m_time) {
+                if (late) m_late.fetch_add(1, std::memory_order_relaxed);
+                advance(pos);
+            } else {
+                close(key, ks, ks.seen);
+            }
+            return GO_ON;
+        }
+
+        void eosnotify(ssize_t) override {
+            if (++m_eos < std::max<size_t>(1, get_num_inchannels())) return;
+            for (auto& [key, ks] : m_keys) close(key, ks, INT64_MAX);
+            m_keys.clear();
+        }
+    };
+
+    Window(tvm::ffi::String kind, int64_t size, int64_t slide, tvm::ffi::Optional<Fn> key, tvm::ffi::Optional<Fn> value,
+           tvm::ffi::String reduce, tvm::ffi::Optional<Fn> reducer, tvm::ffi::Optional<Fn> time)
+        : Node(tvm::ffi::UnsafeInit{}) {
+        std::string k(kind), r(reduce);
+        tvm_assert(k == "count" || k == "time", "Window: kind must be 'count' or 'time', got " + k);
+        tvm_assert(size > 0 && slide >= 0, "Window: size must be > 0 and slide >= 0");
+        static const std::map<std::string, Reduce> reductions = {
+            {"count", Reduce::Count}, {"sum", Reduce::Sum}, {"min", Reduce::Min}, {"max", Reduce::Max},
+            {"mean", Reduce::Mean}, {"tensor_sum", Reduce::TensorSum}, {"custom", Reduce::Custom}};
+        auto it = reductions.find(r);
+        tvm_assert(it != reductions.end(), "Window: unknown reduction " + r);
+        tvm_assert(it->second != Reduce::Custom || reducer.has_value(), "Window: a custom reduction needs a reducer");
+        tvm_assert(k == "time" || !time.has_value(), "Window: a time function needs kind='time'");
+
+        auto impl = std::make_unique<WindowImpl>();
+        int64_t scale = k == "time" ? 1000000 : 1;
+        impl->m_time = k == "time";
+        impl->m_size = size * scale;
+        impl->m_slide = (slide == 0 ? size : slide) * scale;
+        impl->m_key = key.value_or(Fn());
+        impl->m_value = value.value_or(Fn());
+        impl->m_reduce = it->second;
+        impl->m_reducer = reducer.value_or(Fn());
+        impl->m_clock = time.value_or(Fn());
+        m_object = std::move(impl);
+    }
+
+    WindowImpl* get() const {
+        return static_cast<WindowImpl*>(m_object.get());
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("tasks",   int64_t(get()->m_tasks.load(std::memory_order_relaxed)));
+        m.Set("windows", int64_t(get()->m_windows.load(std::memory_order_relaxed)));
+        m.Set("late",    int64_t(get()->m_late.load(std::memory_order_relaxed)));
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(Window);
+};
+
+DEFINE_TVM_OBJECT_REF(Window)
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Window)
+    CONSTRUCTOR(tvm::ffi::String, int64_t, int64_t, tvm::ffi::Optional<tvm::ffi::Function>, tvm::ffi::Optional<tvm::ffi::Function>,
+                tvm::ffi::String, tvm::ffi::Optional<tvm::ffi::Function>, tvm::ffi::Optional<tvm::ffi::Function>)
+    METHOD("stats", [](Window* w) {
+        return w->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+
+// Gives the GIL up for the scope if the calling thread holds it, so that
+// Python callbacks can run on other threads meanwhile (nothing without Python).
+struct GilRelease {
+#ifdef FFTVM_WITH_PYTHON
+    PyThreadState* m_ts = Py_IsInitialized() && PyGILState_Check() ? PyEval_SaveThread() : nullptr;
+    ~GilRelease() { if (m_ts != nullptr) PyEval_RestoreThread(m_ts); }
+#endif
+};
+
+// Intra-task data parallelism: a FastFlow ParallelFor with its own worker
+// threads, for a node to split one heavy task over index ranges. `body(start,
+// stop, thread_id)` is called on chunks of [first, last) (`chunk` indices
+// each, 0 = one static block per worker); use native kernels, Python bodies
+// take the GIL. One loop runs at a time: concurrent callers are serialized.
+struct ParallelFor : tvm::ffi::Object {
+    using Any = tvm::ffi::Any;
+
+    int64_t m_workers;
+    std::unique_ptr<ff::ParallelFor> m_pf;
+    std::mutex m_mu;
+    std::atomic<uint64_t> m_loops{0}, m_chunks{0};
+
+    ParallelFor(int64_t workers, bool spinwait) {
+        tvm_assert(workers >= 0, "ParallelFor: workers must be >= 0");
+        m_workers = workers > 0 ? workers : std::max<int64_t>(1, std::thread::hardware_concurrency());
+        m_pf = std::make_unique<ff::ParallelFor>(m_workers, spinwait);
+    }
+
+    // Runs `f(start, stop, thread_id)` over [first, last); the first exception
+    // thrown by a chunk is rethrown here once every worker is done.
+    template <typename F>
+    void for_each(int64_t first, int64_t last, int64_t step, int64_t chunk, F&& f) {
+        tvm_assert(step > 0 && chunk >= 0, "ParallelFor: step must be > 0 and chunk >= 0");
+        if (first >= last) return;
+        std::lock_guard<std::mutex> lock(m_mu);
+        std::mutex err_mu;
+        std::exception_ptr err;
+        m_pf->parallel_for_idx(first, last, step, chunk, [&](const long start, const long stop, const int thid) {
+            m_chunks.fetch_add(1, std::memory_order_relaxed);
+            try {
+                f(int64_t(start), int64_t(stop), int(thid));
+            } catch (...) {
+                std::lock_guard<std::mutex> g(err_mu);
+                if (!err) err = std::current_exception();
+            }
+        }, m_workers);
+        m_loops.fetch_add(1, std::memory_order_relaxed);
+        if (err) std::rethrow_exception(err);
+    }
+
+    void run(int64_t first, int64_t last, int64_t step, int64_t chunk, const tvm::ffi::Function& body) {
+        for_each(first, last, step, chunk, [&](int64_t start, int64_t stop, int thid) { body(start, stop, thid); });
+    }
+
+    // `body(start, stop, thread_id)` returns the partial result of its chunk;
+    // partials are folded with `combine(a, b)` per worker, then across workers.
+    Any reduce(int64_t first, int64_t last, int64_t step, int64_t chunk, Any identity,
+               const tvm::ffi::Function& body, const tvm::ffi::Function& combine) {
+        std::map<int, Any> partial;  // per worker id as reported by FastFlow
+        std::mutex partial_mu;
+        for_each(first, last, step, chunk, [&](int64_t start, int64_t stop, int thid) {
+            Any* acc;
+            {
+                std::lock_guard<std::mutex> g(partial_mu);
+                acc = &partial.try_emplace(thid, identity).first->second;  // map nodes do not move
+            }
+            *acc = combine(*acc, body(start, stop, thid));
+        });
+        Any r = identity;
+        for (const auto& [thid, p] : partial) r = combine(r, p);
+        return r;
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("workers", m_workers);
+        m.Set("loops",   int64_t(m_loops.load(std::memory_order_relaxed)));
+        m.Set("chunks",  int64_t(m_chunks.load(std::memory_order_relaxed)));
+        return m;
+    }
+
+    static constexpr bool _type_mutable = true;
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.ParallelFor", ParallelFor, tvm::ffi::Object);
+};
+
+DEFINE_TVM_OBJECT_REF(ParallelFor);
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(ParallelFor)
+    CONSTRUCTOR(int64_t, bool)
+    METHOD("run_range", [](ParallelFor* p, int64_t first, int64_t last, int64_t step, int64_t chunk, tvm::ffi::Function body) {
+        GilRelease nogil;  // Python bodies run on the workers
+        p->run(first, last, step, chunk, body);
+    })
+    METHOD("reduce_range", [](ParallelFor* p, int64_t first, int64_t last, int64_t step, int64_t chunk, tvm::ffi::Any identity,
+                              tvm::ffi::Function body, tvm::ffi::Function combine) {
+        GilRelease nogil;
+        return p->reduce(first, last, step, chunk, identity, body, combine);
+    })
+    METHOD("stats", [](ParallelFor* p) {
+        return p->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
+
+// The same loops as global functions, for native code handed the object.
+TVM_FFI_STATIC_INIT_BLOCK() {
+    tvm::ffi::reflection::GlobalDef()
+        .def("fftvm.parallel_for", [](ParallelFor_ref pool, int64_t first, int64_t last, int64_t step, int64_t chunk,
+                                      tvm::ffi::Function body) {
+            GilRelease nogil;
+            const_cast<ParallelFor*>(pool.get())->run(first, last, step, chunk, body);
+        })
+        .def("fftvm.parallel_reduce", [](ParallelFor_ref pool, int64_t first, int64_t last, int64_t step, int64_t chunk,
+                                         tvm::ffi::Any identity, tvm::ffi::Function body, tvm::ffi::Function combine) {
+            GilRelease nogil;
+            return const_cast<ParallelFor*>(pool.get())->reduce(first, last, step, chunk, identity, body, combine);
+        });
+}
+#endif
+
+
+// Result of one task submitted to an Injector, completed by the injector's
+// results() stage with the first task derived from it that reaches it.
+struct Ticket : tvm::ffi::Object {
+    std::mutex m_mu;
+    std::condition_variable m_cv;
+    bool m_done = false;
+    tvm::ffi::Any m_result;
+    std::string m_error;
+
+    void complete(tvm::ffi::Any result, std::string error = "") {
+        {
+            std::lock_guard<std::mutex> lock(m_mu);
+            if (m_done) return;
+            m_done = true;
+            m_result = std::move(result);
+            m_error = std::move(error);
+        }
+        m_cv.notify_all();
+    }
+
+    bool done() {
+        std::lock_guard<std::mutex> lock(m_mu);
+        return m_done;
+    }
+
+    // Waits up to `timeout_ms` (< 0 = forever).
+    tvm::ffi::Any result(int64_t timeout_ms) {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+            if (timeout_ms < 0) m_cv.wait(lock, [this] { return m_done; });
+            else m_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return m_done; });
+            done = m_done;
+        }
+        tvm_assert(done, "Ticket: no result within " + std::to_string(timeout_ms) + " ms");
+        tvm_assert(m_error.empty(), "Ticket: " + m_error);
+        return m_result;
+    }
+
+    static constexpr bool _type_mutable = true;
+    TVM_FFI_DECLARE_OBJECT_INFO_FINAL("fftvm.Ticket", Ticket, tvm::ffi::Object);
+};
+
+DEFINE_TVM_OBJECT_REF(Ticket);
+
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Ticket)
+    METHOD("done", [](Ticket* t) {
+        return t->done();
+    })
+    METHOD("wait_result", [](Ticket* t, int64_t timeout_ms) {
+        GilRelease nogil;  // a Python caller must not stall the graph's Python nodes
+        return t->result(timeout_ms);
+    })
+FFTVM_REGISTER_METHODS_END()
+#endif
+
+// Multi-producer entry point of a graph. Any thread (Python or native) submits
+// tasks concurrently through an intrusive MPSC queue (Vyukov): enqueueing is
+// one atomic exchange, plus a mutex-protected notify when the injector sleeps
+// on an empty queue (it also polls every 1 ms). The injector, used as the
+// first stage (or a farm's emitter), drains it into the graph and sends EOS
+// once closed, drained and with no submit in progress. A submitted task can carry a
+// Ticket: its request id travels in TaskMeta, so the tasks derived from it keep
+// it, and the results() node, used as the last stage (or the farm's
+// collector), completes the ticket with the first of them to arrive. Tickets
+// still pending when the graph ends fail. One injector feeds one run.
+struct Injector : Node {
+    using Any = tvm::ffi::Any;
+
+    struct Cell {
+        std::atomic<Cell*> next{nullptr};
+        Any* task = nullptr;
+        tvm::ffi::ObjectPtr<Ticket> ticket;
+    };
+
+    // Shared by the entry and results() stages.
+    struct State {
+        // the queue: producers exchange m_head, the entry owns m_tail
+        alignas(64) std::atomic<Cell*> m_head;
+        alignas(64) Cell* m_tail;
+        Cell m_stub;
+        std::atomic<bool> m_closed{false}, m_sleeping{false};
+        std::atomic<int64_t> m_submitting{0};  // submits between their closed check and their push
+        std::mutex m_wake_mu;
+        std::condition_variable m_wake;
+
+        std::mutex m_mu;  // m_pending, between the entry and results() threads
+        std::unordered_map<uint64_t, tvm::ffi::ObjectPtr<Ticket>> m_pending;
+        std::atomic<uint64_t> m_next_request{1};
+        std::atomic<uint64_t> m_submitted{0}, m_injected{0}, m_completed{0}, m_unmatched{0}, m_failed{0};
+
+        State() : m_head(&m_stub), m_tail(&m_stub) {}
+
+        ~State() {
+            while (Cell* c = pop()) {  // never injected (the graph did not run to the end)
+                if (c->ticket != nullptr) c->ticket->complete(Any(), "the injector was destroyed before injecting the task");
+                ff_free_any(c->task);
+                delete c;
+            }
+        }
 
-    ff::ff_pipeline* get() const {
-        return static_cast<ff::ff_pipeline*>(m_object.get());    
+        void push(Cell* c) {
+            Cell* prev = m_head.exchange(c, std::memory_order_acq_rel);
+            prev->next.store(c, std::memory_order_release);
+            if (m_sleeping.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(m_wake_mu);
+                m_wake.notify_one();
+            }
+        }
+
+        // Single consumer. Returns the cell holding the next task, or nullptr
+        // (also while a producer is between its exchange and its link).
+        Cell* pop() {
+            Cell* tail = m_tail;
+            Cell* next = tail->next.load(std::memory_order_acquire);
+            if (tail == &m_stub) {
+                if (next == nullptr) return nullptr;
+                m_tail = tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if (next != nullptr) {
+                m_tail = next;
+                return tail;
+            }
+            if (tail != m_head.load(std::memory_order_acquire)) return nullptr;
+            // tail is the last cell: put the stub behind it to take it out
+            m_stub.next.store(nullptr, std::memory_order_relaxed);
+            Cell* prev = m_head.exchange(&m_stub, std::memory_order_acq_rel);
+            prev->next.store(&m_stub, std::memory_order_release);
+            next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) return nullptr;
+            m_tail = next;
+            return tail;
+        }
+
+        // Consumer side: nothing pushed past the stub.
+        bool empty() const {
+            return m_tail == &m_stub && m_head.load(std::memory_order_acquire) == &m_stub;
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(m_wake_mu);
+            m_sleeping.store(true, std::memory_order_seq_cst);
+            if (empty() && !m_closed.load()) m_wake.wait_for(lock, std::chrono::milliseconds(1));
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    struct Entry : ff::ff_node_t<Any> {
+        std::shared_ptr<State> m_state;
+
+        explicit Entry(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+        Any* svc(Any*) override {
+            State& s = *m_state;
+            while (true) {
+                Cell* c = s.pop();
+                if (c == nullptr) {
+                    if (s.m_closed.load() && s.m_submitting.load() == 0 && s.empty()) return EOS;
+                    s.wait();
+                    continue;
+                }
+                if (c->ticket != nullptr) {
+                    std::lock_guard<std::mutex> lock(s.m_mu);
+                    s.m_pending.emplace(task_meta(c->task)->request, std::move(c->ticket));
+                }
+                Any* t = c->task;
+                delete c;
+                s.m_injected.fetch_add(1, std::memory_order_relaxed);
+                ff_send_out(t);
+            }
+        }
+    };
+
+    struct Results : ff::ff_minode_t<Any> {
+        std::shared_ptr<State> m_state;
+
+        explicit Results(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+        Any* svc(Any* t) override {
+            State& s = *m_state;
+            tvm::ffi::ObjectPtr<Ticket> ticket;
+            if (uint64_t request = task_meta(t)->request) {
+                std::lock_guard<std::mutex> lock(s.m_mu);
+                auto it = s.m_pending.find(request);
+                if (it != s.m_pending.end()) {
+                    ticket = std::move(it->second);
+                    s.m_pending.erase(it);
+                }
+            }
+            if (ticket != nullptr) {
+                ticket->complete(*t);  // a copy: the task may be shared
+                s.m_completed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                s.m_unmatched.fetch_add(1, std::memory_order_relaxed);
+            }
+            ff_free_any(t);
+            return GO_ON;
+        }
+
+        void svc_end() override {
+            State& s = *m_state;
+            std::lock_guard<std::mutex> lock(s.m_mu);
+            for (auto& [request, ticket] : s.m_pending) {
+                ticket->complete(Any(), "the graph ended without a result for this task");
+                s.m_failed.fetch_add(1, std::memory_order_relaxed);
+            }
+            s.m_pending.clear();
+        }
+    };
+
+    std::shared_ptr<State> m_state;
+    tvm::ffi::ObjectRef m_results;
+
+    Injector();
+
+    tvm::ffi::Optional<Ticket_ref> submit(Any task, bool want_result) {
+        State& s = *m_state;
+        // close() and the entry's EOS check order against this (seq_cst): a
+        // submit either sees closed or is waited for
+        s.m_submitting.fetch_add(1);
+        struct Done {
+            State& s;
+            ~Done() { s.m_submitting.fetch_sub(1); }
+        } done{s};
+        tvm_assert(!s.m_closed.load(), "Injector: submit after close()");
+        auto c = new Cell();
+        c->task = ff_alloc_any(std::move(task));
+        tvm::ffi::Optional<Ticket_ref> out;
+        task_meta(c->task)->request = 0;  // not one submitted from a node's task
+        if (want_result) {
+            c->ticket = tvm::ffi::make_object<Ticket>();
+            task_meta(c->task)->request = s.m_next_request.fetch_add(1, std::memory_order_relaxed);
+            out = Ticket_ref(c->ticket);
+        }
+        s.m_submitted.fetch_add(1, std::memory_order_relaxed);
+        s.push(c);
+        return out;
     }
 
-    FFTVM_DECLARE_NODE_INFO(Pipeline);
+    void close() {
+        m_state->m_closed.store(true);
+        std::lock_guard<std::mutex> lock(m_state->m_wake_mu);
+        m_state->m_wake.notify_one();
+    }
+
+    tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> stats() const {
+        State& s = *m_state;
+        tvm::ffi::Map<tvm::ffi::String, tvm::ffi::Any> m;
+        m.Set("submitted", int64_t(s.m_submitted.load(std::memory_order_relaxed)));
+        m.Set("injected",  int64_t(s.m_injected.load(std::memory_order_relaxed)));
+        m.Set("completed", int64_t(s.m_completed.load(std::memory_order_relaxed)));
+        m.Set("unmatched", int64_t(s.m_unmatched.load(std::memory_order_relaxed)));
+        m.Set("failed",    int64_t(s.m_failed.load(std::memory_order_relaxed)));
+        m.Set("closed",    s.m_closed.load());
+        return m;
+    }
+
+    FFTVM_DECLARE_NODE_INFO(Injector);
 };
 
-DEFINE_TVM_OBJECT_REF(Pipeline)
+// The results() stage of an Injector.
+struct InjectorResults : Node {
+    explicit InjectorResults(std::shared_ptr<Injector::State> state) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::make_unique<Injector::Results>(std::move(state));
+    }
 
-#ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(Pipeline)
-    CONSTRUCTOR();
+    FFTVM_DECLARE_NODE_INFO(InjectorResults);
+};
 
-    METHOD("add_stage", [](Pipeline* t, Node_ref n){
-        t->m_owned_deps.emplace_back(n);
-        t->get()->add_stage(n->m_object.get());
-        return t;
-    })
+inline Injector::Injector() : Node(tvm::ffi::UnsafeInit{}), m_state(std::make_shared<State>()) {
+    m_object = std::make_unique<Entry>(m_state);
+    m_results = tvm::ffi::ObjectRef(tvm::ffi::make_object<InjectorResults>(m_state));
+}
 
-    METHOD("run", [](Pipeline* t, bool skip_init = false) {
-        t->get()->run();
-    })
+DEFINE_TVM_OBJECT_REF(Injector)
+DEFINE_TVM_OBJECT_REF(InjectorResults)
 
-    METHOD("wait", [](Pipeline* t) {
-        t->get()->wait();
+#ifdef FFTVM_IMPL
+FFTVM_REGISTER_METHODS(Injector)
+    CONSTRUCTOR()
+    METHOD("submit_task", [](Injector* i, tvm::ffi::Any task, bool want_result) {
+        return i->submit(std::move(task), want_result);
     })
-
-    METHOD("run_and_wait_end", [](Pipeline* t) {
-        t->get()->run_and_wait_end();
+    METHOD("close", [](Injector* i) {
+        i->close();
     })
+    METHOD("results", [](Injector* i) {
+        return i->m_results;
+    })
+    METHOD("stats", [](Injector* i) {
+        return i->stats();
+    })
+FFTVM_REGISTER_METHODS_END()
 
-    // METHOD("wrap_around", [](Pipeline* f) {
-    //     tvm_assert(t->get()->wrap_around() == 0, "error while calling ff_pipeline::wrap_around");
-    //     return f;
-    // })
-
+FFTVM_REGISTER_METHODS(InjectorResults)
+SUPPRESS_NO_METHOD_WARNING();
 FFTVM_REGISTER_METHODS_END()
 #endif
 
+// ---------------------------------------------------------------------------
+// Declarative topologies. A spec is a tree of maps (a TVM Map, or the same as
+// JSON) from which the whole graph is built in one call, with no Python
+// object per node:
+//
+//   {"type": "pipeline", "stages": [spec, ...]}
+//   {"type": "farm", "workers": [spec, ...]}   or  "worker": spec, "replicas": n
+//       optional: "emitter": spec, "collector": spec or null (FastFlow's
+//       default collector; no key, no collector), "ondemand": n
+//   {"type": "a2a", "first": [spec, ...], "second": [spec, ...]}
+//   {"type": "loop", "body": [spec, ...], "max_iterations": n, optional: "converged": fn}
+//   {"type": "siso" | "simo" | "miso" | "mimo", "svc": fn,
+//       optional: "svc_init", "svc_end", "eosnotify": fn;
+//       simo and mimo only: "routing": strategy, "route_fn": fn (see Router)}
+//   {"type": "mmap_source", "path": str,
+//       optional: "record_shape", "dtype", "readahead", "header_bytes"}
+//   {"type": "plugin", "path": str, "symbol": str, optional: "config": str}
+//   {"type": "window", "size": n, optional: "slide": n, "kind": "count" | "time",
+//       "key", "value", "time": fn, "reduce": name, "reducer": fn}
+//
+// A fn is the name of a global function, or {"module": path, "function":
+// name} (each module is loaded once per build); a Function object also works
+// but cannot be saved. Native callbacks get no node
+// handle: svc(task), svc_init(), svc_end(), eosnotify(channel id).
+namespace topology {
+
+using Any  = tvm::ffi::Any;
+using Spec = tvm::ffi::Map<tvm::ffi::Any, tvm::ffi::Any>;
+
+constexpr int kNativeCallbacks = node_call::kTask | node_call::kInitBound | node_call::kEndBound |
+                                 node_call::kEosBound | node_call::kEosWithId;
+
+struct Builder {
+    std::map<std::string, Any> m_modules;
+
+    static Spec as_spec(const Any& v, const std::string& at) {
+        tvm_assert(v.type_index() == TVMFFITypeIndex::kTVMFFIMap, "topology: " + at + " must be a map");
+        return v.cast<Spec>();
+    }
+
+    static std::optional<Any> field(const Spec& s, const char* key) {
+        auto it = s.find(tvm::ffi::String(key));
+        if (it == s.end()) return std::nullopt;
+        return (*it).second;
+    }
 
-struct Farm : Node {
-    Farm() : Node(ff::ff_farm()) {}
+    static Any require(const Spec& s, const char* key, const std::string& at) {
+        auto v = field(s, key);
+        tvm_assert(v.has_value(), "topology: " + at + " has no \"" + key + "\"");
+        return *v;
+    }
 
-    std::vector<tvm::ffi::Any> m_owned_deps;
+    static std::string str(const Spec& s, const char* key, const std::string& at) {
+        auto v = require(s, key, at).try_cast<tvm::ffi::String>();
+        tvm_assert(v.has_value(), "topology: " + at + "." + key + " must be a string");
+        return std::string(*v);
+    }
 
-    ff::ff_farm* get() const {
-        return static_cast<ff::ff_farm*>(m_object.get());    
+    static int64_t integer(const Spec& s, const char* key, int64_t dflt, const std::string& at) {
+        auto v = field(s, key);
+        if (!v.has_value()) return dflt;
+        auto i = v->try_cast<int64_t>();
+        tvm_assert(i.has_value(), "topology: " + at + "." + key + " must be an integer");
+        return *i;
     }
 
-    FFTVM_DECLARE_NODE_INFO(Farm);
-    
-};
+    static tvm::ffi::Array<Any> list(const Spec& s, const char* key, const std::string& at) {
+        auto v = require(s, key, at);
+        tvm_assert(v.type_index() == TVMFFITypeIndex::kTVMFFIArray, "topology: " + at + "." + key + " must be a list");
+        return v.cast<tvm::ffi::Array<Any>>();
+    }
 
-DEFINE_TVM_OBJECT_REF(Farm)
+    tvm::ffi::Function function(const Any& v, const std::string& at) {
+        if (auto fn = v.try_cast<tvm::ffi::Function>()) return *fn;  // in-process specs only
+        if (auto name = v.try_cast<tvm::ffi::String>()) {
+            auto fn = tvm::ffi::Function::GetGlobal(std::string(*name));
+            tvm_assert(fn.has_value(), "topology: " + at + ": no global function \"" + std::string(*name) + "\"");
+            return *fn;
+        }
+        Spec s = as_spec(v, at);
+        std::string path = str(s, "module", at), name = str(s, "function", at);
+        auto it = m_modules.find(path);
+        if (it == m_modules.end()) {
+            static auto load = tvm::ffi::Function::GetGlobalRequired("ffi.ModuleLoadFromFile");
+            it = m_modules.emplace(path, load(tvm::ffi::String(path))).first;
+        }
+        static auto get = tvm::ffi::Function::GetGlobalRequired("ffi.ModuleGetFunction");
+        auto fn = get(it->second, tvm::ffi::String(name), true).cast<tvm::ffi::Optional<tvm::ffi::Function>>();
+        tvm_assert(fn.has_value(), "topology: " + at + ": no function \"" + name + "\" in " + path);
+        return *fn;
+    }
 
-#ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(Farm)
-    CONSTRUCTOR()
-    METHOD("add_workers", [](Farm* f, tvm::ffi::Array<Node_ref> w) {
-        std::set<ff::ff_node *> ptr_set;
-        for (const auto& n : w) {
-            auto ptr = n->m_object.get();
-            tvm_assert(ptr_set.find(ptr) == ptr_set.end(), 
-            "You are trying to construct a farm with multiple instances of the same fastflow node! "
-                "Common python error: farm.add_workers([worker_node] * N). Tips: you must construct workers indipendently!"
-            );
+    tvm::ffi::Optional<tvm::ffi::Function> maybe_function(const Spec& s, const char* key, const std::string& at) {
+        auto v = field(s, key);
+        if (!v.has_value() || v->type_index() == TVMFFITypeIndex::kTVMFFINone) return std::nullopt;
+        return function(*v, at + "." + key);
+    }
 
-            ptr_set.insert(ptr);
+    template <typename T>
+    tvm::ffi::ObjectPtr<T> user_node(const Spec& s, const std::string& at) {
+        auto optional = [&](const char* key) {
+            auto v = field(s, key);
+            if (!v.has_value() || v->type_index() == TVMFFITypeIndex::kTVMFFINone) return tvm::ffi::Function();
+            return function(*v, at + "." + key);
+        };
+        auto svc = function(require(s, "svc", at), at + ".svc");
+        return tvm::ffi::make_object<T>(
+            svc, kNativeCallbacks, optional("svc_init"), optional("svc_end"), optional("eosnotify"));
+    }
+
+    void routing(Router& router, const Spec& s, const std::string& at) {
+        if (!field(s, "routing").has_value()) return;
+        auto fn = field(s, "route_fn");
+        router.configure(str(s, "routing", at), fn.has_value() ? function(*fn, at + ".route_fn") : tvm::ffi::Function());
+    }
+
+    tvm::ffi::Array<Node_ref> nodes(const Spec& s, const char* key, const std::string& at) {
+        tvm::ffi::Array<Node_ref> out;
+        auto specs = list(s, key, at);
+        for (size_t i = 0; i < specs.size(); ++i) {
+            out.push_back(build(specs[i], at + "." + key + "[" + std::to_string(i) + "]"));
         }
+        return out;
+    }
 
-        f->get()->add_workers(std::vector<ff::ff_node *>(ptr_set.begin(), ptr_set.end()));
+    Node_ref build(const Any& v, const std::string& at) {
+        Spec s = as_spec(v, at);
+        std::string type = str(s, "type", at);
 
-        for (const auto& n : w) {
-            f->m_owned_deps.emplace_back(n);
+        if (type == "pipeline") {
+            auto p = tvm::ffi::make_object<Pipeline>();
+            auto stages = nodes(s, "stages", at);
+            tvm_assert(!stages.empty(), "topology: " + at + " has no stages");
+            for (const auto& n : stages) p->add_stage(n);
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(p));
         }
-        return f;
-    })
-    
-    METHOD("add_collector", [](Farm* f, tvm::ffi::Optional<Node_ref> copt) {
-        if (!copt.has_value()) {
-            f->get()->add_collector(nullptr);
-            return f;
+
+        if (type == "farm") {
+            auto f = tvm::ffi::make_object<Farm>();
+            tvm::ffi::Array<Node_ref> workers;
+            if (field(s, "worker").has_value()) {
+                // one spec, instantiated `replicas` times
+                int64_t replicas = integer(s, "replicas", 1, at);
+                tvm_assert(replicas > 0, "topology: " + at + ".replicas must be > 0");
+                for (int64_t i = 0; i < replicas; ++i) {
+                    workers.push_back(build(require(s, "worker", at), at + ".worker#" + std::to_string(i)));
+                }
+            } else {
+                workers = nodes(s, "workers", at);
+            }
+            tvm_assert(!workers.empty(), "topology: " + at + " has no workers");
+            if (auto e = field(s, "emitter")) f->add_emitter(build(*e, at + ".emitter"));
+            f->add_workers(workers);
+            if (auto c = field(s, "collector")) {
+                f->add_collector(c->type_index() == TVMFFITypeIndex::kTVMFFINone
+                                     ? tvm::ffi::Optional<Node_ref>()
+                                     : tvm::ffi::Optional<Node_ref>(build(*c, at + ".collector")));
+            }
+            if (auto q = integer(s, "ondemand", 0, at); q > 0) f->get()->set_scheduling_ondemand(int(q));
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(f));
         }
 
-        f->get()->add_collector(copt.value()->m_object.get());
-        f->m_owned_deps.emplace_back(copt.value());
-        return f;
-    })
+        if (type == "a2a") {
+            auto a = tvm::ffi::make_object<A2A>();
+            a->add_firstset(nodes(s, "first", at));
+            a->add_secondset(nodes(s, "second", at));
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(a));
+        }
 
-    METHOD("add_emitter", [](Farm* f, tvm::ffi::Optional<Node_ref> eopt) {
-        if (!eopt.has_value()) {
-            f->get()->add_collector(nullptr);
-            return f;
+        if (type == "loop") {
+            auto v = field(s, "converged");
+            tvm::ffi::Optional<tvm::ffi::Function> converged;
+            if (v.has_value() && v->type_index() != TVMFFITypeIndex::kTVMFFINone) converged = function(*v, at + ".converged");
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(tvm::ffi::make_object<Loop>(
+                nodes(s, "body", at), integer(s, "max_iterations", 0, at), converged)));
         }
 
-        f->get()->add_emitter(eopt.value()->m_object.get());
-        f->m_owned_deps.emplace_back(eopt.value());
-        return f;
-    })
+        if (type == "siso") return Node_ref(tvm::ffi::ObjectPtr<Node>(user_node<SiSoNode>(s, at)));
+        if (type == "simo") {
+            auto n = user_node<SiMoNode>(s, at);
+            routing(n->get()->m_router, s, at);
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(n));
+        }
+        if (type == "miso") return Node_ref(tvm::ffi::ObjectPtr<Node>(user_node<MiSoNode>(s, at)));
+        if (type == "mimo") {
+            auto n = user_node<MiMoNode>(s, at);
+            routing(n->get()->out().m_router, s, at);
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(n));
+        }
 
-    METHOD("wrap_around", [](Farm* f) {
-        tvm_assert(f->get()->wrap_around() == 0, "error while calling ff_farm::wrap_around");
-        return f;
-    })
+        if (type == "window") {
+            auto reducer = maybe_function(s, "reducer", at);
+            std::string reduce = field(s, "reduce").has_value() ? str(s, "reduce", at) : reducer.has_value() ? "custom" : "count";
+            std::string kind = field(s, "kind").has_value() ? str(s, "kind", at) : "count";
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(tvm::ffi::make_object<Window>(
+                tvm::ffi::String(kind), integer(s, "size", 0, at), integer(s, "slide", 0, at),
+                maybe_function(s, "key", at), maybe_function(s, "value", at), tvm::ffi::String(reduce), reducer,
+                maybe_function(s, "time", at))));
+        }
 
-    METHOD("run_and_wait_end", [](Farm* t) {
-        t->get()->run_and_wait_end();
-    })
+        if (type == "plugin") {
+            std::string config = field(s, "config").has_value() ? str(s, "config", at) : "";
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(tvm::ffi::make_object<PluginNode>(
+                tvm::ffi::String(str(s, "path", at)), tvm::ffi::String(str(s, "symbol", at)), tvm::ffi::String(config))));
+        }
 
-    
-    METHOD("debug_info", [](Farm* f) {
-        std::cout << "FarmNode debug infos:" << std::endl;
-        std::cout << "Cardinality: " << f->get()->cardinality() << std::endl;
-        std::cout << "isMultiOutput: " << f->get()->isMultiOutput() << std::endl;
-        std::cout << "isMultiInput: " << f->get()->isMultiInput() << std::endl;
-        // std::cout << "get_num_inchannels: " << f->get()->get_num_inchannels() << std::endl;
-        // std::cout << "get_num_outchannels: " << f->get()->get_num_outchannels() << std::endl;
-        std::cout << std::endl;
+        if (type == "mmap_source") {
+            tvm::ffi::Array<int64_t> shape;
+            if (auto r = field(s, "record_shape")) shape = r->cast<tvm::ffi::Array<int64_t>>();
+            std::string dtype = field(s, "dtype").has_value() ? str(s, "dtype", at) : "";
+            return Node_ref(tvm::ffi::ObjectPtr<Node>(tvm::ffi::make_object<MmapSource>(
+                tvm::ffi::String(str(s, "path", at)), shape, tvm::ffi::String(dtype),
+                integer(s, "readahead", 64, at), integer(s, "header_bytes", 0, at))));
+        }
 
-        return f;
-    });
-FFTVM_REGISTER_METHODS_END()
-#endif
+        tvm_assert(false, "topology: " + at + ": unknown node type \"" + type + "\"");
+        return Node_ref(tvm::ffi::UnsafeInit{});
+    }
+};
 
-struct A2A : Node {
-    A2A() : Node(ff::ff_a2a()) {}
+// `spec` is a Map or its JSON text.
+static Node_ref build(const Any& spec) {
+    if (auto text = spec.try_cast<tvm::ffi::String>()) {
+        tvm::ffi::String error;
+        Any parsed = tvm::ffi::json::Parse(*text, &error);
+        tvm_assert(error.empty(), "topology: invalid JSON: " + std::string(error));
+        return Builder().build(parsed, "root");
+    }
+    return Builder().build(spec, "root");
+}
 
-    std::vector<tvm::ffi::Any> m_owned_deps;
+static Node_ref load(const std::string& path) {
+    std::ifstream in(path);
+    tvm_assert(in.good(), "topology: cannot open " + path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return build(tvm::ffi::String(text.str()));
+}
 
-    ff::ff_a2a* get() const {
-        return static_cast<ff::ff_a2a*>(m_object.get());    
+static void save(const Any& spec, const std::string& path) {
+    tvm_assert(spec.type_index() == TVMFFITypeIndex::kTVMFFIMap, "topology: the spec must be a map");
+    std::ofstream out(path);
+    tvm_assert(out.good(), "topology: cannot write " + path);
+    out << std::string(tvm::ffi::json::Stringify(spec, 2)) << "\n";
+    tvm_assert(out.good(), "topology: error while writing " + path);
+}
+
+// Runs a built topology to the end (its root must be a pipeline, farm or a2a).
+static void run(const Node_ref& root) {
+    int ret = -1;
+    if (auto p = root.as<Pipeline>()) ret = p->get()->run_and_wait_end();
+    else if (auto f = root.as<Farm>()) ret = f->get()->run_and_wait_end();
+    else if (auto a = root.as<A2A>()) ret = a->get()->run_and_wait_end();
+    else tvm_assert(false, "topology: only a pipeline, farm or a2a can be run");
+    tvm_assert(ret >= 0, "topology: run_and_wait_end failed");
+}
+
+} // namespace topology
+
+#ifdef FFTVM_IMPL
+TVM_FFI_STATIC_INIT_BLOCK() {
+    tvm::ffi::reflection::GlobalDef()
+        .def("fftvm.build_topology", [](tvm::ffi::Any spec) {
+            return topology::build(spec);
+        })
+        .def("fftvm.load_topology", [](tvm::ffi::String path) {
+            return topology::load(path);
+        })
+        .def("fftvm.save_topology", [](tvm::ffi::Any spec, tvm::ffi::String path) {
+            topology::save(spec, path);
+        })
+        .def("fftvm.run_topology", [](tvm::ffi::String path) {
+            topology::run(topology::load(path));
+        });
+}
+#endif
+
+
+// ---------------------------------------------------------------------------
+// Typed C++ nodes (header-only use of libfftvm.hpp). Stages are declared with
+// concrete task types and C++ callables, and compile to ff_node_t<In, Out>
+// subclasses: no Any boxing and no packed-call dispatch on the hot path. They
+// are wrapped in a NativeNode, so they compose with the FFI Pipeline/Farm like
+// any other node; typed::pipeline/farm additionally check at compile time that
+// consecutive stages agree on their task type.
+//
+// Typed tasks are allocated with typed::make (FastFlow's allocator) and owned
+// by whoever holds the pointer, as usual in FastFlow. Typed segments carry no
+// TaskMeta: use typed::from_any/to_any at the boundary with Any nodes.
+
+// Node wrapping any native FastFlow node.
+struct NativeNode : Node {
+    explicit NativeNode(std::unique_ptr<ff::ff_node> impl) : Node(tvm::ffi::UnsafeInit{}) {
+        m_object = std::move(impl);
     }
 
-    FFTVM_DECLARE_NODE_INFO(A2A);
+    FFTVM_DECLARE_NODE_INFO(NativeNode);
 };
 
+DEFINE_TVM_OBJECT_REF(NativeNode)
 
-DEFINE_TVM_OBJECT_REF(A2A)
 #ifdef FFTVM_IMPL
-FFTVM_REGISTER_METHODS(A2A)
-CONSTRUCTOR()
-    METHOD("add_firstset", [](A2A* t, tvm::ffi::Array<Node_ref> w){
-        std::set<ff::ff_node *> ptr_set;
-        for (const auto& n : w) {
-            auto ptr = n->m_object.get();
-            tvm_assert(ptr_set.find(ptr) == ptr_set.end(), 
-            "You are trying to construct an a2a with multiple instances of the same fastflow node! "
-                "Common python error: a2a.add_firstset([worker_node] * N). Tips: you must construct workers indipendently!"
-            );
+FFTVM_REGISTER_METHODS(NativeNode)
+SUPPRESS_NO_METHOD_WARNING();
+FFTVM_REGISTER_METHODS_END()
+#endif
 
-            ptr_set.insert(ptr);
-        }
+namespace typed {
+
+// Any tasks are shared with FFI nodes, so they carry a TaskMeta header
+// (ff_alloc_any / ff_free_any); other types are plain allocations.
+template <typename T, typename... Args>
+static inline T* make(Args&&... args) {
+    if constexpr (std::is_same_v<T, tvm::ffi::Any>) {
+        return ff_alloc_any(tvm::ffi::Any(std::forward<Args>(args)...));
+    } else {
+        void* raw = ff::FFAllocator::instance()->malloc(sizeof(T));
+        tvm_assert(raw != nullptr, "Out of memory");
+        return new (raw) T(std::forward<Args>(args)...);
+    }
+}
 
+template <typename T>
+static inline void destroy(T* t) {
+    if constexpr (std::is_same_v<T, tvm::ffi::Any>) {
+        ff_free_any(t);
+    } else {
+        t->~T();
+        ff::FFAllocator::instance()->free(t);
+    }
+}
 
-        for (const auto& n : w) {
-            t->m_owned_deps.emplace_back(n);
-        }
+// Metadata of an Any input, inherited by what the stage allocates.
+template <typename In>
+struct InScope {
+    explicit InScope(In*) {}
+    void dropped() const {}
+};
 
-        t->get()->add_firstset(std::vector<ff::ff_node *>(ptr_set.begin(), ptr_set.end()));
+template <>
+struct InScope<tvm::ffi::Any> : TaskScope {
+    explicit InScope(tvm::ffi::Any* t) : TaskScope(t) {}
+};
 
-        return t;
-    })
+// Node_ref tagged with its task types (void: source input / sink output).
+template <typename In, typename Out>
+struct Ref {
+    using in_type  = In;
+    using out_type = Out;
+    Node_ref node;
+};
 
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
 
-    METHOD("add_secondset", [](A2A* t, tvm::ffi::Array<Node_ref> w){
-        std::set<ff::ff_node *> ptr_set;
-        for (const auto& n : w) {
-            auto ptr = n->m_object.get();
-            tvm_assert(ptr_set.find(ptr) == ptr_set.end(), 
-            "You are trying to construct an a2a with multiple instances of the same fastflow node! "
-                "Common python error: a2a.add_secondset([worker_node] * N). Tips: you must construct workers indipendently!"
-            );
+template <typename In, typename Out>
+static inline Ref<In, Out> wrap(std::unique_ptr<ff::ff_node> impl) {
+    return {Node_ref(tvm::ffi::ObjectPtr<Node>(tvm::ffi::make_object<NativeNode>(std::move(impl))))};
+}
 
-            ptr_set.insert(ptr);
-        }
+// `fn` is called repeatedly; each value is emitted until it returns nullopt.
+template <typename Out, typename F>
+struct Source : ff::ff_node_t<Out> {
+    F m_fn;
+    explicit Source(F fn) : m_fn(std::move(fn)) {}
 
+    Out* svc(Out*) override {
+        while (auto r = m_fn()) this->ff_send_out(make<Out>(std::move(*r)));
+        return this->EOS;
+    }
+};
 
-        for (const auto& n : w) {
-            t->m_owned_deps.emplace_back(n);
+// `fn(In&)` returning Out (a new task), std::optional<Out> (nullopt filters
+// the task out), or void when In == Out (the task is updated in place and
+// forwarded, without an allocation).
+template <typename In, typename Out, typename F>
+struct Map : ff::ff_node_t<In, Out> {
+    F m_fn;
+    explicit Map(F fn) : m_fn(std::move(fn)) {}
+
+    Out* svc(In* t) override {
+        using R = std::invoke_result_t<F&, In&>;
+        if constexpr (std::is_void_v<R>) {
+            static_assert(std::is_same_v<In, Out>, "typed::map: an in-place stage must have In == Out");
+            if constexpr (std::is_same_v<In, tvm::ffi::Any>) t = ff_unshare(t);
+            m_fn(*t);
+            return t;
+        } else if constexpr (is_optional<R>::value) {
+            InScope<In> scope(t);
+            auto r = m_fn(*t);
+            destroy(t);
+            if (!r) {
+                scope.dropped();
+                return this->GO_ON;
+            }
+            return make<Out>(std::move(*r));
+        } else {
+            InScope<In> scope(t);
+            Out r = m_fn(*t);
+            destroy(t);
+            return make<Out>(std::move(r));
         }
+    }
+};
 
-        t->get()->add_secondset(std::vector<ff::ff_node *>(ptr_set.begin(), ptr_set.end()));
+template <typename In, typename F>
+struct Sink : ff::ff_node_t<In> {
+    F m_fn;
+    explicit Sink(F fn) : m_fn(std::move(fn)) {}
 
-        return t;
-    })
+    In* svc(In* t) override {
+        m_fn(*t);
+        destroy(t);
+        return this->GO_ON;
+    }
+};
 
-    METHOD("run_and_wait_end", [](A2A* t) {
-        t->get()->run_and_wait_end();
-    })
+template <typename T>
+struct FromAny : ff::ff_node_t<tvm::ffi::Any, T> {
+    T* svc(tvm::ffi::Any* t) override {
+        T* r = make<T>(t->cast<T>());
+        ff_free_any(t);
+        return r;
+    }
+};
 
-    METHOD("debug_info", [](A2A* t) {
-        std::cout << "A2ANode debug infos:" << std::endl;
-        std::cout << "Cardinality: " << t->get()->cardinality() << std::endl;
-        // std::cout << "get_num_inchannels: " << t->get()->get_num_inchannels() << std::endl;
-        // std::cout << "get_num_outchannels: " << t->get()->get_num_outchannels() << std::endl;
-        ff::svector<ff::ff_node *> o_nodes; 
-        ff::svector<ff::ff_node *> i_nodes; 
-        t->get()->get_out_nodes(o_nodes);
-        t->get()->get_in_nodes(i_nodes);
-        std::cout << "in_nodes size: " << i_nodes.size() << std::endl;
-        std::cout << "out_nodes size: " << o_nodes.size() << std::endl;
-        std::cout << std::endl;
-        return t;
-    })
-FFTVM_REGISTER_METHODS_END()
-#endif
+template <typename T>
+struct ToAny : ff::ff_node_t<T, tvm::ffi::Any> {
+    tvm::ffi::Any* svc(T* t) override {
+        tvm::ffi::Any* r = ff_alloc_any(tvm::ffi::Any(std::move(*t)));
+        destroy(t);
+        return r;
+    }
+};
+
+template <typename Out, typename F>
+static inline Ref<void, Out> source(F fn) {
+    return wrap<void, Out>(std::make_unique<Source<Out, F>>(std::move(fn)));
+}
+
+template <typename In, typename Out, typename F>
+static inline Ref<In, Out> map(F fn) {
+    return wrap<In, Out>(std::make_unique<Map<In, Out, F>>(std::move(fn)));
+}
+
+template <typename In, typename F>
+static inline Ref<In, void> sink(F fn) {
+    return wrap<In, void>(std::make_unique<Sink<In, F>>(std::move(fn)));
+}
+
+// Boundaries with Any nodes (T must convert to/from Any).
+template <typename T>
+static inline Ref<tvm::ffi::Any, T> from_any() { return wrap<tvm::ffi::Any, T>(std::make_unique<FromAny<T>>()); }
+
+template <typename T>
+static inline Ref<T, tvm::ffi::Any> to_any() { return wrap<T, tvm::ffi::Any>(std::make_unique<ToAny<T>>()); }
+
+// An FFI node, seen as Any -> Any.
+static inline Ref<tvm::ffi::Any, tvm::ffi::Any> dynamic(Node_ref node) { return {std::move(node)}; }
+
+// Own ff_node_t<In, Out> subclasses.
+template <typename Impl>
+static inline auto node(std::unique_ptr<Impl> impl) {
+    return wrap<typename Impl::in_type, typename Impl::out_type>(std::move(impl));
+}
+
+template <typename A>
+constexpr bool chained() { return true; }
+
+template <typename A, typename B, typename... Rest>
+constexpr bool chained() {
+    return std::is_same_v<typename A::out_type, typename B::in_type> && chained<B, Rest...>();
+}
+
+template <typename First, typename... Rest>
+static inline auto pipeline(const First& first, const Rest&... rest) {
+    static_assert(chained<First, Rest...>(), "typed::pipeline: a stage's output type differs from the next stage's input type");
+    using Last = std::tuple_element_t<sizeof...(Rest), std::tuple<First, Rest...>>;
+    auto p = tvm::ffi::make_object<Pipeline>();
+    p->add_stage(first.node);
+    (p->add_stage(rest.node), ...);
+    return Ref<typename First::in_type, typename Last::out_type>{Node_ref(tvm::ffi::ObjectPtr<Node>(p))};
+}
+
+// Farm of interchangeable workers with FastFlow's default emitter and collector.
+template <typename In, typename Out>
+static inline Ref<In, Out> farm(const std::vector<Ref<In, Out>>& workers) {
+    tvm::ffi::Array<Node_ref> nodes;
+    for (const auto& w : workers) nodes.push_back(w.node);
+    auto f = tvm::ffi::make_object<Farm>();
+    f->add_workers(nodes);
+    f->add_collector(tvm::ffi::Optional<Node_ref>());
+    return {Node_ref(tvm::ffi::ObjectPtr<Node>(f))};
+}
+
+} // namespace typed
 
 
 // === deprecated 
@@ -0,0 +1,94 @@
+import fftvm as ff
+
+'''
+# Test: A2A Routing Strategies
+# Objective: Verify that multi-output nodes pick the output channel natively:
+#            round-robin spreads tasks evenly, key-hash sends equal keys to the
+#            same consumer (across producers), a routing function picks the
+#            channel, broadcast delivers every task to every consumer, that
+#            both returned and ff_send_out tasks are routed, and that invalid
+#            configurations are rejected, with SiMoNode and MiMoNode relays.
+#
+# Graph:
+#  Source(0..N-1) -> Relay[0-1] --\ /-- Consumer[0]
+#                                  X --- Consumer[1]
+#                                 / \-- Consumer[2]
+#  (Relay returns even tasks and ff_send_out's odd ones; Relay is a SiMoNode,
+#   or a MiMoNode for the round-robin and key-hash cases)
+'''
+
+N = 300
+CONSUMERS = 3
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Relay(ff.SiMoNode):
+    def svc(self, t):
+        if t % 2 == 0:
+            return t
+        self.ff_send_out(t)
+        return ff.FFToken.GO_ON()
+
+class MiMoRelay(ff.MiMoNode):
+    def svc(self, t):
+        if t % 2 == 0:
+            return t
+        self.ff_send_out(t)
+        return ff.FFToken.GO_ON()
+
+class Consumer(ff.MiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def run(strategy, fn=None, relay=Relay):
+    relays = [relay() for _ in range(2)]
+    for r in relays:
+        r.set_routing(strategy, fn)
+    consumers = [Consumer() for _ in range(CONSUMERS)]
+    a2a = ff.A2A().add_firstset(relays).add_secondset(consumers)
+    ff.Pipeline().add_stage(Source()).add_stage(a2a).run_and_wait_end()
+    return [c.got for c in consumers], [r.routing_stats() for r in relays]
+
+def run_test():
+    for relay in (Relay, MiMoRelay):
+        got, stats = run("round_robin", relay=relay)
+        assert sorted(sum(got, [])) == list(range(N))
+        for s in stats:
+            sent = list(s["sent"])
+            assert s["strategy"] == "round_robin" and len(sent) == CONSUMERS
+            assert max(sent) - min(sent) <= 1, f"uneven round robin: {sent}"
+
+        got, _ = run("key_hash", lambda t: t % 7, relay=relay)
+        assert sorted(sum(got, [])) == list(range(N))
+        for k in range(7):
+            owners = [c for c in range(CONSUMERS) if any(t % 7 == k for t in got[c])]
+            assert len(owners) == 1, f"key {k} split over consumers {owners}"
+
+    got, _ = run("function", lambda t: t % CONSUMERS)
+    for c in range(CONSUMERS):
+        assert sorted(got[c]) == list(range(c, N, CONSUMERS))
+
+    got, stats = run("broadcast")
+    for c in range(CONSUMERS):
+        assert sorted(got[c]) == list(range(N))
+    assert sum(sum(s["sent"]) for s in stats) == CONSUMERS * N
+
+    for strategy, fn in (("scatter", None), ("function", None)):
+        try:
+            Relay().set_routing(strategy, fn)
+        except Exception as e:
+            assert "routing" in str(e)
+        else:
+            assert False, f"accepted {strategy}"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,66 @@
+import fftvm as ff
+import sys
+
+'''
+# Test: Bound Node Callbacks
+# Objective: Verify that subclass methods are called directly with their own
+#            arity (no per-task wrapper frame): svc with and without the task,
+#            eosnotify with and without the channel id, svc_init/svc_end.
+#
+# Graph:
+#  Source -> Square -> Counter(eosnotify(id)) -> Sink(eosnotify())
+'''
+
+N = 50
+
+def called_by_wrapper():
+    caller = sys._getframe(1).f_back  # whoever called svc
+    return caller is not None and caller.f_code.co_filename == ff.__file__
+
+class Source(ff.SiSoNode):
+    def svc(self):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Square(ff.SiSoNode):
+    def svc_init(self):
+        self.wrapped = False
+        return 0
+    def svc(self, t):
+        self.wrapped |= called_by_wrapper()
+        return t * t
+
+class Counter(ff.SiSoNode):
+    def svc_init(self):
+        self.n = 0
+        return 0
+    def svc(self, t):
+        self.n += 1
+        return t
+    def eosnotify(self, id):
+        self.eos_id = id
+    def svc_end(self):
+        self.ended = True
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.total = 0
+        return 0
+    def svc(self, t):
+        self.total += t
+        return ff.FFToken.GO_ON()
+    def eosnotify(self):
+        self.eos = True
+
+def run_test():
+    square, counter, sink = Square(), Counter(), Sink()
+    ff.Pipeline().add_stage(Source()).add_stage(square).add_stage(counter).add_stage(sink).run_and_wait_end()
+    assert not square.wrapped, "svc called through a wrapper frame"
+    assert counter.n == N and counter.eos_id == 0 and counter.ended
+    assert sink.eos
+    assert sink.total == sum(i * i for i in range(N))
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
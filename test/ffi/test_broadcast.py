@@ -0,0 +1,67 @@
+import fftvm as ff
+import numpy as np
+import tvm_ffi
+
+'''
+# Test: Zero-Copy Broadcast
+# Objective: Verify that broadcast() delivers every task to every output
+#            channel as one shared task (charged once to a byte budget and
+#            released only after the last consumer is done), that a consumer
+#            updating tasks in place (lane classifier) works on its own copy,
+#            and that the "broadcast" routing strategy shares tasks the same way.
+#
+# Graph:
+#  Frames(broadcast) --+-- Head[0]
+#                      +-- Head[1]
+#                      +-- Head[2] (lanes with classifier)
+'''
+
+N = 200
+HEADS = 3
+CHUNK = 4096
+
+class Frames(ff.SiMoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.broadcast(tvm_ffi.from_dlpack(np.full(CHUNK, i % 256, dtype=np.uint8)))
+        return ff.FFToken.EOS()
+
+class Relay(ff.SiMoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(tvm_ffi.from_dlpack(np.full(CHUNK, i % 256, dtype=np.uint8)))
+        return ff.FFToken.EOS()
+
+class Head(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(int(np.from_dlpack(t)[0]))
+        return ff.FFToken.GO_ON()
+
+def run(source):
+    budget = ff.ByteBudget()
+    source.set_byte_budget(budget)
+    heads = [Head() for _ in range(HEADS)]
+    heads[-1].set_lanes(classifier=lambda t: 1)
+    ff.A2A().add_firstset([source]).add_secondset(heads).run_and_wait_end()
+    for h in heads:
+        assert sorted(h.got) == sorted(i % 256 for i in range(N))
+    return budget.stats()
+
+def run_test():
+    stats = run(Frames())
+    edge = stats["edges"][0]
+    assert edge["tasks"] == N, f"broadcast allocated per channel: {stats}"
+    assert stats["in_flight"] == 0 and edge["in_flight"] == 0, f"shared task leaked: {stats}"
+
+    source = Relay()
+    source.set_routing("broadcast")
+    stats = run(source)
+    assert stats["edges"][0]["tasks"] == N and stats["in_flight"] == 0, stats
+    assert list(source.routing_stats()["sent"]) == [N] * HEADS
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,94 @@
+import fftvm as ff
+import threading
+import time
+
+'''
+# Test: Deadlines & Shedding
+# Objective: Verify that expired tasks are dropped or diverted before svc,
+#            that tasks with a live deadline are processed normally, and that
+#            an EdfEmitter with on-demand scheduling dispatches the backlog
+#            earliest deadline first, and that MiMo nodes apply expiry too.
+#
+# Graph:
+#  Source -> Worker(expiry) -> Sink
+#    even i: 1us deadline (expired on arrival), odd i: 10s deadline
+#
+#  Source -> Farm[ EdfEmitter -> Worker(sleep) ] -> Sink
+#    task i: deadline shrinking with i (later tasks are more urgent); the
+#    worker holds its first task until the source has queued every task
+#
+#  Source -> MiMoWorker(expiry) -> Sink
+'''
+
+N = 40
+
+class Source(ff.SiSoNode):
+    def __init__(self, deadline_of, queued=None):
+        super().__init__()
+        self.deadline_of = deadline_of
+        self.queued = queued
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out_deadline(i, self.deadline_of(i))
+        if self.queued:
+            self.queued.set()
+        return ff.FFToken.EOS()
+
+class SlowWorker(ff.SiSoNode):
+    def __init__(self, gate=None):
+        super().__init__()
+        self.gate = gate
+    def svc(self, t):
+        if self.gate:
+            self.gate.wait()
+        time.sleep(0.001)
+        return t
+
+class MiMoWorker(ff.MiMoNode):
+    def svc(self, t):
+        return t
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.order = []
+        return 0
+    def svc(self, t):
+        self.order.append(t)
+        return ff.FFToken.GO_ON()
+
+def mixed_deadline(i):
+    return 1 if i % 2 == 0 else 10_000_000
+
+def run_expiry(mode, divert=None):
+    worker, sink = SlowWorker(), Sink()
+    worker.set_expiry(mode, divert)
+    ff.Pipeline().add_stage(Source(mixed_deadline)).add_stage(worker).add_stage(sink).run_and_wait_end()
+    return sink.order, worker.expiry_stats()
+
+def run_test():
+    order, stats = run_expiry("drop")
+    assert order == list(range(1, N, 2)), f"live tasks lost or expired ones kept: {order}"
+    assert stats["dropped"] == N // 2 and stats["diverted"] == 0
+
+    order, stats = run_expiry("divert", lambda t: -t)
+    assert sorted(order) == sorted([-i for i in range(0, N, 2)] + list(range(1, N, 2)))
+    assert stats["diverted"] == N // 2 and stats["dropped"] == 0
+
+    queued = threading.Event()
+    emitter, sink = ff.EdfEmitter(window=N), Sink()
+    farm = ff.Farm().add_emitter(emitter).add_workers([SlowWorker(queued)]).add_collector(None).set_scheduling_ondemand(1)
+    source = Source(lambda i: 10_000_000 - i * 1000, queued)
+    ff.Pipeline().add_stage(source).add_stage(farm).add_stage(sink).run_and_wait_end()
+    assert sorted(sink.order) == list(range(N)), "lost or duplicated tasks"
+    tail = sink.order[-20:]
+    assert tail == sorted(tail, reverse=True), f"backlog not served earliest deadline first: {sink.order}"
+    assert emitter.stats()["dispatched"] == N and emitter.stats()["dropped"] == 0
+
+    worker, sink = MiMoWorker(), Sink()
+    worker.set_expiry("drop")
+    ff.Pipeline().add_stage(Source(mixed_deadline)).add_stage(worker).add_stage(sink).run_and_wait_end()
+    assert sink.order == list(range(1, N, 2)) and worker.expiry_stats()["dropped"] == N // 2
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,83 @@
+import fftvm as ff
+import tvm_ffi
+import numpy as np
+import multiprocessing as mp
+import socket
+
+'''
+# Test: Distributed Groups over TCP
+# Objective: Verify that a graph split into process groups delivers every
+#            task exactly once across TCP edges (fan-out and fan-in), for
+#            scalars, strings and Tensors, and that a receiver fails when a
+#            sender closes its connection without end of stream.
+#
+# Graph (one process per group):
+#              +--> [work0] --+
+#  [source] ---|              |---> [sink]
+#              +--> [work1] --+
+#
+#  raw socket (connect, close) --> TcpReceiver -> Sink   (in a child process)
+'''
+
+N = 200
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        self.ff_send_out("done")
+        self.ff_send_out(tvm_ffi.from_dlpack(np.arange(1000, dtype=np.int32)))
+        return ff.FFToken.EOS()
+
+class Work(ff.SiSoNode):
+    def svc(self, t):
+        return t * 2 if isinstance(t, int) else t
+
+class Sink(ff.SiSoNode):
+    def __init__(self, queue):
+        super().__init__()
+        self.queue = queue
+    def svc_init(self):
+        self.ints, self.others = [], []
+        return 0
+    def svc(self, t):
+        if isinstance(t, int):
+            self.ints.append(t)
+        elif isinstance(t, tvm_ffi.Tensor):
+            self.others.append(int(np.from_dlpack(t).sum()))
+        else:
+            self.others.append(t)
+        return ff.FFToken.GO_ON()
+    def svc_end(self):
+        self.queue.put((sorted(self.ints), sorted(map(str, self.others))))
+
+def run_test():
+    queue = mp.get_context("fork").Queue()
+    g = ff.distributed.Graph(batch_size=16)
+    g.add_group("source", lambda: Source())
+    g.add_group("work0", lambda: Work())
+    g.add_group("work1", lambda: Work())
+    g.add_group("sink", lambda: Sink(queue))
+    for w in ("work0", "work1"):
+        g.connect("source", w).connect(w, "sink")
+    g.run()
+
+    ints, others = queue.get(timeout=1)
+    assert ints == [2 * i for i in range(N)], "lost or duplicated tasks"
+    assert others == sorted(["done", str(sum(range(1000)))])
+
+    # a bare close is a failed sender, not EOS: the receiving process dies
+    receiver = ff.TcpReceiver(timeout_ms=5000)
+    port = receiver.port()
+    ctx = mp.get_context("fork")
+    child = ctx.Process(target=lambda: ff.Pipeline().add_stage(receiver).add_stage(Sink(ctx.Queue())).run_and_wait_end())
+    child.start()
+    socket.create_connection(("127.0.0.1", port)).close()
+    child.join(timeout=10)
+    if child.is_alive():
+        child.kill()
+    assert child.exitcode not in (None, 0), f"receiver ended normally: {child.exitcode}"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,88 @@
+import fftvm as ff
+import time
+import tvm_ffi
+
+'''
+# Test: Elastic Farm
+# Objective: Verify that ElasticFarm delivers every task exactly once, thaws
+#            workers when the backlog grows (never beyond max_workers) and
+#            reports scaling events, and that a farm left idle after a burst
+#            scales back down while no task arrives (also without blocking mode).
+#
+# Graph:
+#  Source -> ElasticFarm[ Dispatcher -> Worker[0..3] (1 active at start) -> Counter ] -> Sink
+#  Source(burst, then idle) -> ElasticFarm[ ... max_workers=3 ... ] -> Sink
+'''
+
+cpp_source = '''
+#include <tvm/ffi/any.h>
+tvm::ffi::Any slow_double(tvm::ffi::Any input) {
+    volatile int64_t i = 0;
+    while (i < 200000) i = i + 1;
+    return input.cast<int64_t>() * 2;
+}
+'''
+
+N = 200
+
+class Source(ff.SiSoNode):
+    def __init__(self, idle_s=0):
+        super().__init__()
+        self.idle_s = idle_s
+    def svc(self, task):
+        for i in range(N):
+            self.ff_send_out(i)
+        time.sleep(self.idle_s)
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.sum = 0
+        self.count = 0
+        return 0
+    def svc(self, task):
+        self.sum += task
+        self.count += 1
+        return ff.FFToken.GO_ON()
+
+def run_test(native_mod):
+    sink = Sink()
+    farm = ff.ElasticFarm(min_workers=1, scale_up_backlog=2.0, scale_down_backlog=0.5,
+                          hysteresis=1, interval_ms=0)
+    farm.add_workers([ff.SiSoNode(native_mod.slow_double) for _ in range(4)])
+
+    wf = ff.Pipeline().add_stage(Source()).add_stage(farm).add_stage(sink)
+    wf.run_and_wait_end()
+
+    assert sink.count == N, f"Task count mismatch: {sink.count} != {N}"
+    assert sink.sum == 2 * sum(range(N)), f"Sum mismatch: {sink.sum}"
+
+    stats = farm.stats()
+    assert stats["workers"] == 4
+    assert 1 <= stats["active_workers"] <= 4
+    assert sum(stats["dispatched"]) == N
+    assert sum(stats["completed"]) == N
+    assert stats["scale_up_events"] >= 1, "farm never scaled up under backlog"
+    assert len(stats["events"]) == stats["scale_up_events"] + stats["scale_down_events"]
+
+    # idle after the burst: the timer keeps sampling and scales down to min_workers
+    sink = Sink()
+    farm = ff.ElasticFarm(min_workers=1, scale_up_backlog=2.0, scale_down_backlog=0.5,
+                          hysteresis=1, interval_ms=5, max_workers=3, blocking=False)
+    farm.add_workers([ff.SiSoNode(native_mod.slow_double) for _ in range(4)])
+    ff.Pipeline().add_stage(Source(idle_s=0.5)).add_stage(farm).add_stage(sink).run_and_wait_end()
+
+    assert sink.count == N
+    stats = farm.stats()
+    assert stats["max_workers"] == 3
+    assert stats["dispatched"][3] == 0, "a worker beyond max_workers was fed"
+    assert all(to <= 3 for _, _, to in stats["events"])
+    assert stats["scale_up_events"] >= 1, "farm never scaled up under backlog"
+    assert stats["active_workers"] == 1, f"idle farm did not scale down: {stats['events']}"
+    assert stats["scale_down_events"] == stats["scale_up_events"]
+
+if __name__ == "__main__":
+    native_mod = tvm_ffi.cpp.load_inline(
+        name="elastic_farm", cpp_sources=cpp_source, functions=['slow_double'])
+    run_test(native_mod)
+    run_test(native_mod)
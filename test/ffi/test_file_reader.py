@@ -0,0 +1,72 @@
+import fftvm as ff
+import numpy as np
+import os
+import tempfile
+import time
+
+'''
+# Test: Streaming File Reader
+# Objective: Verify that FileReader streams files in order, in fixed-size
+#            chunks, both as pooled Tensors and as bytes, and that with no
+#            stall timeout it waits for a sink that holds every buffer.
+#
+# Graph:
+#  FileReader(directory) -> Sink
+#  FileReader(directory, stall_timeout_ms=None) -> HoldingSink
+'''
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.chunks = []
+        return 0
+    def svc(self, t):
+        if isinstance(t, bytes):
+            self.chunks.append(t)
+        else:
+            self.chunks.append(np.from_dlpack(t).tobytes())
+        return ff.FFToken.GO_ON()
+
+class HoldingSink(ff.SiSoNode):
+    """Keeps every pooled chunk it gets, and lets them go only after a pause."""
+    def __init__(self, pool_size):
+        super().__init__()
+        self.pool_size = pool_size
+    def svc_init(self):
+        self.held, self.chunks = [], []
+        return 0
+    def svc(self, t):
+        self.held.append(t)
+        self.chunks.append(np.from_dlpack(t).tobytes())
+        if len(self.held) == self.pool_size:
+            time.sleep(0.2)
+            self.held.clear()
+        return ff.FFToken.GO_ON()
+
+def run_test():
+    rng = np.random.default_rng(0)
+    blobs = [rng.bytes(10000), rng.bytes(4096), b"", rng.bytes(123)]
+    with tempfile.TemporaryDirectory() as d:
+        for i, b in enumerate(blobs):
+            with open(os.path.join(d, f"{i}.bin"), "wb") as f:
+                f.write(b)
+
+        for output in ("tensor", "bytes"):
+            sink = Sink()
+            reader = ff.FileReader(d, chunk_size=1024, min_inflight=1, max_inflight=4, output=output)
+            ff.Pipeline().add_stage(reader).add_stage(sink).run_and_wait_end()
+
+            assert b"".join(sink.chunks) == b"".join(blobs), "streamed content mismatch"
+            assert all(len(c) <= 1024 for c in sink.chunks)
+            stats = reader.stats()
+            assert stats["files"] == len(blobs)
+            assert stats["bytes"] == sum(len(b) for b in blobs)
+            assert 1 <= stats["depth"] <= 4
+
+        sink = HoldingSink(pool_size=2 * 2)
+        reader = ff.FileReader(d, chunk_size=1024, min_inflight=1, max_inflight=2, stall_timeout_ms=None)
+        ff.Pipeline().add_stage(reader).add_stage(sink).run_and_wait_end()
+        assert b"".join(sink.chunks) == b"".join(blobs), "streamed content mismatch"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,78 @@
+import fftvm as ff
+import threading
+
+'''
+# Test: Multi-Producer Injection
+# Objective: Verify that many Python threads can submit tasks concurrently to
+#            an Injector feeding one running graph, that every thread gets back
+#            the result of its own tasks through its tickets (in a pipeline and
+#            through a farm), that the graph ends once the injector is closed,
+#            that tickets of dropped tasks fail, and that submitting after
+#            close() is rejected.
+#
+# Graph:
+#  threads x8 --submit--> Injector -> Square -> Injector.results()
+#  threads x8 --submit--> Farm[ Injector -> Square x4 -> Injector.results() ]
+'''
+
+THREADS = 8
+PER_THREAD = 100
+
+class Square(ff.SiSoNode):
+    def svc(self, t):
+        if t < 0:
+            return ff.FFToken.GO_ON()  # dropped
+        return t * t
+
+def feed(inj):
+    errors = []
+    def producer(k):
+        tickets = [(i, inj.submit(k * PER_THREAD + i)) for i in range(PER_THREAD)]
+        for i, ticket in tickets:
+            if ticket.result(timeout=10) != (k * PER_THREAD + i) ** 2:
+                errors.append((k, i))
+    threads = [threading.Thread(target=producer, args=(k,)) for k in range(THREADS)]
+    for th in threads:
+        th.start()
+    for th in threads:
+        th.join()
+    assert errors == []
+
+def run_test():
+    inj = ff.Injector()
+    pipe = ff.Pipeline().add_stage(inj).add_stage(Square()).add_stage(inj.results())
+    pipe.run()
+    feed(inj)
+    dropped = inj.submit(-1)
+    inj.submit(3, want_result=False)
+    inj.close()
+    pipe.wait()
+    try:
+        dropped.result(timeout=1)
+    except Exception as e:
+        assert "without a result" in str(e)
+    else:
+        assert False, "a dropped task got a result"
+    stats = inj.stats()
+    assert stats["submitted"] == THREADS * PER_THREAD + 2 and stats["injected"] == stats["submitted"]
+    assert stats["completed"] == THREADS * PER_THREAD and stats["unmatched"] == 1 and stats["failed"] == 1
+
+    try:
+        inj.submit(1)
+    except Exception as e:
+        assert "after close" in str(e)
+    else:
+        assert False, "accepted a task after close()"
+
+    inj = ff.Injector()
+    farm = ff.Farm().add_emitter(inj).add_workers([Square() for _ in range(4)]).add_collector(inj.results())
+    pipe = ff.Pipeline().add_stage(farm)
+    pipe.run()
+    feed(inj)
+    inj.close()
+    pipe.wait()
+    assert inj.stats()["completed"] == THREADS * PER_THREAD
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
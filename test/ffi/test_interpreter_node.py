@@ -0,0 +1,89 @@
+import fftvm as ff
+import numpy as np
+import tvm_ffi
+
+'''
+# Test: InterpreterNode (per-interpreter GIL)
+# Objective: Verify that Python code running in InterpreterNodes (own
+#            subinterpreter, free-threaded or shared GIL, whatever the build
+#            supports) processes every task of a farm, that it can act as a
+#            source with ff_send_out/EOS, and that tensors are lent as
+#            memoryviews: modified in place and forwarded without a copy,
+#            and still readable when the code keeps a view past the call.
+#
+# Graph:
+#  InterpSource -> Farm[ InterpWorker(square) x4 ] -> Sink
+#
+#  Source(tensors) -> Farm[ InterpWorker(double in place) x2 ] -> Sink
+#  Source(tensors) -> InterpWorker(keeps views) -> Sink
+'''
+
+N = 200
+MODES = {"subinterpreter", "free-threaded", "shared-gil"}
+
+SOURCE = f'''
+def svc(t):
+    for i in range({N}):
+        ff_send_out(i)
+    return EOS
+'''
+
+KEEP = '''
+kept = []
+def svc(t):
+    kept.append(memoryview(t))  # an export: the lent view cannot be released
+    return float(sum(v[0] for v in kept))
+'''
+
+def square(t):
+    return t * t
+
+def double_in_place(t):
+    for i in range(len(t)):
+        t[i] *= 2
+    return t
+
+class TensorSource(ff.SiSoNode):
+    def __init__(self, arrays):
+        super().__init__()
+        self.arrays = arrays
+    def svc(self, t):
+        for a in self.arrays:
+            self.ff_send_out(tvm_ffi.from_dlpack(a))
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def run_test():
+    source, sink = ff.InterpreterNode(SOURCE), Sink()
+    workers = [ff.InterpreterNode(square) for _ in range(4)]
+    farm = ff.Farm().add_workers(workers).add_collector(None)
+    ff.Pipeline().add_stage(source).add_stage(farm).add_stage(sink).run_and_wait_end()
+    assert sorted(sink.got) == [i * i for i in range(N)]
+    assert sum(w.stats()["tasks"] for w in workers) == N
+    assert all(w.stats()["mode"] in MODES for w in workers + [source])
+
+    arrays = [np.arange(16, dtype=np.float32) + k for k in range(8)]
+    expected = {a.ctypes.data: 2 * a for a in arrays}
+    sink = Sink()
+    farm = ff.Farm().add_workers([ff.InterpreterNode(double_in_place) for _ in range(2)]).add_collector(None)
+    ff.Pipeline().add_stage(TensorSource(arrays)).add_stage(farm).add_stage(sink).run_and_wait_end()
+    assert len(sink.got) == len(arrays)
+    for t in sink.got:
+        out = np.from_dlpack(t)
+        assert out.ctypes.data in expected, "tensor was copied"
+        assert np.array_equal(out, expected[out.ctypes.data])
+
+    sink = Sink()
+    ff.Pipeline().add_stage(TensorSource(arrays)).add_stage(ff.InterpreterNode(KEEP)).add_stage(sink).run_and_wait_end()
+    assert sink.got == [float(sum(2 * j for j in range(k + 1))) for k in range(len(arrays))]
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
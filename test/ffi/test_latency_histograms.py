@@ -0,0 +1,71 @@
+import fftvm as ff
+import time
+
+'''
+# Test: End-to-End Latency Histograms
+# Objective: Verify that tasks stamped at the source keep their ingress time
+#            through farm and A2A hops (also when a worker derives a new task
+#            from them), that recording sinks count every stamped task with
+#            a plausible latency, and that unstamped tasks are not recorded.
+#
+# Graph:
+#  Source(stamp) -> Farm[ Worker(sleep 1ms, t+1) x2 ] -> Sink(record)
+#
+#  Source(stamp)[0..1] --X-- Sink(record)[0..1]
+'''
+
+N = 100
+SLEEP_US = 1000
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Worker(ff.SiSoNode):
+    def svc(self, t):
+        time.sleep(SLEEP_US / 1e6)
+        return t + 1
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.n = 0
+        return 0
+    def svc(self, t):
+        self.n += 1
+        return ff.FFToken.GO_ON()
+
+def run_farm(stamp):
+    source, sink = Source(), Sink()
+    source.set_latency(stamp=stamp)
+    sink.set_latency(record=True)
+    farm = ff.Farm().add_workers([Worker() for _ in range(2)]).add_collector(None)
+    ff.Pipeline().add_stage(source).add_stage(farm).add_stage(sink).run_and_wait_end()
+    assert sink.n == N
+    return sink.latency_stats()
+
+def run_test():
+    stats = run_farm(stamp=True)
+    assert stats["count"] == N, f"stamp lost on the way: {stats}"
+    assert stats["p50_us"] >= SLEEP_US, f"latency below the worker's sleep: {stats}"
+    assert stats["p50_us"] <= stats["p99_us"] <= stats["p999_us"] <= stats["max_us"]
+
+    stats = run_farm(stamp=False)
+    assert stats["count"] == 0, f"unstamped tasks recorded: {stats}"
+
+    sources, sinks = [Source() for _ in range(2)], [Sink() for _ in range(2)]
+    for s in sources:
+        s.set_latency(stamp=True)
+    for s in sinks:
+        s.set_latency(record=True)
+    ff.A2A().add_firstset(sources).add_secondset(sinks).run_and_wait_end()
+    counts = [s.latency_stats()["count"] for s in sinks]
+    assert sum(counts) == 2 * N and counts == [s.n for s in sinks], f"A2A hop lost stamps: {counts}"
+
+    sinks[0].reset_latency()
+    assert sinks[0].latency_stats()["count"] == 0
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
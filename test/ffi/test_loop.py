@@ -0,0 +1,87 @@
+import fftvm as ff
+import multiprocessing as mp
+
+'''
+# Test: Native Loop (Pipeline wrap_around)
+# Objective: Verify that tasks go around the loop body until the convergence
+#            predicate holds or the iteration limit is reached, that the trip
+#            count is kept per task (also through a farm in the body), that
+#            every task leaves the loop exactly once and that EOS is sent
+#            automatically once the loop has drained, that stages after the
+#            loop may filter tasks, and that a body filtering a task fails
+#            the graph instead of hanging it.
+#
+# Graph:
+#  Source -> Loop[ Double -> Farm[ AddOne x2 ] ]<-feedback -> Sink
+#             exits when v >= LIMIT or after MAX_ITER trips
+#  Source -> Loop[ Double ] -> Filter(odd) -> Sink
+#  Source -> Loop[ Filter(odd) ] -> Sink   (in a child process)
+'''
+
+N = 200
+LIMIT = 1000
+MAX_ITER = 6
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def expected(v):
+    for _ in range(MAX_ITER):
+        v = 2 * v + 1
+        if v >= LIMIT:
+            break
+    return v
+
+def drop_odd(t):
+    return ff.FFToken.GO_ON() if t % 2 else t
+
+def filtering_body():
+    loop = ff.Loop(ff.SiSoNode(drop_odd), max_iterations=2)
+    ff.Pipeline().add_stage(Source()).add_stage(loop).add_stage(Sink()).run_and_wait_end()
+
+def run_test():
+    sink = Sink()
+    farm = ff.Farm().add_workers([ff.SiSoNode(lambda t: t + 1) for _ in range(2)]).add_collector(None)
+    loop = ff.Loop([ff.SiSoNode(lambda t: 2 * t), farm], max_iterations=MAX_ITER, converged=lambda t: t >= LIMIT)
+    ff.Pipeline().add_stage(Source()).add_stage(loop).add_stage(sink).run_and_wait_end()
+
+    assert sorted(sink.got) == sorted(expected(i) for i in range(N))
+    stats = loop.stats()
+    assert stats["entered"] == N and stats["in_flight"] == 0
+    assert stats["converged"] + stats["exhausted"] == N
+    assert stats["exhausted"] == sum(1 for i in range(N) if expected(i) < LIMIT)
+
+    # tasks leaving the loop are no longer inside its body
+    sink = Sink()
+    loop = ff.Loop(ff.SiSoNode(lambda t: 2 * t), max_iterations=1)
+    ff.Pipeline().add_stage(Source()).add_stage(loop).add_stage(ff.SiSoNode(lambda t: ff.FFToken.GO_ON() if t % 4 else t)).add_stage(sink).run_and_wait_end()
+    assert sorted(sink.got) == [2 * i for i in range(N) if i % 2 == 0]
+
+    child = mp.get_context("fork").Process(target=filtering_body)
+    child.start()
+    child.join(timeout=10)
+    if child.is_alive():
+        child.kill()
+    assert child.exitcode not in (None, 0), f"a filtering body did not fail: {child.exitcode}"
+
+    try:
+        ff.Loop(ff.SiSoNode(lambda t: t))
+    except Exception as e:
+        assert "never ends" in str(e)
+    else:
+        assert False, "a loop without exit condition was accepted"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
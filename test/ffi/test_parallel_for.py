@@ -0,0 +1,73 @@
+import fftvm as ff
+import numpy as np
+
+'''
+# Test: Intra-task ParallelFor
+# Objective: Verify that a ParallelFor covers every index of a range exactly
+#            once in chunks, that reductions fold the partial results of all
+#            chunks, that it works from inside a node's svc while the graph
+#            runs, and that an exception raised by a chunk reaches the caller.
+#
+# Graph:
+#  Source(0..N-1) -> Fill(ParallelFor x4 over M rows) -> Sink
+'''
+
+N = 20
+M = 4096
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Fill(ff.SiSoNode):
+    def svc_init(self):
+        self.pool = ff.ParallelFor(num_workers=4)
+        return 0
+    def svc(self, t):
+        out = np.zeros(M, dtype=np.int64)
+        def body(lo, hi, tid):
+            out[lo:hi] = np.arange(lo, hi) * t
+        self.pool.parallel_for(0, M, body, chunk=256)
+        return int(out.sum())
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def run_test():
+    pool = ff.ParallelFor(num_workers=4)
+    hits = np.zeros(1000, dtype=np.int64)
+    def mark(lo, hi, tid):
+        assert 0 <= tid < 4
+        hits[lo:hi] += 1
+    pool.parallel_for(0, 1000, mark, chunk=37)
+    assert (hits == 1).all()
+
+    total = pool.parallel_reduce(0, 1000, lambda lo, hi, tid: sum(range(lo, hi)), lambda a, b: a + b)
+    assert total == sum(range(1000))
+    stats = pool.stats()
+    assert stats["workers"] == 4 and stats["loops"] == 2 and stats["chunks"] >= 2 * (1000 // 37)
+
+    fill, sink = Fill(), Sink()
+    ff.Pipeline().add_stage(Source()).add_stage(fill).add_stage(sink).run_and_wait_end()
+    assert sink.got == [i * sum(range(M)) for i in range(N)]
+
+    def fail(lo, hi, tid):
+        if lo == 0:
+            raise ValueError("chunk failed")
+    try:
+        pool.parallel_for(0, 100, fail, chunk=10)
+    except Exception as e:
+        assert "chunk failed" in str(e)
+    else:
+        assert False, "exception was lost"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,70 @@
+import fftvm as ff
+
+'''
+# Test: Hardware Performance Counters
+# Objective: Verify that a node with perf counters in "svc" mode samples every
+#            svc call and reports cycles, instructions and derived rates, that
+#            "thread" mode takes one sample per run, that nodes run unchanged
+#            when the kernel refuses the counters (the error is reported), and
+#            that an unknown mode is rejected.
+#
+# Graph:
+#  Source(0..N-1) -> Work(spin loop) -> Sink
+'''
+
+N = 200
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Work(ff.SiSoNode):
+    def svc(self, t):
+        s = 0
+        for i in range(200):
+            s += i * t
+        return s
+
+class Sink(ff.MiSoNode):
+    def svc_init(self):
+        self.n = 0
+        return 0
+    def svc(self, t):
+        self.n += 1
+        return ff.FFToken.GO_ON()
+
+def run(mode):
+    work, sink = Work(), Sink()
+    work.set_perf_counters(mode)
+    sink.set_perf_counters(mode)
+    ff.Pipeline().add_stage(Source()).add_stage(work).add_stage(sink).run_and_wait_end()
+    assert sink.n == N
+    return work.perf_stats(), sink.perf_stats()
+
+def run_test():
+    work, sink = run("svc")
+    assert work["mode"] == "svc" and work["samples"] == N and sink["samples"] == N
+    if work["error"] == "":
+        assert work["cycles"] > 0 and work["instructions"] > 0 and work["ipc"] > 0
+        assert 0 <= work["branch_miss_rate"] <= 1 and work["llc_mpki"] >= 0
+
+    work, _ = run("thread")
+    assert work["samples"] == 1
+    if work["error"] == "":
+        assert work["instructions"] > 0
+
+    work, _ = run("off")
+    assert work["samples"] == 0 and work["cycles"] == 0
+
+    try:
+        Work().set_perf_counters("cycles")
+    except Exception as e:
+        assert "perf counters" in str(e)
+    else:
+        assert False, "accepted an unknown mode"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,125 @@
+import fftvm as ff
+import glob
+import os
+import tempfile
+import tvm_ffi
+
+'''
+# Test: Plugin Node (C ABI)
+# Objective: Verify that a stage compiled separately against fftvm_plugin.h is
+#            loaded into a graph, gets its config, modifies tasks in place,
+#            emits extra tasks through the host and drops others, that a plugin
+#            can be a source, and that ABI misuse is reported.
+#
+# Graph:
+#  Source(0..N-1, "skip") -> Plugin(scale by config, odd results also emit -1) -> Sink
+#  Plugin(count to config) -> Sink
+'''
+
+N = 300
+
+plugin_source = '''
+#include <fftvm_plugin.h>
+#include <tvm/ffi/any.h>
+#include <string>
+
+struct Scale { int64_t factor; };
+
+static void* scale_create(const char* config, size_t len) {
+    return new Scale{std::stoll(std::string(config, len))};
+}
+
+static TVMFFIAny* scale_svc(void* state, TVMFFIAny* t, const FFTVMPluginHost* host) {
+    if (t->type_index != kTVMFFIInt) {
+        host->free(host->node, t);
+        return FFTVM_PLUGIN_GO_ON;
+    }
+    t->v_int64 *= static_cast<Scale*>(state)->factor;
+    if (t->v_int64 % 2 != 0) {
+        TVMFFIAny* extra = host->alloc(host->node);
+        extra->type_index = kTVMFFIInt;
+        extra->v_int64 = -1;
+        host->send_out(host->node, extra);
+    }
+    return t;
+}
+
+static void scale_destroy(void* state) { delete static_cast<Scale*>(state); }
+
+static const FFTVMPluginNode scale = {FFTVM_PLUGIN_ABI_VERSION, scale_create, nullptr, scale_svc, nullptr, scale_destroy};
+
+struct Counter { int64_t n, i; };
+
+static void* counter_create(const char* config, size_t len) {
+    return new Counter{std::stoll(std::string(config, len)), 0};
+}
+
+static int counter_init(void* state, const FFTVMPluginHost*) {
+    static_cast<Counter*>(state)->i = 0;
+    return 0;
+}
+
+static TVMFFIAny* counter_svc(void* state, TVMFFIAny*, const FFTVMPluginHost* host) {
+    auto* c = static_cast<Counter*>(state);
+    if (c->i == c->n) return FFTVM_PLUGIN_EOS;
+    TVMFFIAny* t = host->alloc(host->node);
+    t->type_index = kTVMFFIInt;
+    t->v_int64 = c->i++;
+    return t;
+}
+
+static void counter_destroy(void* state) { delete static_cast<Counter*>(state); }
+
+static const FFTVMPluginNode counter = {FFTVM_PLUGIN_ABI_VERSION, counter_create, counter_init, counter_svc, nullptr, counter_destroy};
+
+extern "C" const FFTVMPluginNode* scale_plugin(void) { return &scale; }
+extern "C" const FFTVMPluginNode* counter_plugin(void) { return &counter; }
+extern "C" const FFTVMPluginNode* broken_plugin(void) { return nullptr; }
+
+int64_t plugin_version() { return FFTVM_PLUGIN_ABI_VERSION; }
+'''
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+            if i == N // 2:
+                self.ff_send_out("skip")
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def run_test(path):
+    sink = Sink()
+    plugin = ff.PluginNode.load(path, "scale_plugin", 3)
+    ff.Pipeline().add_stage(Source()).add_stage(plugin).add_stage(sink).run_and_wait_end()
+    scaled = [3 * i for i in range(N)]
+    assert [t for t in sink.got if t >= 0] == scaled
+    assert sink.got.count(-1) == sum(1 for v in scaled if v % 2)
+
+    sink = Sink()
+    ff.Pipeline().add_stage(ff.PluginNode.load(path, "counter_plugin", "50")).add_stage(sink).run_and_wait_end()
+    assert sink.got == list(range(50))
+
+    for symbol in ("broken_plugin", "missing_plugin"):
+        try:
+            ff.PluginNode.load(path, symbol)
+        except Exception as e:
+            assert "PluginNode" in str(e)
+        else:
+            assert False, f"loaded {symbol}"
+
+if __name__ == "__main__":
+    with tempfile.TemporaryDirectory() as build_dir:
+        tvm_ffi.cpp.load_inline(
+            name="plugin_node", cpp_sources=plugin_source, functions=["plugin_version"],
+            extra_include_paths=[os.path.dirname(ff.__file__)], build_directory=build_dir)
+        path = glob.glob(os.path.join(build_dir, "*.so"))[0]
+        run_test(path)
+        run_test(path)
@@ -0,0 +1,115 @@
+import fftvm as ff
+import time
+
+'''
+# Test: Priority Lanes
+# Objective: Verify that a node with lanes serves high-priority tasks ahead
+#            of a bulk backlog queued before them, with priorities set at
+#            ff_send_out time or by a classifier, that starvation
+#            protection keeps serving the bulk lane, that lanes keep working
+#            in blocking mode, and that multi-input nodes (MiSo, MiMo, farm
+#            collector) take lanes too.
+#
+# Graph:
+#  Source -> Worker(lanes=2) -> Sink
+#    bulk: 0..NB-1 (priority 0), then interactive: 1000.. (priority 1)
+#    also with the pipeline in blocking mode, and with a MiSo/MiMo worker
+#
+#  Source -> Farm[ Forward x2 -> Collector(lanes=2) ] -> Sink
+'''
+
+NB, NI = 100, 10
+
+class Source(ff.SiSoNode):
+    def __init__(self, use_prio):
+        super().__init__()
+        self.use_prio = use_prio
+    def svc(self, t):
+        for i in range(NB):
+            self.ff_send_out(i)
+        for i in range(NI):
+            if self.use_prio:
+                self.ff_send_out_prio(1000 + i, 1)
+            else:
+                self.ff_send_out(1000 + i)
+        return ff.FFToken.EOS()
+
+class Worker(ff.SiSoNode):
+    def svc(self, t):
+        time.sleep(0.001)
+        return t
+
+class MiSoWorker(ff.MiSoNode):
+    def svc(self, t):
+        time.sleep(0.001)
+        return t
+
+class MiMoWorker(ff.MiMoNode):
+    def svc(self, t):
+        time.sleep(0.001)
+        return t
+
+class Forward(ff.SiSoNode):
+    def svc(self, t):
+        return t
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.order = []
+        return 0
+    def svc(self, t):
+        self.order.append(t)
+        return ff.FFToken.GO_ON()
+
+def check_order(order, stats, fifo=True):
+    assert sorted(order) == list(range(NB)) + [1000 + i for i in range(NI)], "lost or duplicated tasks"
+    positions = [k for k, t in enumerate(order) if t >= 1000]
+    assert max(positions) < NI + 10, f"interactive tasks waited behind bulk: {positions}"
+    bulk = [t for t in order if t < 1000]
+    assert not fifo or bulk == sorted(bulk), "FIFO order violated within a lane"
+    assert stats[0]["count"] == NB and stats[1]["count"] == NI
+
+def run_pipe(use_prio, worker_cls=Worker, blocking=False, **lanes):
+    worker, sink = worker_cls(), Sink()
+    worker.set_lanes(**lanes)
+    pipe = ff.Pipeline().add_stage(Source(use_prio)).add_stage(worker).add_stage(sink)
+    if blocking:
+        pipe.blocking_mode(True)
+    pipe.run_and_wait_end()
+    assert sorted(sink.order) == list(range(NB)) + [1000 + i for i in range(NI)], "lost or duplicated tasks"
+    return sink.order, worker.lane_stats()
+
+def run_test():
+    # priority set by the sender, no starvation protection
+    order, stats = run_pipe(True, lanes=2, starvation_limit=0)
+    positions = [k for k, t in enumerate(order) if t >= 1000]
+    assert max(positions) < NI + 10, f"interactive tasks waited behind bulk: {positions}"
+    bulk = [t for t in order if t < 1000]
+    assert bulk == sorted(bulk), "FIFO order violated within a lane"
+    assert stats[0]["count"] == NB and stats[1]["count"] == NI
+    assert stats[1]["p99_us"] < stats[0]["p99_us"]
+
+    # priority from a classifier, bulk served at least every 4th pick
+    order, stats = run_pipe(False, lanes=2, starvation_limit=3, classifier=lambda t: 1 if t >= 1000 else 0)
+    positions = [k for k, t in enumerate(order) if t >= 1000]
+    assert max(positions) < 2 * NI + 10, f"classifier ignored: {positions}"
+    head = order[:positions[-1] + 1]
+    assert sum(1 for t in head if t < 1000) >= NI // 3, "bulk lane starved"
+
+    # tasks reach the lanes through the runtime's pop: blocking mode wakes producers
+    check_order(*run_pipe(True, blocking=True, lanes=2, starvation_limit=0))
+
+    # multi-input nodes
+    check_order(*run_pipe(True, MiSoWorker, lanes=2, starvation_limit=0))
+    check_order(*run_pipe(True, MiMoWorker, lanes=2, starvation_limit=0))
+
+    collector, sink = MiSoWorker(), Sink()
+    collector.set_lanes(lanes=2, starvation_limit=0)
+    farm = ff.Farm().add_workers([Forward() for _ in range(2)]).add_collector(collector)
+    ff.Pipeline().add_stage(Source(True)).add_stage(farm).add_stage(sink).run_and_wait_end()
+    # two workers interleave the bulk lane
+    check_order(sink.order, collector.lane_stats(), fifo=False)
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
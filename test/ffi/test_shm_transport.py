@@ -0,0 +1,73 @@
+import fftvm as ff
+import tvm_ffi
+import numpy as np
+import multiprocessing as mp
+import os
+
+'''
+# Test: Shared-Memory Transport
+# Objective: Verify that tasks (scalars, strings, bytes and Tensors) cross a
+#            process boundary through ShmSink/ShmSource in order and intact,
+#            with a small arena forcing the producer to reuse released blocks.
+#
+# Graph (two processes):
+#  [child]  Source -> ShmSink  ==shm==>  ShmSource -> Sink  [parent]
+'''
+
+N = 64
+
+def make_tasks():
+    rng = np.random.default_rng(1)
+    tasks = [None, True, -7, 2.5, "short", "x" * 1000, b"\x00\x01", bytes(range(256)) * 4]
+    for i in range(N):
+        tasks.append(rng.standard_normal((8, 64)).astype(np.float32) + i)
+    return tasks
+
+class Source(ff.SiSoNode):
+    def svc(self, t):
+        for x in make_tasks():
+            self.ff_send_out(tvm_ffi.from_dlpack(x) if isinstance(x, np.ndarray) else x)
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.items = []
+        return 0
+    def svc(self, t):
+        # copy out: the view is released right after svc returns
+        self.items.append(np.from_dlpack(t).copy() if isinstance(t, tvm_ffi.Tensor) else t)
+        return ff.FFToken.GO_ON()
+
+def produce(name):
+    # 8 tensors of 2KB fit in the arena: the producer has to wait for releases
+    sink = ff.ShmSink(name, ring_slots=16, arena_size=16 << 10)
+    ff.Pipeline().add_stage(Source()).add_stage(sink).run_and_wait_end()
+    assert sink.stats()["tasks"] == N + 8
+    os._exit(0)
+
+def run_test():
+    name = f"fftvm_test_{os.getpid()}"
+    child = mp.get_context("fork").Process(target=produce, args=(name,))
+    child.start()
+
+    src = ff.ShmSource(name)
+    sink = Sink()
+    ff.Pipeline().add_stage(src).add_stage(sink).run_and_wait_end()
+    child.join()
+    assert child.exitcode == 0, "producer failed"
+
+    expected = make_tasks()
+    assert len(sink.items) == len(expected), f"task count mismatch: {len(sink.items)}"
+    for got, exp in zip(sink.items, expected):
+        if isinstance(exp, np.ndarray):
+            assert got.dtype == exp.dtype and np.array_equal(got, exp)
+        elif isinstance(exp, float):
+            assert got == exp
+        else:
+            assert got == exp and type(got) is type(exp), f"{got!r} != {exp!r}"
+    assert src.stats()["tasks"] == len(expected)
+    assert not os.path.exists("/dev/shm/" + name), "segment name not unlinked"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
@@ -0,0 +1,105 @@
+import fftvm as ff
+import threading
+import tvm_ffi
+
+'''
+# Test: Work-Stealing Farm
+# Objective: Verify that StealingFarm processes every task exactly once with a
+#            skewed workload and that idle workers steal from busy peers, also
+#            when the same graph runs a second time (workers must be woken up
+#            while the source is still running, not only at EOS), that expiry
+#            configured on a worker before it joined the farm is kept, and that
+#            workers with priority lanes are rejected.
+#
+# Graph:
+#  Source -> StealingFarm[ Seeder -> deque[0..3] <-steal-> Worker[0..3] ] -> Sink
+#    the source holds its EOS until the sink has seen every task (run twice)
+#
+#  Source -> StealingFarm[ Seeder -> Worker(expiry)[0..3] ] -> Sink
+#    even i: 1us deadline (expired on arrival), odd i: 10s deadline
+'''
+
+cpp_source = '''
+#include <tvm/ffi/any.h>
+tvm::ffi::Any skewed(tvm::ffi::Any input) {
+    int64_t v = input.cast<int64_t>();
+    // every 4th task lands on worker 0 with round-robin seeding and is 50x heavier
+    volatile int64_t i = 0;
+    int64_t cost = (v % 4 == 0) ? 50000 : 1000;
+    while (i < cost) i = i + 1;
+    return v;
+}
+'''
+
+N = 400
+
+class Source(ff.SiSoNode):
+    def __init__(self, drained=None, deadline_of=None):
+        super().__init__()
+        self.drained = drained
+        self.deadline_of = deadline_of
+    def svc_init(self):
+        self.before_eos = False
+        return 0
+    def svc(self, task):
+        for i in range(N):
+            if self.deadline_of:
+                self.ff_send_out_deadline(i, self.deadline_of(i))
+            else:
+                self.ff_send_out(i)
+        if self.drained:
+            self.before_eos = self.drained.wait(timeout=30)
+        return ff.FFToken.EOS()
+
+class Sink(ff.MiSoNode):
+    def __init__(self, drained=None, expected=N):
+        super().__init__()
+        self.drained = drained
+        self.expected = expected
+    def svc_init(self):
+        self.seen = []
+        return 0
+    def svc(self, task):
+        self.seen.append(task)
+        if self.drained and len(self.seen) == self.expected:
+            self.drained.set()
+        return ff.FFToken.GO_ON()
+
+def mixed_deadline(i):
+    return 1 if i % 2 == 0 else 10_000_000
+
+def run_test(native_mod):
+    drained = threading.Event()
+    source, sink = Source(drained), Sink(drained)
+    farm = ff.StealingFarm().add_workers([ff.SiSoNode(native_mod.skewed) for _ in range(4)])
+    wf = ff.Pipeline().add_stage(source).add_stage(farm).add_stage(sink)
+    for _ in range(2):
+        drained.clear()
+        wf.run_and_wait_end()
+
+        assert source.before_eos, "tasks were held back until EOS"
+        assert sorted(sink.seen) == list(range(N)), "tasks lost or duplicated"
+        stats = farm.stats()
+        assert stats["workers"] == 4
+        assert sum(stats["executed"]) == N, f"executed mismatch: {stats['executed']}"
+        assert sum(stats["stolen"]) > 0, "no worker ever stole a task"
+
+    sink = Sink()
+    workers = [ff.SiSoNode(native_mod.skewed).set_expiry("drop") for _ in range(4)]
+    farm = ff.StealingFarm().add_workers(workers)
+    ff.Pipeline().add_stage(Source(deadline_of=mixed_deadline)).add_stage(farm).add_stage(sink).run_and_wait_end()
+    assert sorted(sink.seen) == list(range(1, N, 2)), "expired tasks reached svc"
+    assert sum(w.expiry_stats()["dropped"] for w in workers) == N // 2
+
+    try:
+        ff.StealingFarm().add_workers([ff.SiSoNode(native_mod.skewed).set_lanes(2) for _ in range(2)])
+    except Exception as e:
+        assert "priority lanes" in str(e)
+    else:
+        assert False, "accepted workers with priority lanes"
+
+if __name__ == "__main__":
+    native_mod = tvm_ffi.cpp.load_inline(
+        name="stealing_farm", cpp_sources=cpp_source, functions=['skewed'])
+    run_test(native_mod)
+    run_test(native_mod)
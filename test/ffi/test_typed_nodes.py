@@ -0,0 +1,101 @@
+import fftvm as ff
+import os
+import tvm_ffi
+
+'''
+# Test: Typed C++ Nodes
+# Objective: Verify that stages declared with concrete task types (a user
+#            struct, int64_t) compile against libfftvm.hpp, run as typed
+#            FastFlow nodes inside a typed pipeline and farm, filter and
+#            update tasks in place, and that the result composes with FFI
+#            nodes through the Any boundary stages and through typed stages
+#            whose task type is Any itself.
+#
+# Graph:
+#  typed: Source<Point> -> Norm(Point -> int64) -> Farm[ Twice(in place) x4 ] -> Odd(filter) -> Sink
+#  mixed: Source<int64> -> to_any -> SiSoNode(Python, +1) -> from_any<int64> -> Sink
+#  any:   Source<Any> -> SiSoNode(Python, +1) -> Map<Any, int64> -> Sink
+'''
+
+N = 1000
+
+cpp_source = '''
+#include <libfftvm.hpp>
+
+struct Point { int64_t x, y; };
+static std::atomic<int64_t> g_total{0}, g_count{0};
+
+static auto counter(int64_t n) {
+    return [i = int64_t(0), n]() mutable -> std::optional<int64_t> {
+        if (i == n) return std::nullopt;
+        return i++;
+    };
+}
+
+static auto summing_sink() {
+    return typed::sink<int64_t>([](int64_t& v) { g_total += v; g_count++; });
+}
+
+tvm::ffi::Any typed_graph(int64_t n) {
+    g_total = g_count = 0;
+    auto source = typed::source<Point>([i = int64_t(0), n]() mutable -> std::optional<Point> {
+        if (i == n) return std::nullopt;
+        ++i;
+        return Point{i, 2 * i};
+    });
+    auto norm = typed::map<Point, int64_t>([](Point& p) { return p.x * p.x + p.y; });
+    std::vector<typed::Ref<int64_t, int64_t>> workers;
+    for (int k = 0; k < 4; ++k) workers.push_back(typed::map<int64_t, int64_t>([](int64_t& v) { v *= 2; }));
+    auto odd = typed::map<int64_t, int64_t>([](int64_t& v) -> std::optional<int64_t> {
+        if ((v / 2) % 2 == 0) return std::nullopt;
+        return v;
+    });
+    return typed::pipeline(source, norm, typed::farm(workers), odd, summing_sink()).node;
+}
+
+tvm::ffi::Any mixed_graph(int64_t n, tvm::ffi::Any middle) {
+    g_total = g_count = 0;
+    return typed::pipeline(typed::source<int64_t>(counter(n)), typed::to_any<int64_t>(),
+                           typed::dynamic(middle.cast<Node_ref>()), typed::from_any<int64_t>(),
+                           summing_sink()).node;
+}
+
+tvm::ffi::Any any_graph(int64_t n, tvm::ffi::Any middle) {
+    g_total = g_count = 0;
+    auto source = typed::source<tvm::ffi::Any>([next = counter(n)]() mutable -> std::optional<tvm::ffi::Any> {
+        if (auto i = next()) return tvm::ffi::Any(*i);
+        return std::nullopt;
+    });
+    auto to_int = typed::map<tvm::ffi::Any, int64_t>([](tvm::ffi::Any& t) { return t.cast<int64_t>(); });
+    return typed::pipeline(source, typed::dynamic(middle.cast<Node_ref>()), to_int, summing_sink()).node;
+}
+
+int64_t typed_total() { return g_total; }
+int64_t typed_count() { return g_count; }
+'''
+
+def run_test(native_mod):
+    native_mod.typed_graph(N).run_and_wait_end()
+    norms = [i * i + 2 * i for i in range(1, N + 1)]
+    odd = [2 * v for v in norms if v % 2 == 1]
+    assert native_mod.typed_count() == len(odd)
+    assert native_mod.typed_total() == sum(odd)
+
+    graph = native_mod.mixed_graph(N, ff.SiSoNode(lambda t: t + 1))
+    assert isinstance(graph, ff.Pipeline)
+    graph.run_and_wait_end()
+    assert native_mod.typed_count() == N
+    assert native_mod.typed_total() == sum(range(1, N + 1))
+
+    native_mod.any_graph(N, ff.SiSoNode(lambda t: t + 1)).run_and_wait_end()
+    assert native_mod.typed_count() == N
+    assert native_mod.typed_total() == sum(range(1, N + 1))
+
+if __name__ == "__main__":
+    native_mod = tvm_ffi.cpp.load_inline(
+        name="typed_nodes", cpp_sources=cpp_source,
+        functions=["typed_graph", "mixed_graph", "any_graph", "typed_total", "typed_count"],
+        extra_include_paths=[os.path.dirname(ff.__file__)],
+        extra_cflags=["-std=c++17", "-O2"])
+    run_test(native_mod)
+    run_test(native_mod)
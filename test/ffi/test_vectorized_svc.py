@@ -0,0 +1,94 @@
+import fftvm as ff
+import numpy as np
+
+'''
+# Test: Vectorized svc
+# Objective: Verify that a vectorized node receives scalar tasks as NumPy
+#            batches, that an array result is exploded back into tasks in
+#            order, that non-scalar tasks flush the batch and reach svc one
+#            at a time, and that a scalar result is sent as a single task.
+#            Expired tasks are dropped before batching, stamped tasks are
+#            recorded one by one, and each exploded result keeps its own
+#            task's metadata (here the Injector request its ticket waits on).
+#
+# Graph:
+#  Source(0..N-1, "mid", N..2N-1) -> Double(vectorized int64) -> Sink
+#  Source(0..N-1)                 -> Sum(vectorized float64)  -> Sink
+#  Deadlines(stamp, odd expired)  -> Double(vectorized, drop, record) -> Sink
+#  Injector(0..N-1)               -> Double(vectorized) -> Injector.results()
+'''
+
+N = 1000
+
+class Source(ff.SiSoNode):
+    def __init__(self, marker):
+        super().__init__()
+        self.marker = marker
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(i)
+        if self.marker:
+            self.ff_send_out("mid")
+            for i in range(N, 2 * N):
+                self.ff_send_out(i)
+        return ff.FFToken.EOS()
+
+class Deadlines(ff.SiSoNode):
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out_deadline(i, -1000 if i % 2 else 10_000_000)
+        return ff.FFToken.EOS()
+
+class Double(ff.SiSoNode):
+    def svc(self, xs):
+        if isinstance(xs, str):
+            return xs.upper()
+        assert isinstance(xs, np.ndarray) and xs.dtype == np.int64
+        return xs * 2
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, t):
+        self.got.append(t)
+        return ff.FFToken.GO_ON()
+
+def run_pipe(marker, worker, **vec):
+    sink = Sink()
+    worker.set_vectorized(**vec)
+    ff.Pipeline().add_stage(Source(marker)).add_stage(worker).add_stage(sink).run_and_wait_end()
+    return sink.got, worker.vector_stats()
+
+def run_test():
+    got, stats = run_pipe(True, Double(), max_batch=64)
+    assert got == [2 * i for i in range(N)] + ["MID"] + [2 * i for i in range(N, 2 * N)]
+    assert stats["items"] == 2 * N
+    assert 2 * N / 64 <= stats["batches"] < 2 * N, f"tasks were not batched: {stats}"
+
+    total = lambda xs: float(xs.sum())
+    got, stats = run_pipe(False, ff.SiSoNode(total), dtype="float64", fn=total)
+    assert len(got) == stats["batches"] and sum(got) == float(sum(range(N)))
+
+    source, worker, sink = Deadlines(), Double(), Sink()
+    source.set_latency(stamp=True)
+    worker.set_vectorized(max_batch=64)
+    worker.set_expiry("drop")
+    worker.set_latency(record=True)
+    ff.Pipeline().add_stage(source).add_stage(worker).add_stage(sink).run_and_wait_end()
+    assert sink.got == [2 * i for i in range(0, N, 2)]
+    assert worker.expiry_stats()["dropped"] == N // 2 and worker.vector_stats()["items"] == N // 2
+    assert worker.latency_stats()["count"] == N // 2
+
+    inj, worker = ff.Injector(), Double()
+    worker.set_vectorized(max_batch=64)
+    pipe = ff.Pipeline().add_stage(inj).add_stage(worker).add_stage(inj.results())
+    pipe.run()
+    tickets = [inj.submit(i) for i in range(N)]
+    inj.close()
+    pipe.wait()
+    assert [t.result(timeout=1) for t in tickets] == [2 * i for i in range(N)]
+
+if __name__ == "__main__":
+    run_test()
+    run_test()
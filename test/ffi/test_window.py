@@ -0,0 +1,94 @@
+import fftvm as ff
+import numpy as np
+import tvm_ffi
+
+'''
+# Test: Windowed Aggregation
+# Objective: Verify that the native Window node reduces tasks per key over
+#            tumbling and sliding count windows and event-time windows, with
+#            the built-in reductions, tensor sums and a custom reducer, that
+#            open windows are flushed at end of stream, that the node can be
+#            partitioned across a farm by key, and that bad configs are rejected.
+#
+# Graph:
+#  Source(0..N-1) -> Window -> Sink
+#  Source(0..N-1) -> Farm[ Emitter(key_hash) -> Window x4 -> collector ] -> Sink
+'''
+
+N = 600
+
+class Source(ff.SiSoNode):
+    def __init__(self, make=lambda i: i):
+        super().__init__()
+        self.make = make
+    def svc(self, t):
+        for i in range(N):
+            self.ff_send_out(self.make(i))
+        return ff.FFToken.EOS()
+
+class Sink(ff.SiSoNode):
+    def svc_init(self):
+        self.got = []
+        return 0
+    def svc(self, w):
+        self.got.append({k: w[k] for k in ("key", "start", "end", "count", "value")})
+        return ff.FFToken.GO_ON()
+
+def run(window, source=None):
+    sink = Sink()
+    ff.Pipeline().add_stage(source or Source()).add_stage(window).add_stage(sink).run_and_wait_end()
+    return sink.got
+
+def run_test():
+    # tumbling count windows per key
+    got = run(ff.Window(10, key=lambda t: t % 3, reduce="sum"))
+    assert len(got) == N // 10
+    for w in got:
+        items = [t for t in range(N) if t % 3 == w["key"]][w["start"]:w["end"]]
+        assert w["count"] == 10 and w["value"] == sum(items)
+
+    # sliding count windows, partial windows flushed at end of stream
+    got = run(ff.Window(4, slide=2, reduce="max"))
+    full = [w for w in got if w["count"] == 4]
+    assert [w["start"] for w in full] == list(range(0, N - 3, 2))
+    assert all(w["value"] == w["start"] + 3 for w in full)
+    assert [w["count"] for w in got if w["count"] < 4] == [2]
+
+    # event time: task i happens at 10*i ms
+    got = run(ff.Window(100, kind="time", time=lambda t: t * 10, reduce="mean"))
+    assert len(got) == N // 10 and all(w["count"] == 10 for w in got)
+    assert [w["value"] for w in got] == [i * 10 + 4.5 for i in range(N // 10)]
+    window = ff.Window(100, slide=50, kind="time", time=lambda t: t * 10)
+    got = run(window)
+    assert [w["start"] for w in got] == list(range(-50, N * 10, 50))
+    assert window.stats()["tasks"] == N and window.stats()["late"] == 0
+
+    # elementwise tensor sums and a custom reducer
+    tensors = Source(lambda i: tvm_ffi.from_dlpack(np.full(4, i, dtype=np.int32)))
+    got = run(ff.Window(N // 2, reduce="tensor_sum"), tensors)
+    assert [np.from_dlpack(w["value"]).tolist() for w in got] == \
+        [[float(sum(range(N // 2)))] * 4, [float(sum(range(N // 2, N)))] * 4]
+    got = run(ff.Window(N, reduce=lambda acc, v: (acc or 0) + v * v))
+    assert got[0]["value"] == sum(i * i for i in range(N))
+
+    # partitioned by key across a farm
+    key = lambda t: t % 7
+    emitter = ff.SiMoNode(lambda t: t)
+    emitter.set_routing("key_hash", fn=key)
+    farm = ff.Farm().add_emitter(emitter).add_workers([ff.Window(5, key=key, reduce="sum") for _ in range(4)]).add_collector(None)
+    got = run(farm)
+    expected = run(ff.Window(5, key=key, reduce="sum"))
+    as_set = lambda ws: sorted((w["key"], w["start"], w["value"]) for w in ws)
+    assert as_set(got) == as_set(expected)
+
+    for bad in (dict(kind="rows"), dict(reduce="median"), dict(reduce="custom"), dict(time=lambda t: t)):
+        try:
+            ff.Window(10, **bad)
+        except Exception as e:
+            assert "Window" in str(e)
+        else:
+            assert False, f"accepted {bad}"
+
+if __name__ == "__main__":
+    run_test()
+    run_test()